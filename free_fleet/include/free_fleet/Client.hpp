@@ -18,7 +18,11 @@
 #ifndef FREE_FLEET__INCLUDE__FREE_FLEET__CLIENT_HPP
 #define FREE_FLEET__INCLUDE__FREE_FLEET__CLIENT_HPP
 
+#include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
+#include <functional>
 
 #include <free_fleet/ClientConfig.hpp>
 
@@ -26,6 +30,7 @@
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 
 namespace free_fleet {
 
@@ -35,6 +40,22 @@ public:
 
   using SharedPtr = std::shared_ptr<Client>;
 
+  /// Callbacks are handed every request that arrived together, in order of
+  /// arrival, like read_mode_requests, so that only the newest one targetted
+  /// towards the robot needs to be acted on.
+  using ModeRequestCallback =
+      std::function<void(
+          const std::vector<messages::ModeRequest>& mode_requests)>;
+
+  using PathRequestCallback =
+      std::function<void(
+          const std::vector<messages::PathRequest>& path_requests)>;
+
+  using DestinationRequestCallback =
+      std::function<void(
+          const std::vector<messages::DestinationRequest>&
+              destination_requests)>;
+
   /// Factory function that creates an instance of the Free Fleet DDS Client.
   ///
   /// \param[in] config
@@ -44,13 +65,15 @@ public:
   static SharedPtr make(const ClientConfig& config);
 
   /// Attempts to send a new robot state to the free fleet server, to be 
-  /// registered by the fleet management system.
+  /// registered by the fleet management system. When states are published
+  /// adaptively, states that barely changed since the last one sent are
+  /// skipped, see ClientConfig::adaptive_state_publishing.
   ///
   /// \param[in] new_robot_state
   ///   Current robot state to be sent to the free fleet server to update the
   ///   fleet management system.
   /// \return
-  ///   True if robot state was successfully sent, false otherwise.
+  ///   True if robot state was successfully sent or skipped, false otherwise.
   bool send_robot_state(const messages::RobotState& new_robot_state);
 
   /// Attempts to read and receive a new mode request from the free fleet
@@ -84,6 +107,94 @@ public:
   bool read_destination_request(
       messages::DestinationRequest& destination_request);
 
+  /// Takes every mode request received from the free fleet server since the
+  /// last read, so that a robot client polling for requests can act on the
+  /// newest one targetted towards it and drop those it superseded.
+  ///
+  /// \param[out] mode_requests
+  ///   Newly received mode requests, in order of arrival.
+  /// \return
+  ///   Number of mode requests received.
+  std::size_t read_mode_requests(
+      std::vector<messages::ModeRequest>& mode_requests);
+
+  /// Takes every path request received from the free fleet server since the
+  /// last read, see read_mode_requests.
+  ///
+  /// \param[out] path_requests
+  ///   Newly received path requests, in order of arrival.
+  /// \return
+  ///   Number of path requests received.
+  std::size_t read_path_requests(
+      std::vector<messages::PathRequest>& path_requests);
+
+  /// Takes every destination request received from the free fleet server
+  /// since the last read, see read_mode_requests.
+  ///
+  /// \param[out] destination_requests
+  ///   Newly received destination requests, in order of arrival.
+  /// \return
+  ///   Number of destination requests received.
+  std::size_t read_destination_requests(
+      std::vector<messages::DestinationRequest>& destination_requests);
+
+  /// Registers a callback that is triggered as soon as new mode requests
+  /// arrive over DDS. The callback is called from a thread of the client
+  /// that only waits for mode requests, so that stopping or pausing a robot
+  /// is never queued behind other requests handled by the DDS listeners.
+  /// Mode requests handled by it will no longer be returned by
+  /// read_mode_request.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with the mode requests that arrived together.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool set_mode_request_callback(ModeRequestCallback callback);
+
+  /// Registers a callback that is triggered as soon as new path requests
+  /// arrive over DDS. The callback is called from a DDS listener thread, and
+  /// path requests handled by it will no longer be returned by
+  /// read_path_request.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with the path requests that arrived together.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool set_path_request_callback(PathRequestCallback callback);
+
+  /// Registers a callback that is triggered as soon as new destination
+  /// requests arrive over DDS. The callback is called from a DDS listener
+  /// thread, and destination requests handled by it will no longer be
+  /// returned by read_destination_request.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with the destination requests that arrived
+  ///   together.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool set_destination_request_callback(DestinationRequestCallback callback);
+
+  /// Attempts to send an acknowledgement back to the free fleet server, as
+  /// soon as a request targetted towards this robot has been accepted or
+  /// rejected. Requests that are received again with the same task id, for
+  /// example when the server retries, should be acknowledged again.
+  ///
+  /// \param[in] request_ack
+  ///   Acknowledgement of the request, identified by its type and task id.
+  /// \return
+  ///   True if the acknowledgement was successfully sent, false otherwise.
+  bool send_request_ack(const messages::RequestAck& request_ack);
+
+  /// Gets the id the server gave to a name, to compare names in requests by
+  /// their ids, see messages/NameId.hpp. Level names the server gave ids to
+  /// are sent as ids only in robot states.
+  ///
+  /// \param[in] name
+  ///   Name to get the id of.
+  /// \return
+  ///   Id of the name, 0 if the server did not give it an id yet.
+  uint32_t get_name_id(const std::string& name);
+
   /// Destructor
   ~Client();
 
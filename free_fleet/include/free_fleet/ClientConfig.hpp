@@ -20,15 +20,68 @@
 
 #include <string>
 
+#include <free_fleet/QoSProfile.hpp>
+
 namespace free_fleet {
 
 struct ClientConfig
 {
   int dds_domain = 42;
+
+  // Exchange samples with peers on the same host over the shared memory of
+  // iceoryx instead of UDP loopback. Needs CycloneDDS 0.9 or newer built
+  // with shared memory support and a running iox-roudi, older releases
+  // ignore it with an error. Peers on other hosts, and readers or writers
+  // whose QoS is not supported over shared memory, keep using the network.
+  bool dds_shared_memory = false;
+
+  // Send robot states as fixed size samples, which are serialized without
+  // allocations and loaned from the writer when the transport supports it.
+  // Names are cut to 63 characters, level names to 31 and paths to 64
+  // waypoints. Every sample carries all 64 waypoints, about 3.3 kB, however
+  // short the path is, so this trades bandwidth for fewer allocations. The
+  // server and all of its clients need to agree on this.
+  bool dds_bounded_robot_state = false;
+
+  // Send the paths of robot states compactly, with positions rounded to
+  // millimeters, yaws to milliradians and times to milliseconds. The server
+  // always decodes compact paths, so this only needs to be set here.
+  bool dds_compact_path = false;
+
+  // Only send the robot states given to send_robot_state that changed
+  // significantly since the last state sent, see RobotStateFilter. States
+  // are still sent every state_heartbeat_period seconds while unchanged, and
+  // not sooner than state_min_period seconds after the previous one, so robot
+  // states need to be given at least that often. States given up to a quarter
+  // of state_min_period early are still sent, to allow for a jittering timer.
+  // Thresholds are in meters, radians and battery percent.
+  bool adaptive_state_publishing = false;
+  double state_heartbeat_period = 1.0;
+  double state_min_period = 0.1;
+  double state_position_threshold = 0.1;
+  double state_yaw_threshold = 0.1;
+  double state_battery_threshold = 1.0;
+
   std::string dds_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_request_ack_topic = "request_ack";
+
+  // Level, fleet and robot names are sent as ids, which the server gives out
+  // and publishes on this topic. Off when empty, which sends names as strings
+  // only. Every server on the same DDS domain needs a topic of its own, and
+  // its clients need to use the same one, as ids of other servers cannot be
+  // told apart from those of their own.
+  std::string dds_name_id_topic = "";
+
+  // These need to be compatible with the profiles used by the server.
+  QoSProfile dds_state_qos = QoSProfile::state_stream();
+  QoSProfile dds_mode_request_qos = QoSProfile::command_urgent();
+  QoSProfile dds_path_request_qos = QoSProfile::command_reliable();
+  QoSProfile dds_destination_request_qos = QoSProfile::command_reliable();
+  QoSProfile dds_request_ack_qos = QoSProfile::command_reliable();
+  QoSProfile dds_name_id_qos = QoSProfile::name_table();
 
   void print_config() const;
 };
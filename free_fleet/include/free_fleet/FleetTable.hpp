@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__FLEETTABLE_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__FLEETTABLE_HPP
+
+#include <mutex>
+#include <queue>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include <free_fleet/messages/Location.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+namespace free_fleet {
+
+/// Dense table of the latest state of every robot in a fleet. Robots are
+/// interned into ids on their first update, which index every array of the
+/// table for as long as the robot stays in it. The fields that change with
+/// every update, being the pose, mode, battery and timestamp, are kept in
+/// one array per field behind a sequence lock for every robot, while the
+/// fields that rarely change are kept in immutable details that are only
+/// replaced when they change. Readers of the per-update fields never block
+/// writers, they retry a robot instead if it was updated while being read.
+/// The details and the ids are shared pointers swapped with std::atomic_load
+/// and std::atomic_store, which are not lock-free on common standard
+/// libraries such as libstdc++, where they take one of a few global mutexes
+/// for as long as it takes to copy the pointer. Reading details or looking
+/// up a robot can therefore briefly wait on a writer replacing them.
+///
+/// Robots that stop sending updates are first marked as stale, and later
+/// evicted, freeing their id for new robots. Robots waiting to expire are
+/// kept in a heap ordered by when they are due, so that expiring them only
+/// costs as much as the robots that are actually due.
+class FleetTable
+{
+public:
+
+  /// Fields of a robot that rarely change between updates.
+  struct Details
+  {
+    std::string name;
+    std::string model;
+    std::string task_id;
+    std::string level_name;
+    std::vector<messages::Location> path;
+  };
+
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  /// Consistent copy of every robot in the table, with one array per field,
+  /// where index i of every array belongs to the same robot. Reading into
+  /// the same snapshot again reuses its capacity.
+  struct Snapshot
+  {
+    std::vector<std::size_t> id;
+    std::vector<int32_t> sec;
+    std::vector<uint32_t> nanosec;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> yaw;
+    std::vector<uint32_t> mode;
+    std::vector<float> battery_percent;
+
+    /// Number of times each robot has been updated, readers can compare it
+    /// to a previous snapshot to find the robots that changed.
+    std::vector<uint64_t> version;
+
+    /// Whether each robot has not been updated within the stale timeout,
+    /// 1 if stale, 0 otherwise.
+    std::vector<uint8_t> stale;
+
+    std::vector<TimePoint> last_seen;
+
+    std::vector<std::shared_ptr<const Details>> details;
+
+    std::size_t size() const;
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] capacity
+  ///   Maximum number of robots in the table, all of the storage is
+  ///   allocated upfront so that readers never see it move.
+  /// \param[in] stale_timeout
+  ///   Seconds without updates after which a robot is marked as stale, not
+  ///   positive to never mark robots as stale.
+  /// \param[in] evict_timeout
+  ///   Seconds without updates after which a robot is removed from the
+  ///   table, not positive to never remove robots.
+  explicit FleetTable(
+      std::size_t capacity,
+      double stale_timeout = 0.0,
+      double evict_timeout = 0.0);
+
+  /// Destructor
+  ~FleetTable();
+
+  FleetTable(const FleetTable&) = delete;
+  FleetTable& operator=(const FleetTable&) = delete;
+
+  /// Maximum number of robots in the table.
+  std::size_t capacity() const;
+
+  /// Number of robots in the table.
+  std::size_t size() const;
+
+  /// Updates the state of a robot, adding it to the table if it is not in
+  /// it yet, and marking it as seen now. Concurrent updates are serialized
+  /// with each other, but never wait for readers.
+  ///
+  /// \param[in] robot_state
+  ///   New state of the robot.
+  /// \param[out] id
+  ///   Id of the robot, which stays the same until the robot is evicted.
+  /// \param[out] is_new
+  ///   Set to whether the robot was added to the table by this update, left
+  ///   out if null. Ids of evicted robots are given out again, so they do
+  ///   not tell new robots apart.
+  /// \return
+  ///   True if the robot was updated, false if it is new but the table is
+  ///   already full.
+  bool update(
+      const messages::RobotState& robot_state,
+      std::size_t& id,
+      bool* is_new = nullptr);
+
+  /// Updates the state of a robot as seen at the given time.
+  ///
+  /// \param[in] robot_state
+  ///   New state of the robot.
+  /// \param[in] now
+  ///   Time at which the robot state was received.
+  /// \param[out] id
+  ///   Id of the robot, which stays the same until the robot is evicted.
+  /// \param[out] is_new
+  ///   Set to whether the robot was added to the table by this update, left
+  ///   out if null.
+  /// \return
+  ///   True if the robot was updated, false if it is new but the table is
+  ///   already full.
+  bool update(
+      const messages::RobotState& robot_state,
+      TimePoint now,
+      std::size_t& id,
+      bool* is_new = nullptr);
+
+  /// Marks the robots that were not updated within the stale timeout as
+  /// stale, and evicts the robots that were not updated within the evict
+  /// timeout. Only the robots that are due are looked at.
+  ///
+  /// \param[in] now
+  ///   Current time.
+  /// \param[out] stale_robots
+  ///   Names of the robots that became stale, appended to.
+  /// \param[out] evicted_robots
+  ///   Names of the robots that were evicted, appended to.
+  void expire(
+      TimePoint now,
+      std::vector<std::string>& stale_robots,
+      std::vector<std::string>& evicted_robots);
+
+  /// Gets the id of a robot.
+  ///
+  /// \param[in] robot_name
+  ///   Name of the robot.
+  /// \param[out] id
+  ///   Id of the robot, untouched if the robot is not in the table.
+  /// \return
+  ///   True if the robot is in the table, false otherwise.
+  bool find(const std::string& robot_name, std::size_t& id) const;
+
+  /// Whether a robot has not been updated within the stale timeout.
+  ///
+  /// \param[in] id
+  ///   Id of the robot.
+  /// \return
+  ///   True if the robot is stale, false if it is not, or not in the table.
+  bool is_stale(std::size_t id) const;
+
+  /// Reads the latest state of a single robot.
+  ///
+  /// \param[in] id
+  ///   Id of the robot.
+  /// \param[out] robot_state
+  ///   Latest state of the robot.
+  /// \return
+  ///   True if the id belongs to a robot in the table, false otherwise.
+  bool read(std::size_t id, messages::RobotState& robot_state) const;
+
+  /// Reads the latest state of every robot in the table.
+  ///
+  /// \param[out] snapshot
+  ///   Snapshot resized and filled with every robot in the table.
+  void read_all(Snapshot& snapshot) const;
+
+  /// Gets the number of updates of new robots that were ignored because the
+  /// table was already full.
+  ///
+  /// \return
+  ///   Total number of ignored updates since the table was created.
+  uint64_t get_rejected_count() const;
+
+private:
+
+  using IdMap = std::unordered_map<std::string, std::size_t>;
+
+  enum SlotState : uint8_t
+  {
+    Empty = 0,
+    Live = 1,
+    Stale = 2
+  };
+
+  /// Every field of a single robot, read together.
+  struct Entry
+  {
+    uint8_t state;
+    int64_t last_seen;
+    uint64_t version;
+    int32_t sec;
+    uint32_t nanosec;
+    float x;
+    float y;
+    float yaw;
+    uint32_t mode;
+    float battery_percent;
+    std::shared_ptr<const Details> details;
+  };
+
+  /// Reads every field of a single robot, retrying until they were not
+  /// updated while being read.
+  void read_robot(std::size_t id, Entry& entry) const;
+
+  /// Robot due to be checked for expiry, entries of robots that were
+  /// evicted, or seen again after becoming stale, are left behind with an
+  /// older generation and skipped.
+  struct Expiry
+  {
+    int64_t deadline;
+    std::size_t id;
+    uint64_t generation;
+
+    bool operator>(const Expiry& other) const
+    {
+      return deadline > other.deadline;
+    }
+  };
+
+  /// Starts a new expiry for a robot, superseding any earlier one.
+  void schedule_expiry(std::size_t id, int64_t last_seen);
+
+  /// Changes the state of a robot under its sequence lock.
+  void set_slot_state(std::size_t id, SlotState state);
+
+  std::size_t table_capacity;
+
+  int64_t stale_timeout_ns;
+
+  int64_t evict_timeout_ns;
+
+  /// Number of slots that were ever used, including evicted ones.
+  std::atomic<std::size_t> num_slots;
+
+  std::atomic<std::size_t> num_robots;
+
+  /// Serializes writers with each other, never taken by readers.
+  std::mutex write_mutex;
+
+  /// Replaced as a whole whenever a robot is added or evicted, through the
+  /// std::atomic_store overload for shared pointers.
+  std::shared_ptr<const IdMap> ids;
+
+  // Only used by writers, under the write mutex.
+  std::vector<std::size_t> free_ids;
+  std::vector<uint64_t> expiry_generations;
+  std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>>
+      expiries;
+
+  std::unique_ptr<std::atomic<uint32_t>[]> sequences;
+  std::unique_ptr<std::atomic<uint8_t>[]> slot_states;
+  std::unique_ptr<std::atomic<int64_t>[]> last_seens;
+  std::unique_ptr<std::atomic<uint64_t>[]> versions;
+  std::unique_ptr<std::atomic<int32_t>[]> secs;
+  std::unique_ptr<std::atomic<uint32_t>[]> nanosecs;
+  std::unique_ptr<std::atomic<float>[]> xs;
+  std::unique_ptr<std::atomic<float>[]> ys;
+  std::unique_ptr<std::atomic<float>[]> yaws;
+  std::unique_ptr<std::atomic<uint32_t>[]> modes;
+  std::unique_ptr<std::atomic<float>[]> battery_percents;
+  std::unique_ptr<std::shared_ptr<const Details>[]> details;
+
+  std::atomic<uint64_t> rejected_count;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__FLEETTABLE_HPP
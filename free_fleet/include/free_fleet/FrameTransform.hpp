@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
+
+#include <cstddef>
+
+namespace free_fleet {
+
+/// Transformation between the frame of RMF and the frame of a fleet, with
+/// both directions precomputed into a single affine transformation. From
+/// the frame of RMF to the frame of the fleet, the order of operations is:
+/// 1) scale
+/// 2) rotate
+/// 3) translate
+///
+/// Poses are transformed in place, given as separate contiguous arrays of
+/// x, y and yaw, so that whole fleets and paths are transformed in a single
+/// pass that the compiler can vectorize.
+class FrameTransform
+{
+public:
+
+  /// Constructor, the identity transformation.
+  FrameTransform();
+
+  /// Constructor
+  ///
+  /// \param[in] scale
+  ///   Scale from the frame of RMF to the frame of the fleet.
+  /// \param[in] rotation
+  ///   Rotation in radians from the frame of RMF to the frame of the fleet.
+  /// \param[in] translation_x
+  ///   Translation along x in meters, in the frame of the fleet.
+  /// \param[in] translation_y
+  ///   Translation along y in meters, in the frame of the fleet.
+  FrameTransform(
+      double scale,
+      double rotation,
+      double translation_x,
+      double translation_y);
+
+  /// Transforms poses from the frame of the fleet to the frame of RMF.
+  ///
+  /// \param[in] size
+  ///   Number of poses.
+  /// \param[in,out] x
+  ///   Array of size x coordinates.
+  /// \param[in,out] y
+  ///   Array of size y coordinates.
+  /// \param[in,out] yaw
+  ///   Array of size yaws in radians.
+  void fleet_to_rmf(std::size_t size, float* x, float* y, float* yaw) const;
+
+  /// Transforms poses from the frame of RMF to the frame of the fleet.
+  ///
+  /// \param[in] size
+  ///   Number of poses.
+  /// \param[in,out] x
+  ///   Array of size x coordinates.
+  /// \param[in,out] y
+  ///   Array of size y coordinates.
+  /// \param[in,out] yaw
+  ///   Array of size yaws in radians.
+  void rmf_to_fleet(std::size_t size, float* x, float* y, float* yaw) const;
+
+private:
+
+  /// x' = a * x - b * y + c, y' = b * x + a * y + d, yaw' = yaw + e
+  struct Affine
+  {
+    float a;
+    float b;
+    float c;
+    float d;
+    float e;
+  };
+
+  static void apply(
+      const Affine& affine, std::size_t size, float* x, float* y, float* yaw);
+
+  Affine to_rmf;
+
+  Affine to_fleet;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__FRAMETRANSFORM_HPP
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__QOSPROFILE_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__QOSPROFILE_HPP
+
+#include <string>
+
+namespace free_fleet {
+
+/// Quality of service applied to both the readers and writers of a single
+/// topic. The server and clients need compatible profiles on every topic for
+/// them to be matched, most importantly a reliable reader will never be
+/// matched with a best effort writer.
+struct QoSProfile
+{
+  enum class Reliability
+  {
+    BestEffort,
+    Reliable
+  };
+
+  enum class Durability
+  {
+    Volatile,
+    TransientLocal
+  };
+
+  Reliability reliability = Reliability::BestEffort;
+
+  // number of samples kept for every instance, if not positive all samples
+  // are kept until they are read
+  int history_depth = 1;
+
+  Durability durability = Durability::Volatile;
+
+  // period in seconds within which every instance is expected to be updated,
+  // not positive means no deadline
+  double deadline = 0.0;
+
+  // acceptable delay in seconds between writing and receiving a sample, used
+  // as a hint for batching, not positive means as fast as possible
+  double latency_budget = 0.0;
+
+  int transport_priority = 0;
+
+  // resource limits, not positive means unlimited, samples arriving while a
+  // limit is reached are rejected
+  int max_samples = 0;
+  int max_instances = 0;
+  int max_samples_per_instance = 0;
+
+  /// Preset for high rate state traffic, where only the newest sample of
+  /// every instance matters and a lost sample will soon be replaced by the
+  /// next one. Best effort, keeping the last sample of every instance.
+  static QoSProfile state_stream();
+
+  /// Preset for commands that must not be lost, even on lossy networks.
+  /// Reliable, keeping the last 10 samples so that bursts of commands are
+  /// not collapsed, at a higher transport priority than state traffic.
+  static QoSProfile command_reliable();
+
+  /// Preset for commands that have to take effect right away, like stopping
+  /// a robot. Reliable like command_reliable, at a transport priority above
+  /// every other command.
+  static QoSProfile command_urgent();
+
+  /// Preset for tables that are written once and read by everyone, including
+  /// readers that join later. Reliable and transient local, keeping the last
+  /// sample of every instance.
+  static QoSProfile name_table();
+
+  /// Gets a preset by its name, either "state_stream", "command_reliable",
+  /// "command_urgent" or "name_table".
+  ///
+  /// \param[in] name
+  ///   Name of the preset.
+  /// \param[out] profile
+  ///   Preset profile, untouched if the name is not known.
+  /// \return
+  ///   True if the name is a known preset, false otherwise.
+  static bool from_preset(const std::string& name, QoSProfile& profile);
+
+  std::string to_string() const;
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__QOSPROFILE_HPP
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEFILTER_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEFILTER_HPP
+
+#include <chrono>
+
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+namespace free_fleet {
+
+/// Decides which of the robot states a client is given are worth sending.
+/// A state is sent when it changed significantly since the last state sent,
+/// which is when the robot moved or turned further than the thresholds, its
+/// battery changed by more than the threshold, or its mode, task or path
+/// changed. Unchanged states are still sent as heartbeats, so that the
+/// server does not consider the robot gone, and states are never sent more
+/// often than the rate cap allows. Changes held back by the rate cap are
+/// sent with the first state given once it has passed.
+class RobotStateFilter
+{
+public:
+
+  using Clock = std::chrono::steady_clock;
+
+  /// Constructor
+  ///
+  /// \param[in] config
+  ///   Configuration of the client, of which the state_* thresholds and
+  ///   periods are used.
+  RobotStateFilter(const ClientConfig& config);
+
+  /// Checks whether a robot state should be sent, remembering it as the last
+  /// state sent if it should.
+  ///
+  /// \param[in] robot_state
+  ///   Current state of the robot.
+  /// \param[in] now
+  ///   Time the state is being sent at.
+  /// \return
+  ///   True if the state should be sent.
+  bool should_send(
+      const messages::RobotState& robot_state, Clock::time_point now);
+
+private:
+
+  bool has_changed(const messages::RobotState& robot_state) const;
+
+  Clock::duration heartbeat_period;
+
+  Clock::duration min_period;
+
+  // States are given at the rate cap by a timer that jitters, so one that
+  // comes in up to a quarter of a period early is still sent, rather than
+  // held back for a whole period.
+  Clock::duration min_gap;
+
+  double position_threshold;
+
+  double yaw_threshold;
+
+  double battery_threshold;
+
+  bool has_sent = false;
+
+  Clock::time_point last_sent_time;
+
+  messages::RobotState last_sent_state;
+
+};
+
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__ROBOTSTATEFILTER_HPP
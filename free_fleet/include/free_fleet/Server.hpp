@@ -18,8 +18,13 @@
 #ifndef FREE_FLEET__INCLUDE__FREE_FLEET__SERVER_HPP
 #define FREE_FLEET__INCLUDE__FREE_FLEET__SERVER_HPP
 
+#include <string>
+#include <future>
 #include <memory>
 #include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
 
 #include <free_fleet/ServerConfig.hpp>
 
@@ -27,6 +32,7 @@
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 
 namespace free_fleet {
 
@@ -36,7 +42,110 @@ public:
 
   using SharedPtr = std::shared_ptr<Server>;
 
-  /// Factory function that creates an instance of the Free Fleet Server.
+  using RobotStateCallback =
+      std::function<void(const messages::RobotState& robot_state)>;
+
+  /// Caller owned storage of robot states, updated in place by
+  /// read_robot_states. Every robot keeps the index it was first read at for
+  /// as long as the arena lives, and updates reuse the capacity of its
+  /// strings and path, so reading into the same arena every tick stops
+  /// allocating once every robot has been seen.
+  class RobotStateArena
+  {
+  public:
+
+    /// Number of robots read into this arena so far.
+    std::size_t size() const;
+
+    /// Latest robot state of the robot at the given index.
+    const messages::RobotState& operator[](std::size_t index) const;
+
+    /// Gets the index of a robot.
+    ///
+    /// \param[in] robot_name
+    ///   Name of the robot.
+    /// \return
+    ///   Index of the robot, or size() if it was never read.
+    std::size_t find(const std::string& robot_name) const;
+
+    /// Gets the robot state of a robot to be updated in place, adding it if
+    /// it was never read before.
+    ///
+    /// \param[in] robot_name
+    ///   Name of the robot.
+    /// \param[out] index
+    ///   Index of the robot.
+    /// \return
+    ///   Robot state to be updated.
+    messages::RobotState& update(const char* robot_name, std::size_t& index);
+
+  private:
+
+    std::vector<messages::RobotState> robot_states;
+
+    std::unordered_map<std::string, std::size_t> indices;
+
+    /// Reused for looking up robot names without allocating.
+    std::string lookup_name;
+
+  };
+
+  /// Policy for sending a request again until it is acknowledged by the
+  /// client it is targetted towards.
+  struct RetryPolicy
+  {
+    /// Seconds to wait for an acknowledgement before sending again.
+    double timeout = 1.0;
+
+    /// Total number of times the request is sent before giving up.
+    uint32_t max_attempts = 3;
+
+    /// Seconds after sending a request to a robot during which the next
+    /// request of the same type to that robot is held back. Only the newest
+    /// request held back is sent once the window has passed, the others are
+    /// cancelled without ever being sent. Zero sends every request right
+    /// away.
+    double coalesce_window = 0.0;
+  };
+
+  /// Outcome of a request sent with a retry policy.
+  struct RequestResult
+  {
+    enum class Status
+    {
+      /// The client acknowledged and accepted the request.
+      Accepted,
+
+      /// The client acknowledged but rejected the request.
+      Rejected,
+
+      /// No acknowledgement arrived after all attempts.
+      TimedOut,
+
+      /// The request was superseded by another with the same task id or by
+      /// a newer request of the same type to the same robot, where path and
+      /// destination requests supersede each other, or the server shut down
+      /// before it was acknowledged.
+      Cancelled
+    };
+
+    Status status;
+
+    /// Reason given by the client, or why the request did not complete.
+    std::string reason;
+
+    /// Number of times the request was sent.
+    uint32_t attempts;
+
+    /// Seconds between the request first being sent and its completion.
+    double latency;
+  };
+
+  using RequestResultCallback =
+      std::function<void(const RequestResult& request_result)>;
+
+  /// Factory function that creates an instance of the Free Fleet Server,
+  /// serving every fleet in the configuration over a single DDS participant.
   ///
   /// \param[in] config
   ///   Configuration that sets up the server to communicate with the clients.
@@ -45,7 +154,8 @@ public:
   static SharedPtr make(const ServerConfig& config);
 
   /// Attempts to read new incoming robot states sent by free fleet clients
-  /// over DDS.
+  /// of every fleet over DDS. Only the newest robot state of each robot since
+  /// the last read is returned.
   ///
   /// \param[out] new_robot_states
   ///   A vector of new incoming robot states sent by clients to update the
@@ -54,6 +164,111 @@ public:
   ///   True if new robot states were received, false otherwise.
   bool read_robot_states(std::vector<messages::RobotState>& new_robot_states);
 
+  /// Attempts to read new incoming robot states sent by free fleet clients
+  /// of every fleet over DDS, updating them in place in a caller owned
+  /// arena. Only the newest robot state of each robot since the last read is
+  /// kept.
+  ///
+  /// \param[in,out] arena
+  ///   Robot states of all the robots read so far, updated with the new
+  ///   incoming robot states.
+  /// \param[out] updated_indices
+  ///   Indices into the arena of the robots that were updated by this read,
+  ///   in ascending order and without duplicates.
+  /// \return
+  ///   True if new robot states were received, false otherwise.
+  bool read_robot_states(
+      RobotStateArena& arena, std::vector<std::size_t>& updated_indices);
+
+  /// Attempts to read new incoming robot states sent by the free fleet
+  /// clients of a single fleet over DDS, updating them in place in a caller
+  /// owned arena.
+  ///
+  /// \param[in] fleet_name
+  ///   Name of the fleet, as given in ServerConfig::fleets.
+  /// \param[in,out] arena
+  ///   Robot states of all the robots of the fleet read so far, updated with
+  ///   the new incoming robot states.
+  /// \param[out] updated_indices
+  ///   Indices into the arena of the robots that were updated by this read,
+  ///   in ascending order and without duplicates.
+  /// \return
+  ///   True if new robot states were received, false if none were or the
+  ///   fleet is not served.
+  bool read_robot_states(
+      const std::string& fleet_name,
+      RobotStateArena& arena,
+      std::vector<std::size_t>& updated_indices);
+
+  /// Registers a callback that is triggered as soon as a new robot state
+  /// of any fleet arrives over DDS, instead of waiting for read_robot_states
+  /// to be polled. The callback is called from a DDS listener thread, and
+  /// robot states handled by it will no longer be returned by
+  /// read_robot_states.
+  ///
+  /// \param[in] callback
+  ///   Function to be called with every new incoming robot state.
+  /// \return
+  ///   True if the callback was successfully registered, false otherwise.
+  bool set_robot_state_callback(RobotStateCallback callback);
+
+  /// Registers a callback that is triggered as soon as a new robot state of
+  /// a single fleet arrives over DDS.
+  ///
+  /// \param[in] fleet_name
+  ///   Name of the fleet, as given in ServerConfig::fleets.
+  /// \param[in] callback
+  ///   Function to be called with every new incoming robot state of the
+  ///   fleet.
+  /// \return
+  ///   True if the callback was successfully registered, false if it could
+  ///   not be or the fleet is not served.
+  bool set_robot_state_callback(
+      const std::string& fleet_name, RobotStateCallback callback);
+
+  /// Stops triggering the callback registered for a single fleet, blocking
+  /// until a call in progress has returned. Whoever registered a callback
+  /// on a server that outlives them has to clear it before going away.
+  ///
+  /// \param[in] fleet_name
+  ///   Name of the fleet, as given in ServerConfig::fleets.
+  void clear_robot_state_callback(const std::string& fleet_name);
+
+  /// Blocks until new robot states of a single fleet are waiting to be read,
+  /// so that a thread of its own can read them with read_robot_states as soon
+  /// as they arrive, instead of handling them on a DDS listener thread that
+  /// is shared with every other reader. Not to be combined with
+  /// set_robot_state_callback for the same fleet.
+  ///
+  /// \param[in] fleet_name
+  ///   Name of the fleet, as given in ServerConfig::fleets.
+  /// \param[in] timeout
+  ///   Maximum number of seconds to wait.
+  /// \return
+  ///   True if new robot states are waiting, false if the timeout passed
+  ///   first or the fleet is not served.
+  bool wait_for_robot_states(const std::string& fleet_name, double timeout);
+
+  /// Gets the number of robot states that were sent by clients but never
+  /// read, either lost over the network or dropped because more robots than
+  /// the maximum number of samples in dds_robot_state_qos were waiting to be
+  /// read. States replaced by a newer state of the same robot are not
+  /// counted.
+  ///
+  /// \return
+  ///   Total number of dropped robot states since the server started.
+  uint64_t get_dropped_robot_state_count();
+
+  /// Gets the number of robot states of a single fleet that were sent by
+  /// clients but never read.
+  ///
+  /// \param[in] fleet_name
+  ///   Name of the fleet, as given in ServerConfig::fleets.
+  /// \return
+  ///   Total number of dropped robot states of the fleet since the server
+  ///   started, 0 if the fleet is not served.
+  uint64_t get_dropped_robot_state_count(const std::string& fleet_name);
+
   /// Attempts to send a new mode request to all the clients. Clients are in
   /// charge to identify if requests are targetted towards them.
   /// 
@@ -82,6 +297,60 @@ public:
   bool send_destination_request(
       const messages::DestinationRequest& destination_request);
 
+  /// Sends a new mode request to all the clients, and keeps sending it
+  /// according to the retry policy until the targetted client acknowledges
+  /// it, or all attempts have been used up.
+  ///
+  /// \param[in] mode_request
+  ///   New mode request to be sent out to the clients.
+  /// \param[in] retry_policy
+  ///   How long to wait for an acknowledgement and how often to try.
+  /// \param[in] callback
+  ///   Optional function to be called once the request has completed, from
+  ///   either a DDS listener thread or the retry thread of the server.
+  /// \return
+  ///   Future that is ready once the request has completed.
+  std::future<RequestResult> send_mode_request(
+      const messages::ModeRequest& mode_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback = nullptr);
+
+  /// Sends a new path request to all the clients, and keeps sending it
+  /// according to the retry policy until the targetted client acknowledges
+  /// it, or all attempts have been used up.
+  ///
+  /// \param[in] path_request
+  ///   New path request to be sent out to the clients.
+  /// \param[in] retry_policy
+  ///   How long to wait for an acknowledgement and how often to try.
+  /// \param[in] callback
+  ///   Optional function to be called once the request has completed, from
+  ///   either a DDS listener thread or the retry thread of the server.
+  /// \return
+  ///   Future that is ready once the request has completed.
+  std::future<RequestResult> send_path_request(
+      const messages::PathRequest& path_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback = nullptr);
+
+  /// Sends a new destination request to all the clients, and keeps sending
+  /// it according to the retry policy until the targetted client
+  /// acknowledges it, or all attempts have been used up.
+  ///
+  /// \param[in] destination_request
+  ///   New destination request to be sent out to the clients.
+  /// \param[in] retry_policy
+  ///   How long to wait for an acknowledgement and how often to try.
+  /// \param[in] callback
+  ///   Optional function to be called once the request has completed, from
+  ///   either a DDS listener thread or the retry thread of the server.
+  /// \return
+  ///   Future that is ready once the request has completed.
+  std::future<RequestResult> send_destination_request(
+      const messages::DestinationRequest& destination_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback = nullptr);
+
   /// Destructor
   ~Server();
 
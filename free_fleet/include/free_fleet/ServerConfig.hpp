@@ -19,16 +19,72 @@
 #define FREE_FLEET__INCLUDE__FREE_FLEET__SERVERCONFIG_HPP
 
 #include <string>
+#include <vector>
+
+#include <free_fleet/QoSProfile.hpp>
 
 namespace free_fleet {
 
 struct ServerConfig
 {
+  /// Robot state topic of a single fleet served by the server.
+  struct FleetConfig
+  {
+    std::string fleet_name;
+    std::string dds_robot_state_topic;
+  };
+
   int dds_domain = 42;
+
+  // Exchange samples with peers on the same host over the shared memory of
+  // iceoryx instead of UDP loopback. Needs CycloneDDS 0.9 or newer built
+  // with shared memory support and a running iox-roudi, older releases
+  // ignore it with an error. Peers on other hosts, and readers or writers
+  // whose QoS is not supported over shared memory, keep using the network.
+  bool dds_shared_memory = false;
+
+  // Send robot states as fixed size samples, which are serialized without
+  // allocations and loaned from the writer when the transport supports it.
+  // Names are cut to 63 characters, level names to 31 and paths to 64
+  // waypoints. Every sample carries all 64 waypoints, about 3.3 kB, however
+  // short the path is, so this trades bandwidth for fewer allocations. The
+  // server and all of its clients need to agree on this.
+  bool dds_bounded_robot_state = false;
+
+  // Send the paths of path requests compactly, with positions rounded to
+  // millimeters, yaws to milliradians and times to milliseconds. Clients
+  // always decode compact paths, so this only needs to be set here.
+  bool dds_compact_path = false;
   std::string dds_robot_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_request_ack_topic = "request_ack";
+
+  // Level, fleet and robot names are sent as ids, which the server gives out
+  // and publishes on this topic. Off when empty, which sends names as strings
+  // only. Every server on the same DDS domain needs a topic of its own, and
+  // its clients need to use the same one, as ids of other servers cannot be
+  // told apart from those of their own.
+  std::string dds_name_id_topic = "";
+
+  // Only the newest state of each robot is kept between reads, the maximum
+  // number of samples also bounds the number of robots that can be updated
+  // at once, any more than this will be dropped and counted. These need to
+  // be compatible with the profiles used by the clients.
+  QoSProfile dds_robot_state_qos = QoSProfile::state_stream();
+  QoSProfile dds_mode_request_qos = QoSProfile::command_urgent();
+  QoSProfile dds_path_request_qos = QoSProfile::command_reliable();
+  QoSProfile dds_destination_request_qos = QoSProfile::command_reliable();
+  QoSProfile dds_request_ack_qos = QoSProfile::command_reliable();
+  QoSProfile dds_name_id_qos = QoSProfile::name_table();
+
+  // Fleets served together over a single participant. Requests and their
+  // acknowledgements carry the name of their fleet, so a single writer or
+  // reader of each is shared by all of the fleets, but robot states do not,
+  // so every fleet needs a robot state topic of its own. When empty, a
+  // single unnamed fleet is served on dds_robot_state_topic.
+  std::vector<FleetConfig> fleets;
 
   void print_config() const;
 };
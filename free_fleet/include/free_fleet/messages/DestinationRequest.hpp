@@ -29,6 +29,10 @@ struct DestinationRequest
   std::string robot_name;
   Location destination;
   std::string task_id;
+
+  // Ids the server gave to the fleet and robot names, see NameId.hpp.
+  uint32_t fleet_id = 0;
+  uint32_t robot_id = 0;
 };
 
 } // namespace messages
@@ -32,6 +32,9 @@ struct Location
   float y;
   float yaw;
   std::string level_name;
+
+  // Id the server gave to the level name, see NameId.hpp.
+  uint32_t level_id = 0;
 };
 
 } // namespace messages
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "RobotMode.hpp"
 #include "ModeParameter.hpp"
@@ -34,6 +35,10 @@ struct ModeRequest
   RobotMode mode;
   std::string task_id;
   std::vector<ModeParameter> parameters;
+
+  // Ids the server gave to the fleet and robot names, see NameId.hpp.
+  uint32_t fleet_id = 0;
+  uint32_t robot_id = 0;
 };
 
 } // namespace messages
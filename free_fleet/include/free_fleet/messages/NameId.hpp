@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__NAMEID_HPP
+#define FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__NAMEID_HPP
+
+#include <string>
+#include <cstdint>
+
+namespace free_fleet {
+namespace messages {
+
+// Level, fleet and robot names in messages come with the id the server gave
+// to them, or 0 if they have none yet. The upper 16 bits of an id are the
+// generation of the table of names of the server, which is different every
+// time the server starts, so ids can only be compared to ids of the same
+// generation.
+
+inline uint32_t get_name_id_generation(uint32_t _id)
+{
+  return _id >> 16;
+}
+
+/// Whether two names are the same, comparing their ids instead of the names
+/// when both have ids of the same generation.
+inline bool is_same_name(
+    uint32_t _id, const std::string& _name,
+    uint32_t _other_id, const std::string& _other_name)
+{
+  if (_id != 0 && _other_id != 0 &&
+      get_name_id_generation(_id) == get_name_id_generation(_other_id))
+    return _id == _other_id;
+  return _name == _other_name;
+}
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__INCLUDE__FREE_FLEET__MESSAGES__NAMEID_HPP
@@ -31,6 +31,10 @@ struct PathRequest
   std::string robot_name;
   std::vector<Location> path;
   std::string task_id;
+
+  // Ids the server gave to the fleet and robot names, see NameId.hpp.
+  uint32_t fleet_id = 0;
+  uint32_t robot_id = 0;
 };
 
 } // namespace messages
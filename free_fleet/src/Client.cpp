@@ -22,6 +22,7 @@
 #include "ClientImpl.hpp"
 
 #include "messages/FleetMessages.h"
+#include "dds_utils/common.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
 
@@ -31,49 +32,88 @@ Client::SharedPtr Client::make(const ClientConfig& _config)
 {
   SharedPtr client = SharedPtr(new Client(_config));
 
-  dds_entity_t participant = dds_create_participant(
-      static_cast<dds_domainid_t>(_config.dds_domain), NULL, NULL);
+  dds_entity_t domain = 0;
+  dds_entity_t participant = common::dds_participant_create(
+      _config.dds_domain, _config.dds_shared_memory, domain);
   if (participant < 0)
   {
     DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-participant));
     return nullptr;
   }
 
-  dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr state_pub(
-      new dds::DDSPublishHandler<FreeFleetData_RobotState>(
-          participant, &FreeFleetData_RobotState_desc,
-          _config.dds_state_topic));
+  // Only one of the robot state publishers is created, depending on whether
+  // the states are sent as fixed size samples.
+  dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr state_pub;
+  dds::DDSPublishHandler<FreeFleetData_BoundedRobotState>::SharedPtr
+      bounded_state_pub;
+  if (_config.dds_bounded_robot_state)
+    bounded_state_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_BoundedRobotState>(
+            participant, &FreeFleetData_BoundedRobotState_desc,
+            _config.dds_state_topic,
+            _config.dds_state_qos));
+  else
+    state_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_RobotState>(
+            participant, &FreeFleetData_RobotState_desc,
+            _config.dds_state_topic,
+            _config.dds_state_qos));
 
   dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>::SharedPtr 
       mode_request_sub(
           new dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>(
               participant, &FreeFleetData_ModeRequest_desc,
-              _config.dds_mode_request_topic));
+              _config.dds_mode_request_topic,
+              _config.dds_mode_request_qos));
 
   dds::DDSSubscribeHandler<FreeFleetData_PathRequest>::SharedPtr 
       path_request_sub(
           new dds::DDSSubscribeHandler<FreeFleetData_PathRequest>(
               participant, &FreeFleetData_PathRequest_desc,
-              _config.dds_path_request_topic));
+              _config.dds_path_request_topic,
+              _config.dds_path_request_qos));
 
   dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>::SharedPtr
       destination_request_sub(
           new dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>(
               participant, &FreeFleetData_DestinationRequest_desc,
-              _config.dds_destination_request_topic));
-
-  if (!state_pub->is_ready() ||
+              _config.dds_destination_request_topic,
+              _config.dds_destination_request_qos));
+
+  dds::DDSPublishHandler<FreeFleetData_RequestAck>::SharedPtr
+      request_ack_pub(
+          new dds::DDSPublishHandler<FreeFleetData_RequestAck>(
+              participant, &FreeFleetData_RequestAck_desc,
+              _config.dds_request_ack_topic,
+              _config.dds_request_ack_qos));
+
+  dds::DDSSubscribeHandler<FreeFleetData_NameId, 10>::SharedPtr name_id_sub;
+  if (!_config.dds_name_id_topic.empty())
+    name_id_sub.reset(
+        new dds::DDSSubscribeHandler<FreeFleetData_NameId, 10>(
+            participant, &FreeFleetData_NameId_desc,
+            _config.dds_name_id_topic,
+            _config.dds_name_id_qos));
+
+  if ((state_pub && !state_pub->is_ready()) ||
+      (bounded_state_pub && !bounded_state_pub->is_ready()) ||
       !mode_request_sub->is_ready() ||
       !path_request_sub->is_ready() ||
-      !destination_request_sub->is_ready())
+      !destination_request_sub->is_ready() ||
+      !request_ack_pub->is_ready() ||
+      (name_id_sub && !name_id_sub->is_ready()))
     return nullptr;
 
   client->impl->start(ClientImpl::Fields{
       std::move(participant),
+      std::move(domain),
       std::move(state_pub),
+      std::move(bounded_state_pub),
       std::move(mode_request_sub),
       std::move(path_request_sub),
-      std::move(destination_request_sub)});
+      std::move(destination_request_sub),
+      std::move(request_ack_pub),
+      std::move(name_id_sub)});
   return client;
 }
 
@@ -106,4 +146,48 @@ bool Client::read_destination_request(
   return impl->read_destination_request(_destination_request);
 }
 
+std::size_t Client::read_mode_requests(
+    std::vector<messages::ModeRequest>& _mode_requests)
+{
+  return impl->read_mode_requests(_mode_requests);
+}
+
+std::size_t Client::read_path_requests(
+    std::vector<messages::PathRequest>& _path_requests)
+{
+  return impl->read_path_requests(_path_requests);
+}
+
+std::size_t Client::read_destination_requests(
+    std::vector<messages::DestinationRequest>& _destination_requests)
+{
+  return impl->read_destination_requests(_destination_requests);
+}
+
+bool Client::set_mode_request_callback(ModeRequestCallback _callback)
+{
+  return impl->set_mode_request_callback(std::move(_callback));
+}
+
+bool Client::set_path_request_callback(PathRequestCallback _callback)
+{
+  return impl->set_path_request_callback(std::move(_callback));
+}
+
+bool Client::set_destination_request_callback(
+    DestinationRequestCallback _callback)
+{
+  return impl->set_destination_request_callback(std::move(_callback));
+}
+
+bool Client::send_request_ack(const messages::RequestAck& _request_ack)
+{
+  return impl->send_request_ack(_request_ack);
+}
+
+uint32_t Client::get_name_id(const std::string& _name)
+{
+  return impl->get_name_id(_name);
+}
+
 } // namespace free_fleet
@@ -22,30 +22,99 @@ namespace free_fleet {
 
 Client::ClientImpl::ClientImpl(const ClientConfig& _config) :
   client_config(_config)
-{}
+{
+  if (client_config.adaptive_state_publishing)
+    state_filter.reset(new RobotStateFilter(client_config));
+}
 
 Client::ClientImpl::~ClientImpl()
 {
+  stopping = true;
+  if (mode_request_thread.joinable())
+    mode_request_thread.join();
+
   dds_return_t return_code = dds_delete(fields.participant);
   if (return_code != DDS_RETCODE_OK)
   {
     DDS_FATAL("dds_delete: %s", dds_strretcode(-return_code));
   }
+  if (fields.domain > 0)
+    dds_delete(fields.domain);
 }
 
 void Client::ClientImpl::start(Fields _fields)
 {
   fields = std::move(_fields);
+
+  if (fields.name_id_sub)
+  {
+    fields.name_id_sub->set_callback(
+        [this](const FreeFleetData_NameId& _dds_name_id)
+        {
+          name_table.learn(_dds_name_id.name, _dds_name_id.id);
+        });
+  }
 }
 
 bool Client::ClientImpl::send_robot_state(
     const messages::RobotState& _new_robot_state)
 {
-  FreeFleetData_RobotState* new_rs = FreeFleetData_RobotState__alloc();
-  convert(_new_robot_state, *new_rs);
-  bool sent = fields.state_pub->write(new_rs);
-  FreeFleetData_RobotState_free(new_rs, DDS_FREE_ALL);
-  return sent;
+  std::unique_lock<std::mutex> send_lock(send_mutex);
+  if (state_filter &&
+      !state_filter->should_send(
+          _new_robot_state, RobotStateFilter::Clock::now()))
+    return true;
+
+  if (fields.bounded_state_pub)
+  {
+    return fields.bounded_state_pub->write_loaned(
+        [&](FreeFleetData_BoundedRobotState& _sample)
+        {
+          convert(_new_robot_state, _sample);
+        });
+  }
+
+  convert(_new_robot_state, robot_state_sample, path_buffer);
+  intern_level_names(_new_robot_state, robot_state_sample);
+  if (client_config.dds_compact_path)
+    messages::compact_path(robot_state_sample, compact_path_buffer);
+  return fields.state_pub->write(&robot_state_sample);
+}
+
+namespace {
+
+char empty_level_name[] = "";
+
+} // namespace
+
+void Client::ClientImpl::intern_level_names(
+    const messages::RobotState& _robot_state,
+    FreeFleetData_RobotState& _sample)
+{
+  if (!fields.name_id_sub)
+    return;
+
+  // Paths mostly stay on a single level, which is then only looked up once.
+  const std::string* previous_level_name = nullptr;
+  uint32_t previous_level_id = 0;
+  auto intern = [&](
+      const messages::Location& _location,
+      FreeFleetData_Location& _location_sample)
+  {
+    if (!previous_level_name || _location.level_name != *previous_level_name)
+    {
+      previous_level_name = &_location.level_name;
+      previous_level_id = name_table.find_id(_location.level_name);
+    }
+
+    _location_sample.level_id = previous_level_id;
+    if (previous_level_id != 0)
+      _location_sample.level_name = empty_level_name;
+  };
+
+  intern(_robot_state.location, _sample.location);
+  for (std::size_t i = 0; i < _robot_state.path.size(); ++i)
+    intern(_robot_state.path[i], _sample.path._buffer[i]);
 }
 
 bool Client::ClientImpl::read_mode_request
@@ -84,4 +153,120 @@ bool Client::ClientImpl::read_destination_request(
   return false;
 }
 
+template <typename Request, typename DDSRequest>
+std::size_t Client::ClientImpl::take_requests(
+    dds::DDSSubscribeHandler<DDSRequest>& _subscriber,
+    std::vector<Request>& _requests)
+{
+  _requests.clear();
+  _subscriber.take_all(
+      [&](const DDSRequest& _dds_request)
+      {
+        _requests.emplace_back();
+        convert(_dds_request, _requests.back());
+      });
+  return _requests.size();
+}
+
+std::size_t Client::ClientImpl::read_mode_requests(
+    std::vector<messages::ModeRequest>& _mode_requests)
+{
+  return take_requests(*fields.mode_request_sub, _mode_requests);
+}
+
+std::size_t Client::ClientImpl::read_path_requests(
+    std::vector<messages::PathRequest>& _path_requests)
+{
+  return take_requests(*fields.path_request_sub, _path_requests);
+}
+
+std::size_t Client::ClientImpl::read_destination_requests(
+    std::vector<messages::DestinationRequest>& _destination_requests)
+{
+  return take_requests(
+      *fields.destination_request_sub, _destination_requests);
+}
+
+bool Client::ClientImpl::set_mode_request_callback(
+    ModeRequestCallback _callback)
+{
+  if (!_callback || mode_request_thread.joinable() ||
+      !fields.mode_request_sub->is_ready())
+    return false;
+
+  // Mode requests get a thread of their own instead of a listener, whose
+  // thread is shared with the path and destination requests.
+  mode_request_thread = std::thread(
+      &ClientImpl::mode_request_thread_fn, this, std::move(_callback));
+  return true;
+}
+
+void Client::ClientImpl::mode_request_thread_fn(ModeRequestCallback _callback)
+{
+  // Woken up now and then to notice the client being destroyed.
+  const dds_duration_t timeout = DDS_MSECS(100);
+  std::vector<messages::ModeRequest> mode_requests;
+  while (!stopping)
+  {
+    if (!fields.mode_request_sub->wait(timeout))
+      continue;
+
+    if (take_requests(*fields.mode_request_sub, mode_requests) > 0)
+      _callback(mode_requests);
+  }
+}
+
+template <typename Request, typename DDSRequest, typename Callback>
+bool Client::ClientImpl::set_requests_callback(
+    dds::DDSSubscribeHandler<DDSRequest>& _subscriber,
+    Callback _callback)
+{
+  if (!_callback)
+    return false;
+
+  // Only touched by the listener while it holds the subscriber's take
+  // mutex, which every request is collected and handed over under.
+  auto requests = std::make_shared<std::vector<Request>>();
+  return _subscriber.set_callback(
+      [requests](const DDSRequest& _dds_request)
+      {
+        requests->emplace_back();
+        convert(_dds_request, requests->back());
+      },
+      [requests, _callback]()
+      {
+        if (requests->empty())
+          return;
+        _callback(*requests);
+        requests->clear();
+      });
+}
+
+bool Client::ClientImpl::set_path_request_callback(
+    PathRequestCallback _callback)
+{
+  return set_requests_callback<messages::PathRequest>(
+      *fields.path_request_sub, std::move(_callback));
+}
+
+bool Client::ClientImpl::set_destination_request_callback(
+    DestinationRequestCallback _callback)
+{
+  return set_requests_callback<messages::DestinationRequest>(
+      *fields.destination_request_sub, std::move(_callback));
+}
+
+bool Client::ClientImpl::send_request_ack(
+    const messages::RequestAck& _request_ack)
+{
+  std::unique_lock<std::mutex> send_lock(send_mutex);
+  convert(_request_ack, request_ack_sample);
+  return fields.request_ack_pub->write(&request_ack_sample);
+}
+
+uint32_t Client::ClientImpl::get_name_id(const std::string& _name)
+{
+  return name_table.find_id(_name);
+}
+
 } // namespace free_fleet
@@ -18,15 +18,24 @@
 #ifndef FREE_FLEET__SRC__CLIENTIMPL_HPP
 #define FREE_FLEET__SRC__CLIENTIMPL_HPP
 
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 #include <free_fleet/Client.hpp>
 #include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/RobotStateFilter.hpp>
 
 #include <dds/dds.h>
 
+#include "messages/NameTable.hpp"
 #include "messages/FleetMessages.h"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
@@ -43,11 +52,20 @@ public:
     /// DDS participant that is tied to the configured dds_domain_id
     dds_entity_t participant;
 
+    /// DDS domain created for shared memory along with the participant, 0 if
+    /// none was
+    dds_entity_t domain;
+
     /// DDS publisher that handles sending out current robot states to the 
     /// server
     dds::DDSPublishHandler<FreeFleetData_RobotState>::SharedPtr
         state_pub;
 
+    /// DDS publisher used instead of state_pub when robot states are sent as
+    /// fixed size samples
+    dds::DDSPublishHandler<FreeFleetData_BoundedRobotState>::SharedPtr
+        bounded_state_pub;
+
     /// DDS subscriber for mode requests coming from the server
     dds::DDSSubscribeHandler<FreeFleetData_ModeRequest>::SharedPtr 
         mode_request_sub;
@@ -59,6 +77,15 @@ public:
     /// DDS subscriber for destination requests coming from the server
     dds::DDSSubscribeHandler<FreeFleetData_DestinationRequest>::SharedPtr
         destination_request_sub;
+
+    /// DDS publisher for acknowledgements of requests to the server
+    dds::DDSPublishHandler<FreeFleetData_RequestAck>::SharedPtr
+        request_ack_pub;
+
+    /// DDS subscriber for the ids the server gave to names, null if names
+    /// are only sent as strings
+    dds::DDSSubscribeHandler<FreeFleetData_NameId, 10>::SharedPtr
+        name_id_sub;
   };
 
   ClientImpl(const ClientConfig& config);
@@ -76,8 +103,74 @@ public:
   bool read_destination_request(
       messages::DestinationRequest& destination_request);
 
+  std::size_t read_mode_requests(
+      std::vector<messages::ModeRequest>& mode_requests);
+
+  std::size_t read_path_requests(
+      std::vector<messages::PathRequest>& path_requests);
+
+  std::size_t read_destination_requests(
+      std::vector<messages::DestinationRequest>& destination_requests);
+
+  bool set_mode_request_callback(ModeRequestCallback callback);
+
+  bool set_path_request_callback(PathRequestCallback callback);
+
+  bool set_destination_request_callback(
+      DestinationRequestCallback callback);
+
+  bool send_request_ack(const messages::RequestAck& request_ack);
+
+  uint32_t get_name_id(const std::string& name);
+
 private:
 
+  /// Takes every queued request of a subscriber, converting them into the
+  /// requests vector in order of arrival.
+  template <typename Request, typename DDSRequest>
+  static std::size_t take_requests(
+      dds::DDSSubscribeHandler<DDSRequest>& subscriber,
+      std::vector<Request>& requests);
+
+  /// Has the listener of a subscriber hand every request it took in one go
+  /// to the callback at once, see set_path_request_callback.
+  template <typename Request, typename DDSRequest, typename Callback>
+  static bool set_requests_callback(
+      dds::DDSSubscribeHandler<DDSRequest>& subscriber,
+      Callback callback);
+
+  /// Sends the level names the server gave ids to as ids only.
+  void intern_level_names(
+      const messages::RobotState& robot_state,
+      FreeFleetData_RobotState& sample);
+
+  /// Ids learned from the server.
+  messages::NameTable name_table;
+
+  /// Takes mode requests as soon as they arrive and hands them to the
+  /// callback, see set_mode_request_callback.
+  void mode_request_thread_fn(ModeRequestCallback callback);
+
+  std::thread mode_request_thread;
+
+  std::atomic<bool> stopping{false};
+
+  /// DDS samples reused for everything sent, guarded by send_mutex, see
+  /// messages::convert.
+  std::mutex send_mutex;
+
+  FreeFleetData_RobotState robot_state_sample;
+
+  std::vector<FreeFleetData_Location> path_buffer;
+
+  std::vector<uint8_t> compact_path_buffer;
+
+  /// Skips robot states that barely changed, guarded by send_mutex, null
+  /// unless states are published adaptively.
+  std::unique_ptr<RobotStateFilter> state_filter;
+
+  FreeFleetData_RequestAck request_ack_sample;
+
   Fields fields;
 
   ClientConfig client_config;
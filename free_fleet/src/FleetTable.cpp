@@ -0,0 +1,438 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <thread>
+#include <algorithm>
+
+#include <free_fleet/FleetTable.hpp>
+
+namespace free_fleet {
+
+namespace {
+
+bool is_same_location(
+    const messages::Location& _first, const messages::Location& _second)
+{
+  return _first.sec == _second.sec &&
+      _first.nanosec == _second.nanosec &&
+      _first.x == _second.x &&
+      _first.y == _second.y &&
+      _first.yaw == _second.yaw &&
+      _first.level_name == _second.level_name;
+}
+
+bool is_same_details(
+    const FleetTable::Details& _details,
+    const messages::RobotState& _robot_state)
+{
+  if (_details.model != _robot_state.model ||
+      _details.task_id != _robot_state.task_id ||
+      _details.level_name != _robot_state.location.level_name ||
+      _details.path.size() != _robot_state.path.size())
+    return false;
+
+  for (std::size_t i = 0; i < _details.path.size(); ++i)
+  {
+    if (!is_same_location(_details.path[i], _robot_state.path[i]))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::size_t FleetTable::Snapshot::size() const
+{
+  return id.size();
+}
+
+FleetTable::FleetTable(
+    std::size_t _capacity, double _stale_timeout, double _evict_timeout) :
+  table_capacity(_capacity),
+  stale_timeout_ns(static_cast<int64_t>(std::max(_stale_timeout, 0.0) * 1e9)),
+  evict_timeout_ns(static_cast<int64_t>(std::max(_evict_timeout, 0.0) * 1e9)),
+  num_slots(0),
+  num_robots(0),
+  ids(std::make_shared<const IdMap>()),
+  expiry_generations(_capacity, 0),
+  sequences(new std::atomic<uint32_t>[_capacity]),
+  slot_states(new std::atomic<uint8_t>[_capacity]),
+  last_seens(new std::atomic<int64_t>[_capacity]),
+  versions(new std::atomic<uint64_t>[_capacity]),
+  secs(new std::atomic<int32_t>[_capacity]),
+  nanosecs(new std::atomic<uint32_t>[_capacity]),
+  xs(new std::atomic<float>[_capacity]),
+  ys(new std::atomic<float>[_capacity]),
+  yaws(new std::atomic<float>[_capacity]),
+  modes(new std::atomic<uint32_t>[_capacity]),
+  battery_percents(new std::atomic<float>[_capacity]),
+  details(new std::shared_ptr<const Details>[_capacity]),
+  rejected_count(0)
+{
+  for (std::size_t i = 0; i < table_capacity; ++i)
+  {
+    sequences[i].store(0, std::memory_order_relaxed);
+    slot_states[i].store(Empty, std::memory_order_relaxed);
+    last_seens[i].store(0, std::memory_order_relaxed);
+    versions[i].store(0, std::memory_order_relaxed);
+    secs[i].store(0, std::memory_order_relaxed);
+    nanosecs[i].store(0, std::memory_order_relaxed);
+    xs[i].store(0.0f, std::memory_order_relaxed);
+    ys[i].store(0.0f, std::memory_order_relaxed);
+    yaws[i].store(0.0f, std::memory_order_relaxed);
+    modes[i].store(0, std::memory_order_relaxed);
+    battery_percents[i].store(0.0f, std::memory_order_relaxed);
+  }
+}
+
+FleetTable::~FleetTable()
+{}
+
+std::size_t FleetTable::capacity() const
+{
+  return table_capacity;
+}
+
+std::size_t FleetTable::size() const
+{
+  return num_robots.load(std::memory_order_acquire);
+}
+
+bool FleetTable::update(
+    const messages::RobotState& _robot_state,
+    std::size_t& _id,
+    bool* _is_new)
+{
+  return update(_robot_state, std::chrono::steady_clock::now(), _id, _is_new);
+}
+
+bool FleetTable::update(
+    const messages::RobotState& _robot_state,
+    TimePoint _now,
+    std::size_t& _id,
+    bool* _is_new)
+{
+  std::unique_lock<std::mutex> lock(write_mutex);
+
+  // Only writers replace the ids, and they are serialized by the lock, so
+  // they can be read here without going through an atomic load.
+  auto it = ids->find(_robot_state.name);
+  const bool is_new = it == ids->end();
+  bool is_new_slot = false;
+  if (is_new)
+  {
+    if (!free_ids.empty())
+    {
+      _id = free_ids.back();
+      free_ids.pop_back();
+    }
+    else if (num_slots.load(std::memory_order_relaxed) < table_capacity)
+    {
+      _id = num_slots.load(std::memory_order_relaxed);
+      is_new_slot = true;
+    }
+    else
+    {
+      rejected_count.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  else
+    _id = it->second;
+  if (_is_new)
+    *_is_new = is_new;
+
+  const bool was_stale =
+      slot_states[_id].load(std::memory_order_relaxed) == Stale;
+  const int64_t now_ns = _now.time_since_epoch().count();
+
+  // The details are only replaced when they changed, which is rare compared
+  // to the pose.
+  std::shared_ptr<const Details> new_details;
+  if (is_new || !is_same_details(*details[_id], _robot_state))
+  {
+    std::shared_ptr<Details> changed_details(new Details);
+    changed_details->name = _robot_state.name;
+    changed_details->model = _robot_state.model;
+    changed_details->task_id = _robot_state.task_id;
+    changed_details->level_name = _robot_state.location.level_name;
+    changed_details->path = _robot_state.path;
+    new_details = std::move(changed_details);
+  }
+
+  // An odd sequence marks the robot as being written, readers that saw it
+  // odd, or saw it change while reading, read the robot again.
+  const uint32_t sequence = sequences[_id].load(std::memory_order_relaxed);
+  sequences[_id].store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot_states[_id].store(Live, std::memory_order_relaxed);
+  last_seens[_id].store(now_ns, std::memory_order_relaxed);
+  versions[_id].store(
+      versions[_id].load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+  secs[_id].store(_robot_state.location.sec, std::memory_order_relaxed);
+  nanosecs[_id].store(
+      _robot_state.location.nanosec, std::memory_order_relaxed);
+  xs[_id].store(_robot_state.location.x, std::memory_order_relaxed);
+  ys[_id].store(_robot_state.location.y, std::memory_order_relaxed);
+  yaws[_id].store(_robot_state.location.yaw, std::memory_order_relaxed);
+  modes[_id].store(_robot_state.mode.mode, std::memory_order_relaxed);
+  battery_percents[_id].store(
+      _robot_state.battery_percent, std::memory_order_relaxed);
+  if (new_details)
+    std::atomic_store(&details[_id], std::move(new_details));
+
+  sequences[_id].store(sequence + 2, std::memory_order_release);
+
+  if (is_new)
+  {
+    // The robot is only made visible once it has been fully written.
+    num_robots.fetch_add(1, std::memory_order_release);
+    if (is_new_slot)
+      num_slots.store(_id + 1, std::memory_order_release);
+
+    std::shared_ptr<IdMap> new_ids(new IdMap(*ids));
+    new_ids->emplace(_robot_state.name, _id);
+    std::atomic_store(&ids, std::shared_ptr<const IdMap>(std::move(new_ids)));
+  }
+
+  // Robots that are already waiting to expire are checked again once due,
+  // so that updates do not have to touch the heap.
+  if (is_new || was_stale)
+    schedule_expiry(_id, now_ns);
+  return true;
+}
+
+void FleetTable::expire(
+    TimePoint _now,
+    std::vector<std::string>& _stale_robots,
+    std::vector<std::string>& _evicted_robots)
+{
+  std::unique_lock<std::mutex> lock(write_mutex);
+
+  const int64_t now_ns = _now.time_since_epoch().count();
+  const std::size_t first_evicted = _evicted_robots.size();
+  while (!expiries.empty() && expiries.top().deadline <= now_ns)
+  {
+    const Expiry expiry = expiries.top();
+    expiries.pop();
+    if (expiry.generation != expiry_generations[expiry.id])
+      continue;
+
+    const std::size_t id = expiry.id;
+    const int64_t last_seen = last_seens[id].load(std::memory_order_relaxed);
+    const uint8_t state = slot_states[id].load(std::memory_order_relaxed);
+
+    if (stale_timeout_ns > 0 && state == Live)
+    {
+      // Updated since this expiry was scheduled, check again once due.
+      if (now_ns < last_seen + stale_timeout_ns)
+      {
+        expiries.push(
+            Expiry{last_seen + stale_timeout_ns, id, expiry.generation});
+        continue;
+      }
+
+      set_slot_state(id, Stale);
+      _stale_robots.push_back(details[id]->name);
+      if (evict_timeout_ns > 0)
+        expiries.push(
+            Expiry{last_seen + evict_timeout_ns, id, expiry.generation});
+      continue;
+    }
+
+    if (evict_timeout_ns <= 0)
+      continue;
+    if (now_ns < last_seen + evict_timeout_ns)
+    {
+      expiries.push(
+          Expiry{last_seen + evict_timeout_ns, id, expiry.generation});
+      continue;
+    }
+
+    _evicted_robots.push_back(details[id]->name);
+    set_slot_state(id, Empty);
+    num_robots.fetch_sub(1, std::memory_order_release);
+    ++expiry_generations[id];
+    free_ids.push_back(id);
+  }
+
+  // The ids are copied once for all of the robots evicted together.
+  if (_evicted_robots.size() == first_evicted)
+    return;
+  std::shared_ptr<IdMap> new_ids(new IdMap(*ids));
+  for (std::size_t i = first_evicted; i < _evicted_robots.size(); ++i)
+    new_ids->erase(_evicted_robots[i]);
+  std::atomic_store(&ids, std::shared_ptr<const IdMap>(std::move(new_ids)));
+}
+
+bool FleetTable::find(const std::string& _robot_name, std::size_t& _id) const
+{
+  const std::shared_ptr<const IdMap> current_ids = std::atomic_load(&ids);
+  auto it = current_ids->find(_robot_name);
+  if (it == current_ids->end())
+    return false;
+  _id = it->second;
+  return true;
+}
+
+bool FleetTable::is_stale(std::size_t _id) const
+{
+  if (_id >= table_capacity)
+    return false;
+  return slot_states[_id].load(std::memory_order_acquire) == Stale;
+}
+
+bool FleetTable::read(
+    std::size_t _id, messages::RobotState& _robot_state) const
+{
+  if (_id >= num_slots.load(std::memory_order_acquire))
+    return false;
+
+  Entry entry;
+  read_robot(_id, entry);
+  if (entry.state == Empty)
+    return false;
+
+  _robot_state.name = entry.details->name;
+  _robot_state.model = entry.details->model;
+  _robot_state.task_id = entry.details->task_id;
+  _robot_state.mode.mode = entry.mode;
+  _robot_state.battery_percent = entry.battery_percent;
+  _robot_state.location.sec = entry.sec;
+  _robot_state.location.nanosec = entry.nanosec;
+  _robot_state.location.x = entry.x;
+  _robot_state.location.y = entry.y;
+  _robot_state.location.yaw = entry.yaw;
+  _robot_state.location.level_name = entry.details->level_name;
+  _robot_state.path = entry.details->path;
+  return true;
+}
+
+void FleetTable::read_all(Snapshot& _snapshot) const
+{
+  // Evicted robots leave empty slots behind, the snapshot is sized for
+  // every slot first and shrunk to the robots that were found.
+  const std::size_t n = num_slots.load(std::memory_order_acquire);
+  _snapshot.id.resize(n);
+  _snapshot.sec.resize(n);
+  _snapshot.nanosec.resize(n);
+  _snapshot.x.resize(n);
+  _snapshot.y.resize(n);
+  _snapshot.yaw.resize(n);
+  _snapshot.mode.resize(n);
+  _snapshot.battery_percent.resize(n);
+  _snapshot.version.resize(n);
+  _snapshot.stale.resize(n);
+  _snapshot.last_seen.resize(n);
+  _snapshot.details.resize(n);
+
+  Entry entry;
+  std::size_t i = 0;
+  for (std::size_t id = 0; id < n; ++id)
+  {
+    read_robot(id, entry);
+    if (entry.state == Empty)
+      continue;
+
+    _snapshot.id[i] = id;
+    _snapshot.version[i] = entry.version;
+    _snapshot.sec[i] = entry.sec;
+    _snapshot.nanosec[i] = entry.nanosec;
+    _snapshot.x[i] = entry.x;
+    _snapshot.y[i] = entry.y;
+    _snapshot.yaw[i] = entry.yaw;
+    _snapshot.mode[i] = entry.mode;
+    _snapshot.battery_percent[i] = entry.battery_percent;
+    _snapshot.stale[i] = entry.state == Stale ? 1 : 0;
+    _snapshot.last_seen[i] =
+        TimePoint(TimePoint::duration(entry.last_seen));
+    _snapshot.details[i] = std::move(entry.details);
+    ++i;
+  }
+
+  _snapshot.id.resize(i);
+  _snapshot.sec.resize(i);
+  _snapshot.nanosec.resize(i);
+  _snapshot.x.resize(i);
+  _snapshot.y.resize(i);
+  _snapshot.yaw.resize(i);
+  _snapshot.mode.resize(i);
+  _snapshot.battery_percent.resize(i);
+  _snapshot.version.resize(i);
+  _snapshot.stale.resize(i);
+  _snapshot.last_seen.resize(i);
+  _snapshot.details.resize(i);
+}
+
+uint64_t FleetTable::get_rejected_count() const
+{
+  return rejected_count.load(std::memory_order_relaxed);
+}
+
+void FleetTable::read_robot(std::size_t _id, Entry& _entry) const
+{
+  while (true)
+  {
+    const uint32_t begin = sequences[_id].load(std::memory_order_acquire);
+    if (begin & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    _entry.state = slot_states[_id].load(std::memory_order_relaxed);
+    _entry.last_seen = last_seens[_id].load(std::memory_order_relaxed);
+    _entry.version = versions[_id].load(std::memory_order_relaxed);
+    _entry.sec = secs[_id].load(std::memory_order_relaxed);
+    _entry.nanosec = nanosecs[_id].load(std::memory_order_relaxed);
+    _entry.x = xs[_id].load(std::memory_order_relaxed);
+    _entry.y = ys[_id].load(std::memory_order_relaxed);
+    _entry.yaw = yaws[_id].load(std::memory_order_relaxed);
+    _entry.mode = modes[_id].load(std::memory_order_relaxed);
+    _entry.battery_percent =
+        battery_percents[_id].load(std::memory_order_relaxed);
+    _entry.details = std::atomic_load(&details[_id]);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequences[_id].load(std::memory_order_relaxed) == begin)
+      return;
+  }
+}
+
+void FleetTable::schedule_expiry(std::size_t _id, int64_t _last_seen)
+{
+  const int64_t timeout_ns =
+      stale_timeout_ns > 0 ? stale_timeout_ns : evict_timeout_ns;
+  if (timeout_ns <= 0)
+    return;
+
+  const uint64_t generation = ++expiry_generations[_id];
+  expiries.push(Expiry{_last_seen + timeout_ns, _id, generation});
+}
+
+void FleetTable::set_slot_state(std::size_t _id, SlotState _state)
+{
+  const uint32_t sequence = sequences[_id].load(std::memory_order_relaxed);
+  sequences[_id].store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot_states[_id].store(_state, std::memory_order_relaxed);
+  sequences[_id].store(sequence + 2, std::memory_order_release);
+}
+
+} // namespace free_fleet
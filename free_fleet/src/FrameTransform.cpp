@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+
+#include <free_fleet/FrameTransform.hpp>
+
+namespace free_fleet {
+
+FrameTransform::FrameTransform() :
+  FrameTransform(1.0, 0.0, 0.0, 0.0)
+{}
+
+FrameTransform::FrameTransform(
+    double _scale,
+    double _rotation,
+    double _translation_x,
+    double _translation_y)
+{
+  // The coefficients are worked out in double precision once, and only
+  // rounded to the precision of the poses at the end.
+  const double cos_rotation = std::cos(_rotation);
+  const double sin_rotation = std::sin(_rotation);
+
+  to_fleet.a = static_cast<float>(_scale * cos_rotation);
+  to_fleet.b = static_cast<float>(_scale * sin_rotation);
+  to_fleet.c = static_cast<float>(_translation_x);
+  to_fleet.d = static_cast<float>(_translation_y);
+  to_fleet.e = static_cast<float>(_rotation);
+
+  const double a = cos_rotation / _scale;
+  const double b = -sin_rotation / _scale;
+  to_rmf.a = static_cast<float>(a);
+  to_rmf.b = static_cast<float>(b);
+  to_rmf.c = static_cast<float>(-(a * _translation_x - b * _translation_y));
+  to_rmf.d = static_cast<float>(-(b * _translation_x + a * _translation_y));
+  to_rmf.e = static_cast<float>(-_rotation);
+}
+
+void FrameTransform::fleet_to_rmf(
+    std::size_t _size, float* _x, float* _y, float* _yaw) const
+{
+  apply(to_rmf, _size, _x, _y, _yaw);
+}
+
+void FrameTransform::rmf_to_fleet(
+    std::size_t _size, float* _x, float* _y, float* _yaw) const
+{
+  apply(to_fleet, _size, _x, _y, _yaw);
+}
+
+void FrameTransform::apply(
+    const Affine& _affine,
+    std::size_t _size,
+    float* _x,
+    float* _y,
+    float* _yaw)
+{
+  const float a = _affine.a;
+  const float b = _affine.b;
+  const float c = _affine.c;
+  const float d = _affine.d;
+  const float e = _affine.e;
+
+  // Kept free of branches and calls so that it is vectorized.
+  for (std::size_t i = 0; i < _size; ++i)
+  {
+    const float x = _x[i];
+    const float y = _y[i];
+    _x[i] = a * x - b * y + c;
+    _y[i] = b * x + a * y + d;
+    _yaw[i] += e;
+  }
+}
+
+} // namespace free_fleet
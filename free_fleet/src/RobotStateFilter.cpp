@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+
+#include <free_fleet/RobotStateFilter.hpp>
+
+namespace free_fleet {
+
+namespace {
+
+RobotStateFilter::Clock::duration to_duration(double _seconds)
+{
+  return std::chrono::duration_cast<RobotStateFilter::Clock::duration>(
+      std::chrono::duration<double>(_seconds));
+}
+
+bool is_same_location(
+    const messages::Location& _a, const messages::Location& _b)
+{
+  return _a.sec == _b.sec && _a.nanosec == _b.nanosec &&
+      _a.x == _b.x && _a.y == _b.y && _a.yaw == _b.yaw &&
+      _a.level_name == _b.level_name;
+}
+
+} // namespace
+
+RobotStateFilter::RobotStateFilter(const ClientConfig& _config) :
+  heartbeat_period(to_duration(_config.state_heartbeat_period)),
+  min_period(to_duration(_config.state_min_period)),
+  min_gap(min_period - min_period / 4),
+  position_threshold(_config.state_position_threshold),
+  yaw_threshold(_config.state_yaw_threshold),
+  battery_threshold(_config.state_battery_threshold)
+{}
+
+bool RobotStateFilter::should_send(
+    const messages::RobotState& _robot_state, Clock::time_point _now)
+{
+  if (has_sent)
+  {
+    const Clock::duration since_sent = _now - last_sent_time;
+    if (since_sent < min_gap)
+      return false;
+    if (since_sent < heartbeat_period && !has_changed(_robot_state))
+      return false;
+  }
+
+  has_sent = true;
+  last_sent_time = _now;
+  last_sent_state = _robot_state;
+  return true;
+}
+
+bool RobotStateFilter::has_changed(
+    const messages::RobotState& _robot_state) const
+{
+  const messages::RobotState& last = last_sent_state;
+  if (_robot_state.mode.mode != last.mode.mode ||
+      _robot_state.task_id != last.task_id ||
+      _robot_state.location.level_name != last.location.level_name)
+    return true;
+
+  const double dx = _robot_state.location.x - last.location.x;
+  const double dy = _robot_state.location.y - last.location.y;
+  const double dyaw = std::remainder(
+      static_cast<double>(_robot_state.location.yaw) - last.location.yaw,
+      2.0 * M_PI);
+  if (dx * dx + dy * dy > position_threshold * position_threshold ||
+      std::abs(dyaw) > yaw_threshold ||
+      std::abs(_robot_state.battery_percent - last.battery_percent) >
+          battery_threshold)
+    return true;
+
+  // Paths only change when waypoints are reached or a new path is given,
+  // which mostly changes their size too.
+  if (_robot_state.path.size() != last.path.size())
+    return true;
+  for (std::size_t i = 0; i < _robot_state.path.size(); ++i)
+  {
+    if (!is_same_location(_robot_state.path[i], last.path[i]))
+      return true;
+  }
+  return false;
+}
+
+} // namespace free_fleet
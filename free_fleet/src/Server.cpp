@@ -15,6 +15,8 @@
  *
  */
 
+#include <set>
+
 #include <dds/dds.h>
 
 #include <free_fleet/Server.hpp>
@@ -22,6 +24,7 @@
 #include "ServerImpl.hpp"
 
 #include "messages/FleetMessages.h"
+#include "dds_utils/common.hpp"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
 
@@ -29,54 +32,159 @@ namespace free_fleet {
 
 Server::SharedPtr Server::make(const ServerConfig& _config)
 {
-  SharedPtr server = SharedPtr(new Server(_config));
+  ServerConfig config = _config;
+  if (config.fleets.empty())
+    config.fleets.push_back(
+        ServerConfig::FleetConfig{"", config.dds_robot_state_topic});
+
+  // Robot states can only be told apart by the topic they arrive on.
+  std::set<std::string> fleet_names;
+  std::set<std::string> robot_state_topics;
+  for (const auto& fleet : config.fleets)
+  {
+    if (!fleet_names.insert(fleet.fleet_name).second ||
+        !robot_state_topics.insert(fleet.dds_robot_state_topic).second)
+    {
+      DDS_ERROR(
+          "fleet %s: every fleet needs a unique name and robot state topic\n",
+          fleet.fleet_name.c_str());
+      return nullptr;
+    }
+  }
 
-  dds_entity_t participant = dds_create_participant(
-      static_cast<dds_domainid_t>(_config.dds_domain), NULL, NULL);
+  SharedPtr server = SharedPtr(new Server(config));
+
+  dds_entity_t domain = 0;
+  dds_entity_t participant = common::dds_participant_create(
+      config.dds_domain, config.dds_shared_memory, domain);
   if (participant < 0)
   {
     DDS_FATAL("dds_create_participant: %s\n", dds_strretcode(-participant));
     return nullptr;
   }
 
-  dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>::SharedPtr state_sub(
-      new dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>(
-          participant, &FreeFleetData_RobotState_desc,
-          _config.dds_robot_state_topic));
+  // Robot states are keyed by robot name, with a history depth of 1 only the
+  // newest state of each robot is kept, so every read costs at most one
+  // sample per robot, no matter how often they publish.
+  // Fixed size robot states are read through subscribers of their own type.
+  std::vector<ServerImpl::RobotStateSub::SharedPtr> state_subs;
+  std::vector<ServerImpl::BoundedRobotStateSub::SharedPtr> bounded_state_subs;
+  for (const auto& fleet : config.fleets)
+  {
+    if (config.dds_bounded_robot_state)
+    {
+      bounded_state_subs.emplace_back(
+          new ServerImpl::BoundedRobotStateSub(
+              participant, &FreeFleetData_BoundedRobotState_desc,
+              fleet.dds_robot_state_topic,
+              config.dds_robot_state_qos));
+      if (!bounded_state_subs.back()->is_ready())
+        return nullptr;
+      continue;
+    }
+
+    state_subs.emplace_back(
+        new ServerImpl::RobotStateSub(
+            participant, &FreeFleetData_RobotState_desc,
+            fleet.dds_robot_state_topic,
+            config.dds_robot_state_qos));
+    if (!state_subs.back()->is_ready())
+      return nullptr;
+  }
 
   dds::DDSPublishHandler<FreeFleetData_ModeRequest>::SharedPtr 
       mode_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_ModeRequest>(
               participant, &FreeFleetData_ModeRequest_desc,
-              _config.dds_mode_request_topic));
+              config.dds_mode_request_topic,
+              config.dds_mode_request_qos));
 
   dds::DDSPublishHandler<FreeFleetData_PathRequest>::SharedPtr 
       path_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_PathRequest>(
               participant, &FreeFleetData_PathRequest_desc,
-              _config.dds_path_request_topic));
+              config.dds_path_request_topic,
+              config.dds_path_request_qos));
 
   dds::DDSPublishHandler<FreeFleetData_DestinationRequest>::SharedPtr 
       destination_request_pub(
           new dds::DDSPublishHandler<FreeFleetData_DestinationRequest>(
               participant, &FreeFleetData_DestinationRequest_desc,
-              _config.dds_destination_request_topic));
+              config.dds_destination_request_topic,
+              config.dds_destination_request_qos));
 
-  if (!state_sub->is_ready() ||
-      !mode_request_pub->is_ready() ||
+  dds::DDSSubscribeHandler<FreeFleetData_RequestAck, 10>::SharedPtr
+      request_ack_sub(
+          new dds::DDSSubscribeHandler<FreeFleetData_RequestAck, 10>(
+              participant, &FreeFleetData_RequestAck_desc,
+              config.dds_request_ack_topic,
+              config.dds_request_ack_qos));
+
+  dds::DDSPublishHandler<FreeFleetData_NameId>::SharedPtr name_id_pub;
+  if (!config.dds_name_id_topic.empty())
+    name_id_pub.reset(
+        new dds::DDSPublishHandler<FreeFleetData_NameId>(
+            participant, &FreeFleetData_NameId_desc,
+            config.dds_name_id_topic,
+            config.dds_name_id_qos));
+
+  if (!mode_request_pub->is_ready() ||
       !path_request_pub->is_ready() ||
-      !destination_request_pub->is_ready())
+      !destination_request_pub->is_ready() ||
+      !request_ack_sub->is_ready() ||
+      (name_id_pub && !name_id_pub->is_ready()))
     return nullptr;
 
   server->impl->start(ServerImpl::Fields{
       std::move(participant),
-      std::move(state_sub),
+      std::move(domain),
+      std::move(state_subs),
+      std::move(bounded_state_subs),
       std::move(mode_request_pub),
       std::move(path_request_pub),
-      std::move(destination_request_pub)});
+      std::move(destination_request_pub),
+      std::move(request_ack_sub),
+      std::move(name_id_pub)});
   return server;
 }
 
+std::size_t Server::RobotStateArena::size() const
+{
+  return robot_states.size();
+}
+
+const messages::RobotState& Server::RobotStateArena::operator[](
+    std::size_t _index) const
+{
+  return robot_states[_index];
+}
+
+std::size_t Server::RobotStateArena::find(
+    const std::string& _robot_name) const
+{
+  auto it = indices.find(_robot_name);
+  if (it == indices.end())
+    return robot_states.size();
+  return it->second;
+}
+
+messages::RobotState& Server::RobotStateArena::update(
+    const char* _robot_name, std::size_t& _index)
+{
+  lookup_name.assign(_robot_name);
+  auto it = indices.find(lookup_name);
+  if (it != indices.end())
+  {
+    _index = it->second;
+    return robot_states[_index];
+  }
+
+  _index = robot_states.size();
+  indices.emplace(lookup_name, _index);
+  robot_states.emplace_back();
+  return robot_states.back();
+}
+
 Server::Server(const ServerConfig& _config)
 {
   impl.reset(new ServerImpl(_config));
@@ -91,6 +199,52 @@ bool Server::read_robot_states(
   return impl->read_robot_states(_new_robot_states);
 }
 
+bool Server::read_robot_states(
+    RobotStateArena& _arena, std::vector<std::size_t>& _updated_indices)
+{
+  return impl->read_robot_states(_arena, _updated_indices);
+}
+
+bool Server::read_robot_states(
+    const std::string& _fleet_name,
+    RobotStateArena& _arena,
+    std::vector<std::size_t>& _updated_indices)
+{
+  return impl->read_robot_states(_fleet_name, _arena, _updated_indices);
+}
+
+bool Server::set_robot_state_callback(RobotStateCallback _callback)
+{
+  return impl->set_robot_state_callback(std::move(_callback));
+}
+
+bool Server::set_robot_state_callback(
+    const std::string& _fleet_name, RobotStateCallback _callback)
+{
+  return impl->set_robot_state_callback(_fleet_name, std::move(_callback));
+}
+
+void Server::clear_robot_state_callback(const std::string& _fleet_name)
+{
+  impl->clear_robot_state_callback(_fleet_name);
+}
+
+bool Server::wait_for_robot_states(
+    const std::string& _fleet_name, double _timeout)
+{
+  return impl->wait_for_robot_states(_fleet_name, _timeout);
+}
+
+uint64_t Server::get_dropped_robot_state_count()
+{
+  return impl->get_dropped_robot_state_count();
+}
+
+uint64_t Server::get_dropped_robot_state_count(const std::string& _fleet_name)
+{
+  return impl->get_dropped_robot_state_count(_fleet_name);
+}
+
 bool Server::send_mode_request(const messages::ModeRequest& _mode_request)
 {
   return impl->send_mode_request(_mode_request);
@@ -107,4 +261,31 @@ bool Server::send_destination_request(
   return impl->send_destination_request(_destination_request);
 }
 
+std::future<Server::RequestResult> Server::send_mode_request(
+    const messages::ModeRequest& _mode_request,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  return impl->send_mode_request(
+      _mode_request, _retry_policy, std::move(_callback));
+}
+
+std::future<Server::RequestResult> Server::send_path_request(
+    const messages::PathRequest& _path_request,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  return impl->send_path_request(
+      _path_request, _retry_policy, std::move(_callback));
+}
+
+std::future<Server::RequestResult> Server::send_destination_request(
+    const messages::DestinationRequest& _destination_request,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  return impl->send_destination_request(
+      _destination_request, _retry_policy, std::move(_callback));
+}
+
 } // namespace free_fleet
@@ -15,76 +15,591 @@
  *
  */
 
+#include <algorithm>
+
 #include "ServerImpl.hpp"
 #include "messages/message_utils.hpp"
 
 namespace free_fleet {
 
 Server::ServerImpl::ServerImpl(const ServerConfig& _config) :
+  name_table(messages::NameTable::make_generation()),
   server_config(_config)
 {}
 
 Server::ServerImpl::~ServerImpl()
 {
+  {
+    std::unique_lock<std::mutex> pending_lock(pending_requests_mutex);
+    stopping = true;
+  }
+  pending_requests_cv.notify_all();
+  if (retry_thread.joinable())
+    retry_thread.join();
+
   dds_return_t return_code = dds_delete(fields.participant);
   if (return_code != DDS_RETCODE_OK)
   {
     DDS_FATAL("dds_delete: %s", dds_strretcode(-return_code));
   }
+  if (fields.domain > 0)
+    dds_delete(fields.domain);
+
+  // No more acknowledgements can arrive at this point.
+  for (auto& pending_request : pending_requests)
+    complete(
+        pending_request.second, RequestResult::Status::Cancelled,
+        "server shut down");
 }
 
 void Server::ServerImpl::start(Fields _fields)
 {
   fields = std::move(_fields);
+
+  for (std::size_t i = 0; i < server_config.fleets.size(); ++i)
+    fleet_indices.emplace(server_config.fleets[i].fleet_name, i);
+
+  // The empty name is given the first id, so that clients learn about the
+  // new generation of ids right away, even before any other name is sent.
+  intern_name("");
+
+  fields.request_ack_sub->set_callback(
+      [this](const FreeFleetData_RequestAck& _dds_request_ack)
+      {
+        messages::RequestAck request_ack;
+        convert(_dds_request_ack, request_ack);
+        handle_request_ack(request_ack);
+      });
+}
+
+bool Server::ServerImpl::find_fleet_index(
+    const std::string& _fleet_name, std::size_t& _index) const
+{
+  auto it = fleet_indices.find(_fleet_name);
+  if (it == fleet_indices.end())
+    return false;
+  _index = it->second;
+  return true;
 }
 
 bool Server::ServerImpl::read_robot_states(
     std::vector<messages::RobotState>& _new_robot_states)
 {
-  auto robot_states = fields.robot_state_sub->read();
-  if (!robot_states.empty())
+  _new_robot_states.clear();
+  auto append = [this, &_new_robot_states](const auto& _dds_robot_state)
+  {
+    _new_robot_states.emplace_back();
+    convert(_dds_robot_state, _new_robot_states.back());
+    resolve_level_names(_new_robot_states.back());
+  };
+
+  size_t num_taken = 0;
+  for (const auto& robot_state_sub : fields.robot_state_subs)
+    num_taken += robot_state_sub->take_all(append);
+  for (const auto& robot_state_sub : fields.bounded_robot_state_subs)
+    num_taken += robot_state_sub->take_all(append);
+  return num_taken > 0;
+}
+
+template <typename Sub>
+std::size_t Server::ServerImpl::take_robot_states(
+    Sub& _robot_state_sub,
+    RobotStateArena& _arena,
+    std::vector<std::size_t>& _updated_indices)
+{
+  return _robot_state_sub.take_all(
+      [this, &_arena, &_updated_indices](const auto& _dds_robot_state)
+      {
+        std::size_t index;
+        messages::RobotState& robot_state =
+            _arena.update(_dds_robot_state.name, index);
+        convert(_dds_robot_state, robot_state);
+        resolve_level_names(robot_state);
+        _updated_indices.push_back(index);
+      });
+}
+
+void Server::ServerImpl::sort_updated_indices(
+    std::vector<std::size_t>& _updated_indices)
+{
+  // A robot is only taken more than once with a history depth above 1.
+  std::sort(_updated_indices.begin(), _updated_indices.end());
+  _updated_indices.erase(
+      std::unique(_updated_indices.begin(), _updated_indices.end()),
+      _updated_indices.end());
+}
+
+bool Server::ServerImpl::read_robot_states(
+    RobotStateArena& _arena, std::vector<std::size_t>& _updated_indices)
+{
+  _updated_indices.clear();
+  std::size_t num_taken = 0;
+  for (const auto& robot_state_sub : fields.robot_state_subs)
+    num_taken += take_robot_states(*robot_state_sub, _arena, _updated_indices);
+  for (const auto& robot_state_sub : fields.bounded_robot_state_subs)
+    num_taken += take_robot_states(*robot_state_sub, _arena, _updated_indices);
+  sort_updated_indices(_updated_indices);
+  return num_taken > 0;
+}
+
+bool Server::ServerImpl::read_robot_states(
+    const std::string& _fleet_name,
+    RobotStateArena& _arena,
+    std::vector<std::size_t>& _updated_indices)
+{
+  _updated_indices.clear();
+  std::size_t fleet_index;
+  if (!find_fleet_index(_fleet_name, fleet_index))
+    return false;
+
+  std::size_t num_taken = 0;
+  if (fleet_index < fields.robot_state_subs.size())
+    num_taken = take_robot_states(
+        *fields.robot_state_subs[fleet_index], _arena, _updated_indices);
+  if (fleet_index < fields.bounded_robot_state_subs.size())
+    num_taken = take_robot_states(
+        *fields.bounded_robot_state_subs[fleet_index], _arena,
+        _updated_indices);
+  sort_updated_indices(_updated_indices);
+  return num_taken > 0;
+}
+
+template <typename DDSRobotState>
+std::function<void(const DDSRobotState&)>
+    Server::ServerImpl::make_robot_state_callback(
+        RobotStateCallback _callback)
+{
+  return [this, _callback](const DDSRobotState& _dds_robot_state)
+  {
+    messages::RobotState robot_state;
+    convert(_dds_robot_state, robot_state);
+    resolve_level_names(robot_state);
+    _callback(robot_state);
+  };
+}
+
+uint32_t Server::ServerImpl::intern_name(const std::string& _name)
+{
+  if (!fields.name_id_pub)
+    return 0;
+
+  std::unique_lock<std::mutex> name_table_lock(name_table_mutex);
+  bool added;
+  const uint32_t id = name_table.intern(_name, added);
+  if (added)
+  {
+    FreeFleetData_NameId name_id_sample;
+    name_id_sample.name = const_cast<char*>(_name.c_str());
+    name_id_sample.id = id;
+    fields.name_id_pub->write(&name_id_sample);
+  }
+  return id;
+}
+
+void Server::ServerImpl::resolve_level_names(
+    messages::RobotState& _robot_state)
+{
+  if (!fields.name_id_pub)
+    return;
+
+  // Paths mostly stay on a single level, so most locations are resolved by
+  // the location before them, without looking anything up.
+  const messages::Location* previous = nullptr;
+  auto resolve = [this, &previous](messages::Location& _location)
   {
-    _new_robot_states.clear();
-    for (size_t i = 0; i < robot_states.size(); ++i)
+    if (previous && _location.level_id != 0 &&
+        _location.level_id == previous->level_id)
+      _location.level_name = previous->level_name;
+    else if (previous && _location.level_id == 0 &&
+        _location.level_name == previous->level_name)
+      _location.level_id = previous->level_id;
+    else if (_location.level_id != 0)
     {
-      messages::RobotState tmp_robot_state;
-      convert(*(robot_states[i]), tmp_robot_state);
-      _new_robot_states.push_back(tmp_robot_state);
+      // Ids of a previous generation are not known, the name is left empty
+      // until the client learned the ids of this generation.
+      name_table.find_name(_location.level_id, _location.level_name);
     }
-    return true;
+    else
+      _location.level_id = intern_name(_location.level_name);
+    previous = &_location;
+  };
+
+  resolve(_robot_state.location);
+  for (auto& location : _robot_state.path)
+    resolve(location);
+}
+
+template <typename Request, typename DDSRequest>
+void Server::ServerImpl::intern_request_names(
+    const Request& _request, DDSRequest& _sample)
+{
+  _sample.fleet_id = intern_name(_request.fleet_name);
+  _sample.robot_id = intern_name(_request.robot_name);
+}
+
+void Server::ServerImpl::intern_level_name(
+    const messages::Location& _location, FreeFleetData_Location& _sample)
+{
+  _sample.level_id = intern_name(_location.level_name);
+}
+
+bool Server::ServerImpl::set_robot_state_callback(
+    RobotStateCallback _callback)
+{
+  if (!_callback)
+    return false;
+
+  for (const auto& robot_state_sub : fields.robot_state_subs)
+  {
+    if (!robot_state_sub->set_callback(
+        make_robot_state_callback<FreeFleetData_RobotState>(_callback)))
+      return false;
+  }
+  for (const auto& robot_state_sub : fields.bounded_robot_state_subs)
+  {
+    if (!robot_state_sub->set_callback(
+        make_robot_state_callback<FreeFleetData_BoundedRobotState>(
+            _callback)))
+      return false;
   }
-  return false;
+  return true;
+}
+
+bool Server::ServerImpl::set_robot_state_callback(
+    const std::string& _fleet_name, RobotStateCallback _callback)
+{
+  std::size_t fleet_index;
+  if (!_callback || !find_fleet_index(_fleet_name, fleet_index))
+    return false;
+
+  if (fleet_index < fields.bounded_robot_state_subs.size())
+    return fields.bounded_robot_state_subs[fleet_index]->set_callback(
+        make_robot_state_callback<FreeFleetData_BoundedRobotState>(
+            std::move(_callback)));
+  return fields.robot_state_subs[fleet_index]->set_callback(
+      make_robot_state_callback<FreeFleetData_RobotState>(
+          std::move(_callback)));
+}
+
+void Server::ServerImpl::clear_robot_state_callback(
+    const std::string& _fleet_name)
+{
+  std::size_t fleet_index;
+  if (!find_fleet_index(_fleet_name, fleet_index))
+    return;
+
+  if (fleet_index < fields.bounded_robot_state_subs.size())
+    fields.bounded_robot_state_subs[fleet_index]->clear_callback();
+  else
+    fields.robot_state_subs[fleet_index]->clear_callback();
+}
+
+bool Server::ServerImpl::wait_for_robot_states(
+    const std::string& _fleet_name, double _timeout)
+{
+  std::size_t fleet_index;
+  if (!find_fleet_index(_fleet_name, fleet_index))
+    return false;
+
+  const dds_duration_t timeout = static_cast<dds_duration_t>(_timeout * 1e9);
+  if (fleet_index < fields.bounded_robot_state_subs.size())
+    return fields.bounded_robot_state_subs[fleet_index]->wait(timeout);
+  return fields.robot_state_subs[fleet_index]->wait(timeout);
+}
+
+uint64_t Server::ServerImpl::get_dropped_robot_state_count()
+{
+  uint64_t dropped_count = 0;
+  for (const auto& robot_state_sub : fields.robot_state_subs)
+    dropped_count += robot_state_sub->get_dropped_count();
+  for (const auto& robot_state_sub : fields.bounded_robot_state_subs)
+    dropped_count += robot_state_sub->get_dropped_count();
+  return dropped_count;
+}
+
+uint64_t Server::ServerImpl::get_dropped_robot_state_count(
+    const std::string& _fleet_name)
+{
+  std::size_t fleet_index;
+  if (!find_fleet_index(_fleet_name, fleet_index))
+    return 0;
+  if (fleet_index < fields.bounded_robot_state_subs.size())
+    return fields.bounded_robot_state_subs[fleet_index]->get_dropped_count();
+  return fields.robot_state_subs[fleet_index]->get_dropped_count();
 }
 
 bool Server::ServerImpl::send_mode_request(
     const messages::ModeRequest& _mode_request)
 {
-  FreeFleetData_ModeRequest* new_mr = FreeFleetData_ModeRequest__alloc();
-  convert(_mode_request, *new_mr);
-  bool sent = fields.mode_request_pub->write(new_mr);
-  FreeFleetData_ModeRequest_free(new_mr, DDS_FREE_ALL);
-  return sent;
+  std::unique_lock<std::mutex> send_lock(send_mutex);
+  convert(_mode_request, mode_request_sample, mode_parameters_buffer);
+  intern_request_names(_mode_request, mode_request_sample);
+  return fields.mode_request_pub->write(&mode_request_sample);
 }
 
 bool Server::ServerImpl::send_path_request(
     const messages::PathRequest& _path_request)
 {
-  FreeFleetData_PathRequest* new_pr = FreeFleetData_PathRequest__alloc();
-  convert(_path_request, *new_pr);
-  bool sent = fields.path_request_pub->write(new_pr);
-  FreeFleetData_PathRequest_free(new_pr, DDS_FREE_ALL);
-  return sent;
+  std::unique_lock<std::mutex> send_lock(send_mutex);
+  convert(_path_request, path_request_sample, path_buffer);
+  intern_request_names(_path_request, path_request_sample);
+  for (std::size_t i = 0; i < _path_request.path.size(); ++i)
+    intern_level_name(
+        _path_request.path[i], path_request_sample.path._buffer[i]);
+  if (server_config.dds_compact_path)
+    messages::compact_path(path_request_sample, compact_path_buffer);
+  return fields.path_request_pub->write(&path_request_sample);
 }
 
 bool Server::ServerImpl::send_destination_request(
     const messages::DestinationRequest& _destination_request)
 {
-  FreeFleetData_DestinationRequest* new_dr = 
-      FreeFleetData_DestinationRequest__alloc();
-  convert(_destination_request, *new_dr);
-  bool sent = fields.destination_request_pub->write(new_dr);
-  FreeFleetData_DestinationRequest_free(new_dr, DDS_FREE_ALL);
-  return sent;
+  std::unique_lock<std::mutex> send_lock(send_mutex);
+  convert(_destination_request, destination_request_sample);
+  intern_request_names(_destination_request, destination_request_sample);
+  intern_level_name(
+      _destination_request.destination,
+      destination_request_sample.destination);
+  return fields.destination_request_pub->write(&destination_request_sample);
+}
+
+std::future<Server::RequestResult> Server::ServerImpl::send_mode_request(
+    const messages::ModeRequest& _mode_request,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  return send_with_retry(
+      messages::RequestAck::REQUEST_MODE, _mode_request.fleet_name,
+      _mode_request.robot_name, _mode_request.task_id,
+      [this, _mode_request]() { return send_mode_request(_mode_request); },
+      _retry_policy,
+      std::move(_callback));
+}
+
+std::future<Server::RequestResult> Server::ServerImpl::send_path_request(
+    const messages::PathRequest& _path_request,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  return send_with_retry(
+      messages::RequestAck::REQUEST_PATH, _path_request.fleet_name,
+      _path_request.robot_name, _path_request.task_id,
+      [this, _path_request]() { return send_path_request(_path_request); },
+      _retry_policy,
+      std::move(_callback));
+}
+
+std::future<Server::RequestResult> 
+    Server::ServerImpl::send_destination_request(
+        const messages::DestinationRequest& _destination_request,
+        const RetryPolicy& _retry_policy,
+        RequestResultCallback _callback)
+{
+  return send_with_retry(
+      messages::RequestAck::REQUEST_DESTINATION,
+      _destination_request.fleet_name, _destination_request.robot_name,
+      _destination_request.task_id,
+      [this, _destination_request]()
+      {
+        return send_destination_request(_destination_request);
+      },
+      _retry_policy,
+      std::move(_callback));
+}
+
+std::string Server::ServerImpl::make_request_key(
+    uint32_t _request_type,
+    const std::string& _fleet_name,
+    const std::string& _robot_name,
+    const std::string& _task_id)
+{
+  return std::to_string(_request_type) + "/" + _fleet_name + "/" + 
+      _robot_name + "/" + _task_id;
+}
+
+void Server::ServerImpl::complete(
+    PendingRequest& _pending_request,
+    RequestResult::Status _status,
+    const std::string& _reason)
+{
+  RequestResult result;
+  result.status = _status;
+  result.reason = _reason;
+  result.attempts = _pending_request.attempts;
+  result.latency = std::chrono::duration<double>(
+      Clock::now() - _pending_request.start_time).count();
+
+  if (_pending_request.callback)
+    _pending_request.callback(result);
+  _pending_request.promise.set_value(std::move(result));
+}
+
+std::future<Server::RequestResult> Server::ServerImpl::send_with_retry(
+    uint32_t _request_type,
+    const std::string& _fleet_name,
+    const std::string& _robot_name,
+    const std::string& _task_id,
+    std::function<bool()> _send,
+    const RetryPolicy& _retry_policy,
+    RequestResultCallback _callback)
+{
+  const std::string key =
+      make_request_key(_request_type, _fleet_name, _robot_name, _task_id);
+
+  // Path and destination requests both tell the robot where to go next, so
+  // either of them supersedes pending requests of both types.
+  const uint32_t supersede_type =
+      _request_type == messages::RequestAck::REQUEST_DESTINATION ?
+          messages::RequestAck::REQUEST_PATH : _request_type;
+
+  PendingRequest pending_request;
+  pending_request.robot_key =
+      make_request_key(supersede_type, _fleet_name, _robot_name, "");
+  pending_request.send = _send;
+  pending_request.retry_policy = _retry_policy;
+  pending_request.start_time = Clock::now();
+  pending_request.callback = std::move(_callback);
+  std::future<RequestResult> future = pending_request.promise.get_future();
+
+  // Registered before the first send, so that an acknowledgement arriving
+  // right away is not missed. A failed send is retried like a lost one.
+  std::vector<PendingRequest> superseded_requests;
+  bool send_now = true;
+  {
+    std::unique_lock<std::mutex> pending_lock(pending_requests_mutex);
+
+    // Only the newest mode request, or the newest path or destination
+    // request, to a robot is worth sending, older ones that are still
+    // pending would undo it when sent again.
+    for (auto it = pending_requests.begin(); it != pending_requests.end();)
+    {
+      if (it->second.robot_key != pending_request.robot_key)
+      {
+        ++it;
+        continue;
+      }
+      superseded_requests.push_back(std::move(it->second));
+      it = pending_requests.erase(it);
+    }
+
+    const auto coalesce_window = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(_retry_policy.coalesce_window));
+    auto last_send_time = last_send_times.find(pending_request.robot_key);
+    if (last_send_time != last_send_times.end() &&
+        pending_request.start_time < last_send_time->second + coalesce_window)
+    {
+      // Sent by the retry thread once the window has passed, unless a newer
+      // request supersedes it before then.
+      send_now = false;
+      pending_request.attempts = 0;
+      pending_request.deadline = last_send_time->second + coalesce_window;
+    }
+    else
+    {
+      pending_request.attempts = 1;
+      pending_request.deadline = pending_request.start_time +
+          std::chrono::duration_cast<Clock::duration>(
+              std::chrono::duration<double>(_retry_policy.timeout));
+      last_send_times[pending_request.robot_key] = pending_request.start_time;
+    }
+    pending_requests.emplace(key, std::move(pending_request));
+
+    if (!retry_thread.joinable())
+      retry_thread = std::thread(&ServerImpl::retry_thread_fn, this);
+  }
+  pending_requests_cv.notify_all();
+
+  for (auto& superseded_request : superseded_requests)
+    complete(
+        superseded_request, RequestResult::Status::Cancelled,
+        superseded_request.attempts == 0 ?
+            "superseded before being sent" : "superseded by a newer request");
+
+  if (send_now)
+    _send();
+  return future;
+}
+
+void Server::ServerImpl::handle_request_ack(
+    const messages::RequestAck& _request_ack)
+{
+  PendingRequest pending_request;
+  {
+    std::unique_lock<std::mutex> pending_lock(pending_requests_mutex);
+    auto it = pending_requests.find(
+        make_request_key(
+            _request_ack.request_type, _request_ack.fleet_name,
+            _request_ack.robot_name, _request_ack.task_id));
+    if (it == pending_requests.end())
+      return;
+    pending_request = std::move(it->second);
+    pending_requests.erase(it);
+  }
+
+  complete(
+      pending_request,
+      _request_ack.accepted ? 
+          RequestResult::Status::Accepted : RequestResult::Status::Rejected,
+      _request_ack.reason);
+}
+
+void Server::ServerImpl::retry_thread_fn()
+{
+  std::unique_lock<std::mutex> pending_lock(pending_requests_mutex);
+  while (!stopping)
+  {
+    const Clock::time_point now = Clock::now();
+    Clock::time_point next_deadline = Clock::time_point::max();
+    std::vector<std::function<bool()>> resends;
+    std::vector<PendingRequest> timed_out_requests;
+
+    for (auto it = pending_requests.begin(); it != pending_requests.end();)
+    {
+      PendingRequest& pending_request = it->second;
+      if (pending_request.deadline <= now)
+      {
+        // Held back by the coalescing window until now.
+        if (pending_request.attempts == 0)
+          last_send_times[pending_request.robot_key] = now;
+        else if (pending_request.attempts >= 
+            pending_request.retry_policy.max_attempts)
+        {
+          timed_out_requests.push_back(std::move(pending_request));
+          it = pending_requests.erase(it);
+          continue;
+        }
+
+        ++pending_request.attempts;
+        pending_request.deadline = now + 
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(
+                    pending_request.retry_policy.timeout));
+        resends.push_back(pending_request.send);
+      }
+      next_deadline = std::min(next_deadline, pending_request.deadline);
+      ++it;
+    }
+
+    if (resends.empty() && timed_out_requests.empty())
+    {
+      if (pending_requests.empty())
+        pending_requests_cv.wait(pending_lock);
+      else
+        pending_requests_cv.wait_until(pending_lock, next_deadline);
+      continue;
+    }
+
+    // Sending and completing happens without holding on to the lock, so that
+    // acknowledgements and new requests are not held up.
+    pending_lock.unlock();
+    for (const auto& resend : resends)
+      resend();
+    for (auto& timed_out_request : timed_out_requests)
+      complete(
+          timed_out_request, RequestResult::Status::TimedOut,
+          "no acknowledgement received");
+    pending_lock.lock();
+  }
 }
 
 } // namespace free_fleet
@@ -18,15 +18,26 @@
 #ifndef FREE_FLEET__SRC__SERVERIMPL_HPP
 #define FREE_FLEET__SRC__SERVERIMPL_HPP
 
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+
 #include <free_fleet/messages/RobotState.hpp>
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 #include <free_fleet/Server.hpp>
 #include <free_fleet/ServerConfig.hpp>
 
 #include <dds/dds.h>
 
+#include "messages/NameTable.hpp"
 #include "messages/FleetMessages.h"
 #include "dds_utils/DDSPublishHandler.hpp"
 #include "dds_utils/DDSSubscribeHandler.hpp"
@@ -37,15 +48,29 @@ class Server::ServerImpl
 {
 public:
 
+  using RobotStateSub = dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>;
+
+  using BoundedRobotStateSub =
+      dds::DDSSubscribeHandler<FreeFleetData_BoundedRobotState, 10>;
+
   /// DDS related fields required for the server to operate
   struct Fields
   {
     /// DDS participant that is tied to the configured dds_domain_id
     dds_entity_t participant;
 
-    /// DDS subscribers for new incoming robot states from clients
-    dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>::SharedPtr 
-        robot_state_sub;
+    /// DDS domain created for shared memory along with the participant, 0 if
+    /// none was
+    dds_entity_t domain;
+
+    /// DDS subscribers for new incoming robot states from clients, one for
+    /// every configured fleet, in the same order
+    std::vector<RobotStateSub::SharedPtr> robot_state_subs;
+
+    /// DDS subscribers used instead of robot_state_subs when robot states
+    /// are sent as fixed size samples, one for every configured fleet, in
+    /// the same order
+    std::vector<BoundedRobotStateSub::SharedPtr> bounded_robot_state_subs;
 
     /// DDS publisher for mode requests to be sent to clients
     dds::DDSPublishHandler<FreeFleetData_ModeRequest>::SharedPtr
@@ -58,6 +83,14 @@ public:
     /// DDS publisher for destination requests to be sent to clients
     dds::DDSPublishHandler<FreeFleetData_DestinationRequest>::SharedPtr
         destination_request_pub;
+
+    /// DDS subscriber for acknowledgements of requests from clients
+    dds::DDSSubscribeHandler<FreeFleetData_RequestAck, 10>::SharedPtr
+        request_ack_sub;
+
+    /// DDS publisher for the ids given to names, null if names are only
+    /// sent as strings
+    dds::DDSPublishHandler<FreeFleetData_NameId>::SharedPtr name_id_pub;
   };
 
   ServerImpl(const ServerConfig& config);
@@ -68,6 +101,27 @@ public:
 
   bool read_robot_states(std::vector<messages::RobotState>& new_robot_states);
 
+  bool read_robot_states(
+      RobotStateArena& arena, std::vector<std::size_t>& updated_indices);
+
+  bool read_robot_states(
+      const std::string& fleet_name,
+      RobotStateArena& arena,
+      std::vector<std::size_t>& updated_indices);
+
+  bool set_robot_state_callback(RobotStateCallback callback);
+
+  bool set_robot_state_callback(
+      const std::string& fleet_name, RobotStateCallback callback);
+
+  void clear_robot_state_callback(const std::string& fleet_name);
+
+  bool wait_for_robot_states(const std::string& fleet_name, double timeout);
+
+  uint64_t get_dropped_robot_state_count();
+
+  uint64_t get_dropped_robot_state_count(const std::string& fleet_name);
+
   bool send_mode_request(const messages::ModeRequest& mode_request);
 
   bool send_path_request(const messages::PathRequest& path_request);
@@ -75,8 +129,146 @@ public:
   bool send_destination_request(
       const messages::DestinationRequest& destination_request);
 
+  std::future<RequestResult> send_mode_request(
+      const messages::ModeRequest& mode_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback);
+
+  std::future<RequestResult> send_path_request(
+      const messages::PathRequest& path_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback);
+
+  std::future<RequestResult> send_destination_request(
+      const messages::DestinationRequest& destination_request,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback);
+
 private:
 
+  using Clock = std::chrono::steady_clock;
+
+  /// Gets the index of a fleet into the robot state subscribers, false if
+  /// the fleet is not served.
+  bool find_fleet_index(const std::string& fleet_name, std::size_t& index)
+      const;
+
+  /// Takes the new robot states of one subscriber into the arena, without
+  /// sorting the updated indices.
+  template <typename Sub>
+  std::size_t take_robot_states(
+      Sub& robot_state_sub,
+      RobotStateArena& arena,
+      std::vector<std::size_t>& updated_indices);
+
+  static void sort_updated_indices(std::vector<std::size_t>& updated_indices);
+
+  /// Converts every robot state and fills in its level names before handing
+  /// it to the callback.
+  template <typename DDSRobotState>
+  std::function<void(const DDSRobotState&)> make_robot_state_callback(
+      RobotStateCallback callback);
+
+  /// Gets the id of a name, giving it one and publishing it if it has none
+  /// yet.
+  ///
+  /// \return
+  ///   Id of the name, 0 if names are only sent as strings.
+  uint32_t intern_name(const std::string& name);
+
+  /// Fills in the names of level ids sent by a client, and gives ids to the
+  /// level names sent as strings, so that the client can send them as ids
+  /// from then on.
+  void resolve_level_names(messages::RobotState& robot_state);
+
+  /// Adds the ids of the names to a request, the names themselves are still
+  /// sent for clients that did not learn the ids yet.
+  template <typename Request, typename DDSRequest>
+  void intern_request_names(const Request& request, DDSRequest& sample);
+
+  void intern_level_name(
+      const messages::Location& location, FreeFleetData_Location& sample);
+
+  /// Guards giving out and publishing ids.
+  std::mutex name_table_mutex;
+
+  messages::NameTable name_table;
+
+  /// Index of every fleet into the robot state subscribers.
+  std::unordered_map<std::string, std::size_t> fleet_indices;
+
+  /// Request that was sent with a retry policy and is waiting to be
+  /// acknowledged.
+  struct PendingRequest
+  {
+    /// Key of the robot the request is targetted towards and of the requests
+    /// it supersedes, path and destination requests share theirs.
+    std::string robot_key;
+    std::function<bool()> send;
+    RetryPolicy retry_policy;
+
+    /// Zero while the request is held back by the coalescing window.
+    uint32_t attempts;
+    Clock::time_point start_time;
+    Clock::time_point deadline;
+    std::promise<RequestResult> promise;
+    RequestResultCallback callback;
+  };
+
+  static std::string make_request_key(
+      uint32_t request_type,
+      const std::string& fleet_name,
+      const std::string& robot_name,
+      const std::string& task_id);
+
+  static void complete(
+      PendingRequest& pending_request,
+      RequestResult::Status status,
+      const std::string& reason);
+
+  std::future<RequestResult> send_with_retry(
+      uint32_t request_type,
+      const std::string& fleet_name,
+      const std::string& robot_name,
+      const std::string& task_id,
+      std::function<bool()> send,
+      const RetryPolicy& retry_policy,
+      RequestResultCallback callback);
+
+  void handle_request_ack(const messages::RequestAck& request_ack);
+
+  void retry_thread_fn();
+
+  /// DDS samples reused for every request sent, guarded by send_mutex, see
+  /// messages::convert.
+  std::mutex send_mutex;
+
+  FreeFleetData_ModeRequest mode_request_sample;
+
+  std::vector<FreeFleetData_ModeParameter> mode_parameters_buffer;
+
+  FreeFleetData_PathRequest path_request_sample;
+
+  std::vector<FreeFleetData_Location> path_buffer;
+
+  std::vector<uint8_t> compact_path_buffer;
+
+  FreeFleetData_DestinationRequest destination_request_sample;
+
+  std::mutex pending_requests_mutex;
+
+  std::condition_variable pending_requests_cv;
+
+  std::map<std::string, PendingRequest> pending_requests;
+
+  /// When a request of a type was last sent to a robot for the first time,
+  /// by the key of both, see RetryPolicy::coalesce_window.
+  std::unordered_map<std::string, Clock::time_point> last_send_times;
+
+  std::thread retry_thread;
+
+  bool stopping = false;
+
   Fields fields;
 
   ServerConfig server_config;
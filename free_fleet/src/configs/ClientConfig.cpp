@@ -25,12 +25,36 @@ void ClientConfig::print_config() const
 {
   printf("CLIENT-SERVER DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds shared memory: %s\n", dds_shared_memory ? "true" : "false");
+  printf("  dds bounded robot state: %s\n",
+      dds_bounded_robot_state ? "true" : "false");
+  printf("  dds compact path: %s\n", dds_compact_path ? "true" : "false");
+  printf("  adaptive state publishing: %s\n",
+      adaptive_state_publishing ? "true" : "false");
+  if (adaptive_state_publishing)
+  {
+    printf("    heartbeat period: %.2f s\n", state_heartbeat_period);
+    printf("    min period: %.2f s\n", state_min_period);
+    printf("    position threshold: %.3f m\n", state_position_threshold);
+    printf("    yaw threshold: %.3f rad\n", state_yaw_threshold);
+    printf("    battery threshold: %.1f %%\n", state_battery_threshold);
+  }
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("    name id: %s\n", dds_name_id_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("    request ack: %s\n", dds_request_ack_qos.to_string().c_str());
+  printf("    name id: %s\n", dds_name_id_qos.to_string().c_str());
 }
 
 } // namespace free_fleet
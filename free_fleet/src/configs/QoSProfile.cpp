@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <free_fleet/QoSProfile.hpp>
+
+#include <cstdio>
+
+namespace free_fleet {
+
+QoSProfile QoSProfile::state_stream()
+{
+  QoSProfile profile;
+  profile.reliability = Reliability::BestEffort;
+  profile.history_depth = 1;
+  profile.durability = Durability::Volatile;
+  profile.max_samples = 1000;
+  return profile;
+}
+
+QoSProfile QoSProfile::command_reliable()
+{
+  QoSProfile profile;
+  profile.reliability = Reliability::Reliable;
+  profile.history_depth = 10;
+  profile.durability = Durability::Volatile;
+  profile.transport_priority = 1;
+  return profile;
+}
+
+QoSProfile QoSProfile::command_urgent()
+{
+  QoSProfile profile = command_reliable();
+  profile.transport_priority = 2;
+  return profile;
+}
+
+QoSProfile QoSProfile::name_table()
+{
+  QoSProfile profile;
+  profile.reliability = Reliability::Reliable;
+  profile.history_depth = 1;
+  profile.durability = Durability::TransientLocal;
+  return profile;
+}
+
+bool QoSProfile::from_preset(const std::string& _name, QoSProfile& _profile)
+{
+  if (_name == "state_stream")
+    _profile = state_stream();
+  else if (_name == "command_reliable")
+    _profile = command_reliable();
+  else if (_name == "command_urgent")
+    _profile = command_urgent();
+  else if (_name == "name_table")
+    _profile = name_table();
+  else
+    return false;
+  return true;
+}
+
+std::string QoSProfile::to_string() const
+{
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer),
+      "%s, depth %d, %s, deadline %.3fs, latency budget %.3fs, "
+      "priority %d, limits %d/%d/%d",
+      reliability == Reliability::Reliable ? "reliable" : "best effort",
+      history_depth,
+      durability == Durability::TransientLocal ? "transient local" :
+          "volatile",
+      deadline, latency_budget, transport_priority,
+      max_samples, max_instances, max_samples_per_instance);
+  return std::string(buffer);
+}
+
+} // namespace free_fleet
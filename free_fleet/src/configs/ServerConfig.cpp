@@ -25,12 +25,29 @@ void ServerConfig::print_config() const
 {
   printf("SERVER-CLIENT DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds shared memory: %s\n", dds_shared_memory ? "true" : "false");
+  printf("  dds bounded robot state: %s\n",
+      dds_bounded_robot_state ? "true" : "false");
+  printf("  dds compact path: %s\n", dds_compact_path ? "true" : "false");
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_robot_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("    name id: %s\n", dds_name_id_topic.c_str());
+  for (const auto& fleet : fleets)
+    printf("    robot state of fleet %s: %s\n",
+        fleet.fleet_name.c_str(), fleet.dds_robot_state_topic.c_str());
+  printf("  QOS\n");
+  printf("    robot state: %s\n", dds_robot_state_qos.to_string().c_str());
+  printf("    mode request: %s\n", dds_mode_request_qos.to_string().c_str());
+  printf("    path request: %s\n", dds_path_request_qos.to_string().c_str());
+  printf("    destination request: %s\n",
+      dds_destination_request_qos.to_string().c_str());
+  printf("    request ack: %s\n", dds_request_ack_qos.to_string().c_str());
+  printf("    name id: %s\n", dds_name_id_qos.to_string().c_str());
 }
 
 } // namespace free_fleet
@@ -22,6 +22,10 @@
 
 #include <dds/dds.h>
 
+#include <free_fleet/QoSProfile.hpp>
+
+#include "common.hpp"
+
 namespace free_fleet {
 namespace dds {
 
@@ -44,12 +48,16 @@ private:
 
   bool ready;
 
+  /// Reused by write_loaned when samples cannot be loaned.
+  std::unique_ptr<Message> owned_sample;
+
 public:
 
   DDSPublishHandler(
       const dds_entity_t& _participant,
       const dds_topic_descriptor_t* _topic_desc,
-      const std::string& _topic_name) :
+      const std::string& _topic_name,
+      const QoSProfile& _qos = QoSProfile()) :
     topic_desc(_topic_desc)
   {
     ready = false;
@@ -62,15 +70,14 @@ public:
       return;
     }
 
-    dds_qos_t* qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+    dds_qos_t* qos = common::dds_qos_create(_qos);
     writer = dds_create_writer(_participant, topic, qos, NULL);
+    dds_delete_qos(qos);
     if (writer < 0)
     {
       DDS_FATAL("dds_create_writer: %s\n", dds_strretcode(-writer));
       return;
     }
-    dds_delete_qos(qos);
 
     ready = true;
   }
@@ -94,6 +101,36 @@ public:
     return true;
   }
 
+  /// Fills a sample in place and writes it. The sample is loaned from the
+  /// writer when the transport supports it, so that fixed size samples are
+  /// handed over without being copied, otherwise a sample owned by this
+  /// handler is reused. Loans need CycloneDDS 0.9 or newer, older releases
+  /// always reuse the owned sample. Only meant for fixed size messages, as
+  /// the sample is never freed.
+  ///
+  /// \param[in] fill
+  ///   Function that fills every field of the sample.
+  /// \return
+  ///   True if the sample was written, false otherwise.
+  template <typename Fill>
+  bool write_loaned(const Fill& _fill)
+  {
+#ifdef FREE_FLEET_DDS_SHARED_MEMORY
+    void* loaned_sample = NULL;
+    if (dds_loan_sample(writer, &loaned_sample) == DDS_RETCODE_OK)
+    {
+      Message* msg = static_cast<Message*>(loaned_sample);
+      _fill(*msg);
+      return write(msg);
+    }
+#endif
+
+    if (!owned_sample)
+      owned_sample.reset(new Message());
+    _fill(*owned_sample);
+    return write(owned_sample.get());
+  }
+
 };
 
 } // namespace dds
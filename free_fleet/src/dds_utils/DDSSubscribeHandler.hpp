@@ -18,11 +18,17 @@
 #ifndef FREE_FLEET__SRC__DDS_UTILS__DDSSUBSCRIBEHANDLER_HPP
 #define FREE_FLEET__SRC__DDS_UTILS__DDSSUBSCRIBEHANDLER_HPP
 
+#include <mutex>
 #include <memory>
 #include <vector>
+#include <functional>
 
 #include <dds/dds.h>
 
+#include <free_fleet/QoSProfile.hpp>
+
+#include "common.hpp"
+
 namespace free_fleet {
 namespace dds {
 
@@ -33,6 +39,74 @@ public:
 
   using SharedPtr = std::shared_ptr<DDSSubscribeHandler>;
 
+  /// Callback that gets triggered for every valid sample, as soon as it
+  /// arrives. This is called from a CycloneDDS listener thread.
+  using Callback = std::function<void(const Message&)>;
+
+  /// Callback that gets triggered once every sample that was waiting in the
+  /// reader has been handed to the Callback, from the same thread.
+  using DrainedCallback = std::function<void()>;
+
+  /// Samples loaned from the reader by a single take. The samples, including
+  /// any strings and sequences they own, remain valid until the loan is
+  /// destroyed, at which point they are handed back to the reader to be
+  /// reused by later takes.
+  class Loan
+  {
+  public:
+
+    explicit Loan(dds_entity_t _reader) :
+      reader(_reader),
+      size(0)
+    {
+      // A null first buffer has dds_take loan out samples from the reader,
+      // instead of deserializing into memory owned by us.
+      samples[0] = NULL;
+    }
+
+    ~Loan()
+    {
+      if (size > 0)
+        dds_return_loan(reader, samples, size);
+    }
+
+    Loan(const Loan&) = delete;
+
+    Loan& operator=(const Loan&) = delete;
+
+    dds_return_t take()
+    {
+      size = dds_take(reader, samples, infos, MaxSamplesNum, MaxSamplesNum);
+      return size;
+    }
+
+    bool is_valid(dds_return_t _index) const
+    {
+      return infos[_index].valid_data;
+    }
+
+    const Message& get(dds_return_t _index) const
+    {
+      return *static_cast<const Message*>(samples[_index]);
+    }
+
+    dds_return_t get_size() const
+    {
+      return size > 0 ? size : 0;
+    }
+
+  private:
+
+    dds_entity_t reader;
+
+    void* samples[MaxSamplesNum];
+
+    dds_sample_info_t infos[MaxSamplesNum];
+
+    dds_return_t size;
+
+  };
+
 private:
 
   dds_return_t return_code;
@@ -42,21 +116,74 @@ private:
   dds_entity_t topic;
   
   dds_entity_t reader;
-  
-  std::array<std::shared_ptr<Message>, MaxSamplesNum> shared_msgs;
 
-  void* samples[MaxSamplesNum];
+  /// Triggered while samples are waiting in the reader, see wait().
+  dds_entity_t waitset;
+
+  dds_entity_t read_condition;
+
+  std::mutex take_mutex;
+
+  Callback callback;
 
-  dds_sample_info_t infos[MaxSamplesNum];
+  DrainedCallback drained_callback;
 
   bool ready;
 
+  static void on_data_available(dds_entity_t _reader, void* _arg)
+  {
+    (void)_reader;
+    auto handler = static_cast<DDSSubscribeHandler*>(_arg);
+    std::unique_lock<std::mutex> take_lock(handler->take_mutex);
+    handler->drain(handler->callback);
+    if (handler->drained_callback)
+      handler->drained_callback();
+  }
+
+  /// Takes samples in batches of MaxSamplesNum until the reader is empty,
+  /// visiting each valid sample before its loan is returned. Expects
+  /// take_mutex to be held.
+  size_t drain(const Callback& _visitor)
+  {
+    size_t num_visited = 0;
+    while (true)
+    {
+      Loan loan(reader);
+      return_code = loan.take();
+      if (return_code < 0)
+      {
+        DDS_ERROR("dds_take: %s\n", dds_strretcode(-return_code));
+        return num_visited;
+      }
+
+      for (dds_return_t i = 0; i < return_code; ++i)
+      {
+        if (loan.is_valid(i) && _visitor)
+        {
+          _visitor(loan.get(i));
+          ++num_visited;
+        }
+      }
+
+      if (return_code < static_cast<dds_return_t>(MaxSamplesNum))
+        return num_visited;
+    }
+  }
+
 public:
 
+  /// Constructor
+  ///
+  /// \param[in] qos
+  ///   Quality of service of the reader. The history depth applies to every
+  ///   instance separately, so for keyed topics the newest samples of every
+  ///   key are kept until they are taken. Samples arriving while the resource
+  ///   limits are reached are rejected and counted by get_dropped_count().
   DDSSubscribeHandler(
       const dds_entity_t& _participant, 
       const dds_topic_descriptor_t* _topic_desc, 
-      const std::string& _topic_name) :
+      const std::string& _topic_name,
+      const QoSProfile& _qos = QoSProfile()) :
     topic_desc(_topic_desc)
   {
     ready = false;
@@ -70,58 +197,195 @@ public:
       return;
     }
 
-    dds_qos_t* qos = dds_create_qos();
-    dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+    dds_qos_t* qos = common::dds_qos_create(_qos);
     reader = dds_create_reader(_participant, topic, qos, NULL);
+    dds_delete_qos(qos);
     if (reader < 0)
     {
       DDS_FATAL(
           "dds_create_reader: %s\n", dds_strretcode(-reader));
       return;
     }
-    dds_delete_qos(qos);
 
-    for (size_t i = 0; i < shared_msgs.size(); ++i)
+    waitset = dds_create_waitset(_participant);
+    read_condition = dds_create_readcondition(reader, DDS_ANY_STATE);
+    if (waitset < 0 || read_condition < 0 ||
+        dds_waitset_attach(waitset, read_condition, reader) != DDS_RETCODE_OK)
     {
-      shared_msgs[i] = std::shared_ptr<Message>((Message*)dds_alloc(sizeof(Message)));
-      samples[i] = (void*)shared_msgs[i].get();
+      DDS_FATAL("dds_waitset_attach: unable to wait for the reader\n");
+      return;
     }
 
     ready = true;
   }
 
   ~DDSSubscribeHandler()
-  {}
+  {
+    // Blocks until any listener callback in progress has returned. This might
+    // fail if the reader was already deleted with its participant, in which
+    // case no more callbacks will be triggered anyway.
+    if (callback)
+      dds_set_listener(reader, NULL);
+  }
 
   bool is_ready()
   {
     return ready;
   }
 
+  /// Attaches a data available listener to the reader, so that new samples
+  /// are pushed to the callback as soon as they arrive, instead of waiting for
+  /// the next call to read().
+  ///
+  /// \param[in] callback
+  ///   Function to be called for every new valid sample.
+  /// \param[in] drained_callback
+  ///   Function to be called once the samples that arrived together were
+  ///   all handed to the callback, optional.
+  /// \return
+  ///   True if the listener was successfully attached, false otherwise.
+  bool set_callback(
+      Callback _callback, DrainedCallback _drained_callback = nullptr)
+  {
+    if (!is_ready() || !_callback)
+      return false;
+
+    {
+      std::unique_lock<std::mutex> take_lock(take_mutex);
+      callback = std::move(_callback);
+      drained_callback = std::move(_drained_callback);
+    }
+
+    dds_listener_t* listener = dds_create_listener(this);
+    dds_lset_data_available(listener, on_data_available);
+    dds_return_t listener_code = dds_set_listener(reader, listener);
+    dds_delete_listener(listener);
+    if (listener_code != DDS_RETCODE_OK)
+    {
+      // Not fatal, callers fall back to polling with read() or take_all().
+      DDS_ERROR("dds_set_listener: %s\n", dds_strretcode(-listener_code));
+      std::unique_lock<std::mutex> take_lock(take_mutex);
+      callback = nullptr;
+      drained_callback = nullptr;
+      return false;
+    }
+
+    // Samples that arrived before the listener was attached will not
+    // trigger it, handle them now.
+    std::unique_lock<std::mutex> take_lock(take_mutex);
+    drain(callback);
+    if (drained_callback)
+      drained_callback();
+    return true;
+  }
+
+  /// Detaches the listener attached with set_callback(), blocking until any
+  /// callback in progress has returned, so that whatever the callback
+  /// captured can be destroyed right after.
+  void clear_callback()
+  {
+    if (!is_ready())
+      return;
+
+    dds_set_listener(reader, NULL);
+    std::unique_lock<std::mutex> take_lock(take_mutex);
+    callback = nullptr;
+    drained_callback = nullptr;
+  }
+
+  /// Blocks until samples are waiting to be taken, or the timeout passes.
+  /// Lets a thread of its own take samples as soon as they arrive, instead
+  /// of a listener, whose thread is shared by every reader of the
+  /// participant. Not to be combined with set_callback().
+  ///
+  /// \param[in] timeout
+  ///   Maximum time to wait, in nanoseconds.
+  /// \return
+  ///   True if samples are waiting, false if the timeout passed first.
+  bool wait(dds_duration_t _timeout)
+  {
+    if (!is_ready())
+      return false;
+
+    const dds_return_t num_triggered =
+        dds_waitset_wait(waitset, NULL, 0, _timeout);
+    if (num_triggered < 0)
+    {
+      DDS_ERROR("dds_waitset_wait: %s\n", dds_strretcode(-num_triggered));
+      return false;
+    }
+    return num_triggered > 0;
+  }
+
+  /// Takes every sample currently queued in the reader, regardless of
+  /// MaxSamplesNum, visiting each of them in order of arrival. The visited
+  /// message is only valid for the duration of the visitor call.
+  ///
+  /// \param[in] visitor
+  ///   Function to be called for every valid sample taken.
+  /// \return
+  ///   Number of valid samples visited.
+  size_t take_all(const Callback& _visitor)
+  {
+    if (!is_ready())
+      return 0;
+
+    std::unique_lock<std::mutex> take_lock(take_mutex);
+    return drain(_visitor);
+  }
+
+  /// Gets the total number of samples that never made it to be taken, either
+  /// lost on the way or rejected due to a full reader queue.
+  ///
+  /// \return
+  ///   Total number of dropped samples since the reader was created.
+  uint64_t get_dropped_count()
+  {
+    if (!is_ready())
+      return 0;
+
+    dds_sample_lost_status_t lost_status;
+    dds_sample_rejected_status_t rejected_status;
+    if (dds_get_sample_lost_status(reader, &lost_status) != DDS_RETCODE_OK ||
+        dds_get_sample_rejected_status(reader, &rejected_status) 
+            != DDS_RETCODE_OK)
+      return 0;
+
+    return static_cast<uint64_t>(lost_status.total_count) +
+        static_cast<uint64_t>(rejected_status.total_count);
+  }
+
+  /// Takes up to MaxSamplesNum samples without copying them. Every returned
+  /// pointer shares ownership of the underlying loan, which is returned to
+  /// the reader once all of them have been released, so samples are never
+  /// overwritten by later reads while they are still held. They must however
+  /// be released before this handler is destroyed.
+  ///
+  /// \return
+  ///   Newly taken valid samples, empty if there were none.
   std::vector<std::shared_ptr<const Message>> read()
   {
     std::vector<std::shared_ptr<const Message>> msgs;
     if (!is_ready())
       return msgs;
 
-    return_code = dds_take(reader, samples, infos, MaxSamplesNum, MaxSamplesNum);
-    if (return_code < 0)
+    auto loan = std::make_shared<Loan>(reader);
+    dds_return_t num_taken;
     {
-      DDS_FATAL("dds_take: %s\n", dds_strretcode(-return_code));
-      msgs.clear();
-      return msgs;
+      std::unique_lock<std::mutex> take_lock(take_mutex);
+      num_taken = loan->take();
     }
-    
-    if (return_code > 0)
+    if (num_taken < 0)
     {
-      for (size_t i = 0; i < MaxSamplesNum; ++i)
-      {
-        if (infos[i].valid_data == true)
-          msgs.push_back(std::shared_ptr<const Message>(shared_msgs[i]));
-      }
+      DDS_ERROR("dds_take: %s\n", dds_strretcode(-num_taken));
       return msgs;
     }
-    msgs.clear();
+
+    for (dds_return_t i = 0; i < num_taken; ++i)
+    {
+      if (loan->is_valid(i))
+        msgs.push_back(std::shared_ptr<const Message>(loan, &loan->get(i)));
+    }
     return msgs;
   }
 
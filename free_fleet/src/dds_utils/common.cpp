@@ -15,9 +15,9 @@
  *
  */
 
-#include "common.hpp"
+#include <cstdlib>
 
-#include <dds/dds.h>
+#include "common.hpp"
 
 namespace free_fleet {
 namespace common {
@@ -32,5 +32,88 @@ char* dds_string_alloc_and_copy(const std::string& _str)
   return ptr;
 }
 
+namespace {
+
+dds_duration_t to_dds_duration(double _seconds)
+{
+  if (_seconds <= 0.0)
+    return DDS_INFINITY;
+  return static_cast<dds_duration_t>(_seconds * 1e9);
+}
+
+int32_t to_dds_length(int _length)
+{
+  return _length > 0 ? static_cast<int32_t>(_length) : DDS_LENGTH_UNLIMITED;
+}
+
+} // namespace
+
+dds_qos_t* dds_qos_create(const QoSProfile& _profile)
+{
+  dds_qos_t* qos = dds_create_qos();
+
+  if (_profile.reliability == QoSProfile::Reliability::Reliable)
+    dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_MSECS(100));
+  else
+    dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+
+  if (_profile.history_depth > 0)
+    dds_qset_history(qos, DDS_HISTORY_KEEP_LAST, _profile.history_depth);
+  else
+    dds_qset_history(qos, DDS_HISTORY_KEEP_ALL, 0);
+
+  if (_profile.durability == QoSProfile::Durability::TransientLocal)
+    dds_qset_durability(qos, DDS_DURABILITY_TRANSIENT_LOCAL);
+  else
+    dds_qset_durability(qos, DDS_DURABILITY_VOLATILE);
+
+  dds_qset_deadline(qos, to_dds_duration(_profile.deadline));
+  // A latency budget of zero already means as fast as possible.
+  dds_qset_latency_budget(
+      qos, _profile.latency_budget > 0.0 ? 
+          to_dds_duration(_profile.latency_budget) : 0);
+  dds_qset_transport_priority(qos, _profile.transport_priority);
+  dds_qset_resource_limits(
+      qos,
+      to_dds_length(_profile.max_samples),
+      to_dds_length(_profile.max_instances),
+      to_dds_length(_profile.max_samples_per_instance));
+  return qos;
+}
+
+dds_entity_t dds_participant_create(
+    int _domain, bool _shared_memory, dds_entity_t& _created_domain)
+{
+  _created_domain = 0;
+  const dds_domainid_t domain_id = static_cast<dds_domainid_t>(_domain);
+#ifdef FREE_FLEET_DDS_SHARED_MEMORY
+  if (_shared_memory)
+  {
+    // Appended to the configuration from the environment, which would be
+    // ignored otherwise once the domain is created explicitly.
+    std::string config =
+        "<CycloneDDS><Domain><SharedMemory><Enable>true</Enable>"
+        "</SharedMemory></Domain></CycloneDDS>";
+    const char* uri = std::getenv("CYCLONEDDS_URI");
+    if (uri && uri[0] != '\0')
+      config = std::string(uri) + "," + config;
+
+    // Other participants of this process join the domain that already
+    // exists, with whichever transport it was created with. Should creating
+    // it fail, the participant creates it without shared memory instead.
+    dds_entity_t domain = dds_create_domain(domain_id, config.c_str());
+    if (domain >= 0)
+      _created_domain = domain;
+    else if (domain != DDS_RETCODE_PRECONDITION_NOT_MET)
+      DDS_ERROR("dds_create_domain: %s\n", dds_strretcode(-domain));
+  }
+#else
+  // Not fatal, samples are exchanged over the network instead.
+  if (_shared_memory)
+    DDS_ERROR("shared memory needs CycloneDDS 0.9 or newer\n");
+#endif
+  return dds_create_participant(domain_id, NULL, NULL);
+}
+
 } // namespace common
 } // namespace free_fleet
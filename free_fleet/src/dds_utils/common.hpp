@@ -20,11 +20,39 @@
 
 #include <string>
 
+#include <dds/dds.h>
+
+#include <free_fleet/QoSProfile.hpp>
+
 namespace free_fleet {
 namespace common {
 
 char* dds_string_alloc_and_copy(const std::string& str);
 
+/// Creates DDS QoS policies from a profile, to be deleted with
+/// dds_delete_qos once the entity has been created.
+dds_qos_t* dds_qos_create(const QoSProfile& profile);
+
+/// Creates a participant on a domain, optionally with shared memory enabled
+/// for peers on the same host. The transport of a domain is fixed by the
+/// first participant created on it within a process.
+///
+/// \param[in] domain
+///   DDS domain id.
+/// \param[in] shared_memory
+///   Whether samples to and from peers on the same host go through the
+///   shared memory of iceoryx instead of the network.
+/// \param[out] created_domain
+///   Domain created for shared memory, to be deleted with dds_delete after
+///   the participant, which also deletes any other participant of this
+///   process still on it. 0 if no domain was created, which is when shared
+///   memory is off, the domain already existed, or it could not be created
+///   and the participant uses the network only.
+/// \return
+///   Participant, or a negative return code if it could not be created.
+dds_entity_t dds_participant_create(
+    int domain, bool shared_memory, dds_entity_t& created_domain);
+
 } // namespace common
 } // namespace free_fleet
 
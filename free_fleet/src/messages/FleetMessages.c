@@ -37,6 +37,7 @@ static const uint32_t FreeFleetData_Location_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_Location, level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, level_id),
   DDS_OP_RTS
 };
 
@@ -48,15 +49,20 @@ const dds_topic_descriptor_t FreeFleetData_Location_desc =
   0u,
   "FreeFleetData::Location",
   NULL,
-  7,
+  8,
   FreeFleetData_Location_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member><Member name=\"level_id\"><ULong/></Member></Struct></Module></MetaData>"
 };
 
 
+static const dds_key_descriptor_t FreeFleetData_RobotState_keys[1] =
+{
+  { "name", 0 }
+};
+
 static const uint32_t FreeFleetData_RobotState_ops [] =
 {
-  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_RobotState, name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, model),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, task_id),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, mode.mode),
@@ -67,15 +73,18 @@ static const uint32_t FreeFleetData_RobotState_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RobotState, location.level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RobotState, location.level_id),
   DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_RobotState, path),
-  sizeof (FreeFleetData_Location), (17u << 16u) + 4u,
+  sizeof (FreeFleetData_Location), (19u << 16u) + 4u,
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, sec),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, nanosec),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, x),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_Location, level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, level_id),
   DDS_OP_RTS,
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_RobotState, compact_path),
   DDS_OP_RTS
 };
 
@@ -84,12 +93,86 @@ const dds_topic_descriptor_t FreeFleetData_RobotState_desc =
   sizeof (FreeFleetData_RobotState),
   sizeof (char *),
   DDS_TOPIC_NO_OPTIMIZE,
-  0u,
+  1u,
   "FreeFleetData::RobotState",
-  NULL,
-  21,
+  FreeFleetData_RobotState_keys,
+  25,
   FreeFleetData_RobotState_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"RobotState\"><Member name=\"name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"Location\"/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member><Member name=\"level_id\"><ULong/></Member></Struct><Struct name=\"RobotState\"><Member name=\"name\"><String/></Member><Member name=\"model\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"Location\"/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member><Member name=\"compact_path\"><Sequence><Octet/></Sequence></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_BoundedLocation_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_BoundedLocation, level_name), 32,
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_BoundedLocation_desc =
+{
+  sizeof (FreeFleetData_BoundedLocation),
+  4u,
+  0u,
+  0u,
+  "FreeFleetData::BoundedLocation",
+  NULL,
+  8,
+  FreeFleetData_BoundedLocation_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"BoundedLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><Array size=\"32\"><Char/></Array></Member></Struct></Module></MetaData>"
+};
+
+
+static const dds_key_descriptor_t FreeFleetData_BoundedRobotState_keys[1] =
+{
+  { "name", 0 }
+};
+
+static const uint32_t FreeFleetData_BoundedRobotState_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_BoundedRobotState, name), 64,
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_BoundedRobotState, model), 64,
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_BoundedRobotState, task_id), 64,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, mode.mode),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, battery_percent),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, location.sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, location.nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, location.x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, location.y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, location.yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_BoundedRobotState, location.level_name), 32,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedRobotState, path_length),
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_BoundedRobotState, path), 64,
+  (19u << 16u) + 5u, sizeof (FreeFleetData_BoundedLocation),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, sec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, nanosec),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, x),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, y),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_BoundedLocation, yaw),
+  DDS_OP_ADR | DDS_OP_TYPE_ARR | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_BoundedLocation, level_name), 32,
+  DDS_OP_RTS,
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_BoundedRobotState_desc =
+{
+  sizeof (FreeFleetData_BoundedRobotState),
+  4u,
+#ifdef DDS_TOPIC_FIXED_SIZE
+  DDS_TOPIC_FIXED_SIZE,
+#else
+  0u,
+#endif
+  1u,
+  "FreeFleetData::BoundedRobotState",
+  FreeFleetData_BoundedRobotState_keys,
+  27,
+  FreeFleetData_BoundedRobotState_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"BoundedLocation\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><Array size=\"32\"><Char/></Array></Member></Struct><Struct name=\"BoundedRobotState\"><Member name=\"name\"><Array size=\"64\"><Char/></Array></Member><Member name=\"model\"><Array size=\"64\"><Char/></Array></Member><Member name=\"task_id\"><Array size=\"64\"><Char/></Array></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"battery_percent\"><Float/></Member><Member name=\"location\"><Type name=\"BoundedLocation\"/></Member><Member name=\"path_length\"><ULong/></Member><Member name=\"path\"><Array size=\"64\"><Type name=\"BoundedLocation\"/></Array></Member></Struct></Module></MetaData>"
 };
 
 
@@ -125,6 +208,8 @@ static const uint32_t FreeFleetData_ModeRequest_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_ModeParameter, name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_ModeParameter, value),
   DDS_OP_RTS,
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_ModeRequest, fleet_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_ModeRequest, robot_id),
   DDS_OP_RTS
 };
 
@@ -136,9 +221,9 @@ const dds_topic_descriptor_t FreeFleetData_ModeRequest_desc =
   0u,
   "FreeFleetData::ModeRequest",
   NULL,
-  10,
+  12,
   FreeFleetData_ModeRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"ModeParameter\"><Member name=\"name\"><String/></Member><Member name=\"value\"><String/></Member></Struct><Struct name=\"ModeRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"parameters\"><Sequence><Type name=\"ModeParameter\"/></Sequence></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RobotMode\"><Member name=\"mode\"><ULong/></Member></Struct><Struct name=\"ModeParameter\"><Member name=\"name\"><String/></Member><Member name=\"value\"><String/></Member></Struct><Struct name=\"ModeRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"mode\"><Type name=\"RobotMode\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"parameters\"><Sequence><Type name=\"ModeParameter\"/></Sequence></Member><Member name=\"fleet_id\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member></Struct></Module></MetaData>"
 };
 
 
@@ -147,15 +232,19 @@ static const uint32_t FreeFleetData_PathRequest_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, fleet_name),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, robot_name),
   DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_STU, offsetof (FreeFleetData_PathRequest, path),
-  sizeof (FreeFleetData_Location), (17u << 16u) + 4u,
+  sizeof (FreeFleetData_Location), (19u << 16u) + 4u,
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, sec),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, nanosec),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, x),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_Location, level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_Location, level_id),
   DDS_OP_RTS,
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_PathRequest, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, fleet_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_PathRequest, robot_id),
+  DDS_OP_ADR | DDS_OP_TYPE_SEQ | DDS_OP_SUBTYPE_1BY, offsetof (FreeFleetData_PathRequest, compact_path),
   DDS_OP_RTS
 };
 
@@ -167,9 +256,9 @@ const dds_topic_descriptor_t FreeFleetData_PathRequest_desc =
   0u,
   "FreeFleetData::PathRequest",
   NULL,
-  13,
+  18,
   FreeFleetData_PathRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"PathRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member><Member name=\"task_id\"><String/></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member><Member name=\"level_id\"><ULong/></Member></Struct><Struct name=\"PathRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"path\"><Sequence><Type name=\"Location\"/></Sequence></Member><Member name=\"task_id\"><String/></Member><Member name=\"fleet_id\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member><Member name=\"compact_path\"><Sequence><Octet/></Sequence></Member></Struct></Module></MetaData>"
 };
 
 
@@ -183,7 +272,10 @@ static const uint32_t FreeFleetData_DestinationRequest_ops [] =
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, destination.y),
   DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, destination.yaw),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_DestinationRequest, destination.level_name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, destination.level_id),
   DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_DestinationRequest, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, fleet_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_DestinationRequest, robot_id),
   DDS_OP_RTS
 };
 
@@ -195,7 +287,58 @@ const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc =
   0u,
   "FreeFleetData::DestinationRequest",
   NULL,
-  10,
+  13,
   FreeFleetData_DestinationRequest_ops,
-  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member></Struct><Struct name=\"DestinationRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"destination\"><Type name=\"Location\"/></Member><Member name=\"task_id\"><String/></Member></Struct></Module></MetaData>"
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"Location\"><Member name=\"sec\"><Long/></Member><Member name=\"nanosec\"><ULong/></Member><Member name=\"x\"><Float/></Member><Member name=\"y\"><Float/></Member><Member name=\"yaw\"><Float/></Member><Member name=\"level_name\"><String/></Member><Member name=\"level_id\"><ULong/></Member></Struct><Struct name=\"DestinationRequest\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"destination\"><Type name=\"Location\"/></Member><Member name=\"task_id\"><String/></Member><Member name=\"fleet_id\"><ULong/></Member><Member name=\"robot_id\"><ULong/></Member></Struct></Module></MetaData>"
+};
+
+
+static const uint32_t FreeFleetData_RequestAck_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, fleet_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, robot_name),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, task_id),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_RequestAck, request_type),
+  DDS_OP_ADR | DDS_OP_TYPE_1BY, offsetof (FreeFleetData_RequestAck, accepted),
+  DDS_OP_ADR | DDS_OP_TYPE_STR, offsetof (FreeFleetData_RequestAck, reason),
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_RequestAck_desc =
+{
+  sizeof (FreeFleetData_RequestAck),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  0u,
+  "FreeFleetData::RequestAck",
+  NULL,
+  7,
+  FreeFleetData_RequestAck_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"RequestAck\"><Member name=\"fleet_name\"><String/></Member><Member name=\"robot_name\"><String/></Member><Member name=\"task_id\"><String/></Member><Member name=\"request_type\"><ULong/></Member><Member name=\"accepted\"><Boolean/></Member><Member name=\"reason\"><String/></Member></Struct></Module></MetaData>"
+};
+
+
+static const dds_key_descriptor_t FreeFleetData_NameId_keys[1] =
+{
+  { "name", 0 }
+};
+
+static const uint32_t FreeFleetData_NameId_ops [] =
+{
+  DDS_OP_ADR | DDS_OP_TYPE_STR | DDS_OP_FLAG_KEY, offsetof (FreeFleetData_NameId, name),
+  DDS_OP_ADR | DDS_OP_TYPE_4BY, offsetof (FreeFleetData_NameId, id),
+  DDS_OP_RTS
+};
+
+const dds_topic_descriptor_t FreeFleetData_NameId_desc =
+{
+  sizeof (FreeFleetData_NameId),
+  sizeof (char *),
+  DDS_TOPIC_NO_OPTIMIZE,
+  1u,
+  "FreeFleetData::NameId",
+  FreeFleetData_NameId_keys,
+  3,
+  FreeFleetData_NameId_ops,
+  "<MetaData version=\"1.0.0\"><Module name=\"FreeFleetData\"><Struct name=\"NameId\"><Member name=\"name\"><String/></Member><Member name=\"id\"><ULong/></Member></Struct></Module></MetaData>"
 };
@@ -50,6 +50,7 @@ typedef struct FreeFleetData_Location
   float y;
   float yaw;
   char * level_name;
+  uint32_t level_id;
 } FreeFleetData_Location;
 
 extern const dds_topic_descriptor_t FreeFleetData_Location_desc;
@@ -74,6 +75,20 @@ typedef struct FreeFleetData_RobotState_path_seq
 #define FreeFleetData_RobotState_path_seq_allocbuf(l) \
 ((FreeFleetData_Location *) dds_alloc ((l) * sizeof (FreeFleetData_Location)))
 
+typedef struct FreeFleetData_RobotState_compact_path_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  uint8_t *_buffer;
+  bool _release;
+} FreeFleetData_RobotState_compact_path_seq;
+
+#define FreeFleetData_RobotState_compact_path_seq__alloc() \
+((FreeFleetData_RobotState_compact_path_seq*) dds_alloc (sizeof (FreeFleetData_RobotState_compact_path_seq)));
+
+#define FreeFleetData_RobotState_compact_path_seq_allocbuf(l) \
+((uint8_t *) dds_alloc ((l) * sizeof (uint8_t)))
+
 
 typedef struct FreeFleetData_RobotState
 {
@@ -84,6 +99,7 @@ typedef struct FreeFleetData_RobotState
   float battery_percent;
   FreeFleetData_Location location;
   FreeFleetData_RobotState_path_seq path;
+  FreeFleetData_RobotState_compact_path_seq compact_path;
 } FreeFleetData_RobotState;
 
 extern const dds_topic_descriptor_t FreeFleetData_RobotState_desc;
@@ -94,6 +110,50 @@ extern const dds_topic_descriptor_t FreeFleetData_RobotState_desc;
 #define FreeFleetData_RobotState_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_RobotState_desc, (o))
 
+#define FreeFleetData_BoundedRobotState_Constants_STRING_SIZE 64
+#define FreeFleetData_BoundedRobotState_Constants_LEVEL_NAME_SIZE 32
+#define FreeFleetData_BoundedRobotState_Constants_PATH_SIZE 64
+
+
+typedef struct FreeFleetData_BoundedLocation
+{
+  int32_t sec;
+  uint32_t nanosec;
+  float x;
+  float y;
+  float yaw;
+  char level_name[32];
+} FreeFleetData_BoundedLocation;
+
+extern const dds_topic_descriptor_t FreeFleetData_BoundedLocation_desc;
+
+#define FreeFleetData_BoundedLocation__alloc() \
+((FreeFleetData_BoundedLocation*) dds_alloc (sizeof (FreeFleetData_BoundedLocation)));
+
+#define FreeFleetData_BoundedLocation_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_BoundedLocation_desc, (o))
+
+
+typedef struct FreeFleetData_BoundedRobotState
+{
+  char name[64];
+  char model[64];
+  char task_id[64];
+  FreeFleetData_RobotMode mode;
+  float battery_percent;
+  FreeFleetData_BoundedLocation location;
+  uint32_t path_length;
+  FreeFleetData_BoundedLocation path[64];
+} FreeFleetData_BoundedRobotState;
+
+extern const dds_topic_descriptor_t FreeFleetData_BoundedRobotState_desc;
+
+#define FreeFleetData_BoundedRobotState__alloc() \
+((FreeFleetData_BoundedRobotState*) dds_alloc (sizeof (FreeFleetData_BoundedRobotState)));
+
+#define FreeFleetData_BoundedRobotState_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_BoundedRobotState_desc, (o))
+
 
 typedef struct FreeFleetData_ModeParameter
 {
@@ -131,6 +191,8 @@ typedef struct FreeFleetData_ModeRequest
   FreeFleetData_RobotMode mode;
   char * task_id;
   FreeFleetData_ModeRequest_parameters_seq parameters;
+  uint32_t fleet_id;
+  uint32_t robot_id;
 } FreeFleetData_ModeRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_ModeRequest_desc;
@@ -155,6 +217,20 @@ typedef struct FreeFleetData_PathRequest_path_seq
 #define FreeFleetData_PathRequest_path_seq_allocbuf(l) \
 ((FreeFleetData_Location *) dds_alloc ((l) * sizeof (FreeFleetData_Location)))
 
+typedef struct FreeFleetData_PathRequest_compact_path_seq
+{
+  uint32_t _maximum;
+  uint32_t _length;
+  uint8_t *_buffer;
+  bool _release;
+} FreeFleetData_PathRequest_compact_path_seq;
+
+#define FreeFleetData_PathRequest_compact_path_seq__alloc() \
+((FreeFleetData_PathRequest_compact_path_seq*) dds_alloc (sizeof (FreeFleetData_PathRequest_compact_path_seq)));
+
+#define FreeFleetData_PathRequest_compact_path_seq_allocbuf(l) \
+((uint8_t *) dds_alloc ((l) * sizeof (uint8_t)))
+
 
 typedef struct FreeFleetData_PathRequest
 {
@@ -162,6 +238,9 @@ typedef struct FreeFleetData_PathRequest
   char * robot_name;
   FreeFleetData_PathRequest_path_seq path;
   char * task_id;
+  uint32_t fleet_id;
+  uint32_t robot_id;
+  FreeFleetData_PathRequest_compact_path_seq compact_path;
 } FreeFleetData_PathRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_PathRequest_desc;
@@ -179,6 +258,8 @@ typedef struct FreeFleetData_DestinationRequest
   char * robot_name;
   FreeFleetData_Location destination;
   char * task_id;
+  uint32_t fleet_id;
+  uint32_t robot_id;
 } FreeFleetData_DestinationRequest;
 
 extern const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc;
@@ -189,6 +270,44 @@ extern const dds_topic_descriptor_t FreeFleetData_DestinationRequest_desc;
 #define FreeFleetData_DestinationRequest_free(d,o) \
 dds_sample_free ((d), &FreeFleetData_DestinationRequest_desc, (o))
 
+#define FreeFleetData_RequestAck_Constants_REQUEST_MODE 0
+#define FreeFleetData_RequestAck_Constants_REQUEST_PATH 1
+#define FreeFleetData_RequestAck_Constants_REQUEST_DESTINATION 2
+
+
+typedef struct FreeFleetData_RequestAck
+{
+  char * fleet_name;
+  char * robot_name;
+  char * task_id;
+  uint32_t request_type;
+  bool accepted;
+  char * reason;
+} FreeFleetData_RequestAck;
+
+extern const dds_topic_descriptor_t FreeFleetData_RequestAck_desc;
+
+#define FreeFleetData_RequestAck__alloc() \
+((FreeFleetData_RequestAck*) dds_alloc (sizeof (FreeFleetData_RequestAck)));
+
+#define FreeFleetData_RequestAck_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_RequestAck_desc, (o))
+
+
+typedef struct FreeFleetData_NameId
+{
+  char * name;
+  uint32_t id;
+} FreeFleetData_NameId;
+
+extern const dds_topic_descriptor_t FreeFleetData_NameId_desc;
+
+#define FreeFleetData_NameId__alloc() \
+((FreeFleetData_NameId*) dds_alloc (sizeof (FreeFleetData_NameId)));
+
+#define FreeFleetData_NameId_free(d,o) \
+dds_sample_free ((d), &FreeFleetData_NameId_desc, (o))
+
 #ifdef __cplusplus
 }
 #endif
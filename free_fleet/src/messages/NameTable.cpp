@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <random>
+
+#include <free_fleet/messages/NameId.hpp>
+
+#include "NameTable.hpp"
+
+namespace free_fleet {
+namespace messages {
+
+constexpr std::size_t NameTable::MaxSize;
+
+NameTable::NameTable() :
+  generation(0),
+  gives_out_ids(false)
+{}
+
+NameTable::NameTable(uint16_t _generation) :
+  generation(_generation),
+  gives_out_ids(true)
+{}
+
+uint16_t NameTable::make_generation()
+{
+  std::random_device random_device;
+  std::uniform_int_distribution<uint32_t> distribution(1, 0xFFFF);
+  return static_cast<uint16_t>(distribution(random_device));
+}
+
+uint32_t NameTable::get_index(uint32_t _id)
+{
+  return _id & 0xFFFF;
+}
+
+uint32_t NameTable::intern(const std::string& _name, bool& _added)
+{
+  _added = false;
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = ids.find(_name);
+  if (it != ids.end())
+    return it->second;
+  if (!gives_out_ids || names.size() >= MaxSize)
+    return 0;
+
+  const uint32_t id =
+      (static_cast<uint32_t>(generation) << 16) |
+      static_cast<uint32_t>(names.size());
+  ids.emplace(_name, id);
+  names.push_back(_name);
+  _added = true;
+  return id;
+}
+
+uint32_t NameTable::find_id(const std::string& _name) const
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = ids.find(_name);
+  return it == ids.end() ? 0 : it->second;
+}
+
+bool NameTable::find_name(uint32_t _id, std::string& _name) const
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  const uint32_t index = get_index(_id);
+  if (get_name_id_generation(_id) != generation || index >= names.size())
+    return false;
+
+  // Slots of ids that were not learned yet are empty.
+  auto it = ids.find(names[index]);
+  if (it == ids.end() || it->second != _id)
+    return false;
+  _name.assign(names[index]);
+  return true;
+}
+
+void NameTable::learn(const std::string& _name, uint32_t _id)
+{
+  const uint32_t index = get_index(_id);
+  std::unique_lock<std::mutex> lock(mutex);
+  if (get_name_id_generation(_id) == 0)
+    return;
+  if (get_name_id_generation(_id) != generation)
+  {
+    generation = static_cast<uint16_t>(get_name_id_generation(_id));
+    ids.clear();
+    names.clear();
+  }
+
+  // Ids are learned in any order, unknown ones are left empty until then.
+  if (index >= names.size())
+    names.resize(index + 1);
+  names[index] = _name;
+  ids[_name] = _id;
+}
+
+} // namespace messages
+} // namespace free_fleet
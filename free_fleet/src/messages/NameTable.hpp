@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef FREE_FLEET__SRC__MESSAGES__NAMETABLE_HPP
+#define FREE_FLEET__SRC__MESSAGES__NAMETABLE_HPP
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace free_fleet {
+namespace messages {
+
+/// Names that are sent as ids instead of strings. The server owns the table
+/// that gives out the ids, see NameId.hpp, and publishes every name it adds
+/// on a transient local topic, from which the clients fill tables of their
+/// own. A client only sends an id once it learned it from the server, so the
+/// server always knows the names of the ids it receives.
+class NameTable
+{
+public:
+
+  /// Largest number of names in a table, names added past it get no id and
+  /// keep being sent as strings.
+  static constexpr std::size_t MaxSize = 0xFFFF;
+
+  /// Creates a table that learns its ids from another table.
+  NameTable();
+
+  /// Creates a table that gives out ids of the given generation, which
+  /// needs to be different from that of the last run of the server, and not
+  /// zero.
+  explicit NameTable(uint16_t generation);
+
+  /// Gets the generation of the table that gives out ids, one picked at
+  /// random that is not zero.
+  static uint16_t make_generation();
+
+  /// Gets the id of a name, giving it the next id if it has none yet.
+  ///
+  /// \param[in] name
+  ///   Name to get the id of.
+  /// \param[out] added
+  ///   True if the name was given a new id, which needs to be published.
+  /// \return
+  ///   Id of the name, 0 if the table is full or only learns its ids.
+  uint32_t intern(const std::string& name, bool& added);
+
+  /// Gets the id of a name, 0 if it has none.
+  uint32_t find_id(const std::string& name) const;
+
+  /// Gets the name of an id.
+  ///
+  /// \return
+  ///   True if the id is known, false otherwise, then the name is untouched.
+  bool find_name(uint32_t id, std::string& name) const;
+
+  /// Adds an id given out by another table. An id of a new generation means
+  /// that the server restarted, and every id of the previous generation is
+  /// forgotten.
+  void learn(const std::string& name, uint32_t id);
+
+private:
+
+  static uint32_t get_index(uint32_t id);
+
+  mutable std::mutex mutex;
+
+  /// Generation of the ids in the table, 0 while it is empty when learning.
+  uint16_t generation;
+
+  bool gives_out_ids;
+
+  std::unordered_map<std::string, uint32_t> ids;
+
+  /// Names by the index part of their ids, empty where not known.
+  std::vector<std::string> names;
+
+};
+
+} // namespace messages
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__MESSAGES__NAMETABLE_HPP
@@ -14,16 +14,234 @@
  * limitations under the License.
  *
  */
-
-#include <dds/dds.h>
-
-#include "../dds_utils/common.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 
 #include "message_utils.hpp"
 
 namespace free_fleet {
 namespace messages {
 
+namespace {
+
+/// DDS samples are only read while being written, so they can point straight
+/// into the strings of the message being sent.
+char* borrow(const std::string& _str)
+{
+  return const_cast<char*>(_str.c_str());
+}
+
+/// Grows the buffer if needed, and points the sequence at its first
+/// elements. The buffer is never shrunk, so it only allocates when a longer
+/// sequence than ever before is sent.
+template <typename Sequence, typename Element>
+void borrow(
+    size_t _length, std::vector<Element>& _buffer, Sequence& _output)
+{
+  if (_buffer.size() < _length)
+    _buffer.resize(_length);
+  _output._maximum = static_cast<uint32_t>(_length);
+  _output._length = static_cast<uint32_t>(_length);
+  _output._buffer = _length > 0 ? _buffer.data() : NULL;
+  _output._release = false;
+}
+
+/// Copies a string into a fixed size character array, truncating it if
+/// needed. The rest of the array is cleared, as the whole array is sent and
+/// is hashed when used as a key.
+template <std::size_t Size>
+void copy_bounded(const std::string& _str, char (&_output)[Size])
+{
+  const std::size_t length = std::min(_str.size(), Size - 1);
+  std::memcpy(_output, _str.data(), length);
+  std::memset(_output + length, 0, Size - length);
+}
+
+/// Assigns a fixed size character array, which might not be terminated if
+/// it was filled by a peer that does not truncate.
+template <std::size_t Size>
+void assign_bounded(const char (&_input)[Size], std::string& _output)
+{
+  _output.assign(_input, strnlen(_input, Size));
+}
+
+/// Sequences that are not sent are left empty, as samples are reused.
+template <typename Sequence>
+void clear(Sequence& _output)
+{
+  _output._maximum = 0;
+  _output._length = 0;
+  _output._buffer = NULL;
+  _output._release = false;
+}
+
+/// Compact paths are decoded if they were sent, otherwise the sequence of
+/// locations is used. A compact path that cannot be decoded leaves the path
+/// empty, the same as a sample without one.
+template <typename Sample>
+void convert_path(const Sample& _input, std::vector<Location>& _output)
+{
+  if (_input.compact_path._length > 0)
+  {
+    if (!decode_path(
+        _input.compact_path._buffer, _input.compact_path._length, _output))
+      _output.clear();
+    return;
+  }
+
+  _output.resize(_input.path._length);
+  for (uint32_t i = 0; i < _input.path._length; ++i)
+    convert(_input.path._buffer[i], _output[i]);
+}
+
+template <typename Sample>
+void compact_path_of(Sample& _sample, std::vector<uint8_t>& _buffer)
+{
+  encode_path(_sample.path._buffer, _sample.path._length, _buffer);
+  _sample.compact_path._maximum = static_cast<uint32_t>(_buffer.size());
+  _sample.compact_path._length = static_cast<uint32_t>(_buffer.size());
+  _sample.compact_path._buffer = _buffer.data();
+  _sample.compact_path._release = false;
+  clear(_sample.path);
+}
+
+const double position_scale = 1000.0;
+const double yaw_scale = 1000.0;
+const int64_t nanosec_per_sec = 1000000000;
+const int64_t nanosec_per_time_step = 1000000;
+
+/// Values beyond this are not coordinates of a robot anyway, they are only
+/// clamped to keep the quantized differences from overflowing.
+const double max_quantized = 1e15;
+
+int64_t quantize(double _value, double _scale)
+{
+  if (!std::isfinite(_value))
+    return 0;
+  return static_cast<int64_t>(std::llround(
+      std::max(-max_quantized, std::min(max_quantized, _value * _scale))));
+}
+
+/// Decoded values beyond what the encoder ever sends are rejected, which
+/// keeps the arithmetic on values from peers from overflowing. Differences
+/// of quantized values span twice their range, and times span every second
+/// that fits the 32 bit seconds of a location.
+const int64_t max_quantized_value = static_cast<int64_t>(max_quantized);
+const int64_t max_path_nanosec = (int64_t(INT32_MAX) + 1) * nanosec_per_sec;
+const int64_t max_time_steps = 2 * max_path_nanosec / nanosec_per_time_step;
+
+bool is_within(int64_t _value, int64_t _bound)
+{
+  return _value >= -_bound && _value <= _bound;
+}
+
+/// Maps signed integers to unsigned ones so that small magnitudes of either
+/// sign are encoded in few bytes.
+uint64_t zigzag(int64_t _value)
+{
+  return (static_cast<uint64_t>(_value) << 1) ^
+      static_cast<uint64_t>(_value >> 63);
+}
+
+int64_t unzigzag(uint64_t _value)
+{
+  return static_cast<int64_t>(_value >> 1) ^
+      -static_cast<int64_t>(_value & 1);
+}
+
+/// Seven bits per byte, the highest bit is set on all but the last byte.
+void put_varint(uint64_t _value, std::vector<uint8_t>& _output)
+{
+  while (_value >= 0x80)
+  {
+    _output.push_back(static_cast<uint8_t>(_value | 0x80));
+    _value >>= 7;
+  }
+  _output.push_back(static_cast<uint8_t>(_value));
+}
+
+/// Reads data received from a peer, so every read is checked against the
+/// end of the data.
+struct ByteReader
+{
+  const uint8_t* data;
+  uint32_t size;
+  uint32_t offset;
+
+  bool read_varint(uint64_t& _value)
+  {
+    _value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+      if (offset >= size)
+        return false;
+      const uint8_t byte = data[offset++];
+      _value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  bool read_signed(int64_t& _value)
+  {
+    uint64_t value;
+    if (!read_varint(value))
+      return false;
+    _value = unzigzag(value);
+    return true;
+  }
+
+  bool read_string(std::string& _value)
+  {
+    uint64_t length;
+    if (!read_varint(length) || length > size - offset)
+      return false;
+    _value.assign(
+        reinterpret_cast<const char*>(data + offset),
+        static_cast<std::size_t>(length));
+    offset += static_cast<uint32_t>(length);
+    return true;
+  }
+};
+
+int64_t get_nanosec(const FreeFleetData_Location& _location)
+{
+  return static_cast<int64_t>(_location.sec) * nanosec_per_sec +
+      static_cast<int64_t>(_location.nanosec);
+}
+
+void set_time(int64_t _nanosec, Location& _output)
+{
+  int64_t sec = _nanosec / nanosec_per_sec;
+  int64_t nanosec = _nanosec % nanosec_per_sec;
+  if (nanosec < 0)
+  {
+    sec -= 1;
+    nanosec += nanosec_per_sec;
+  }
+
+  // Only reached when rounding to whole time steps carried the last
+  // representable second over.
+  if (sec > INT32_MAX)
+  {
+    sec = INT32_MAX;
+    nanosec = nanosec_per_sec - 1;
+  }
+  _output.sec = static_cast<int32_t>(sec);
+  _output.nanosec = static_cast<uint32_t>(nanosec);
+}
+
+bool is_same_level(
+    const FreeFleetData_Location& _a, const FreeFleetData_Location& _b)
+{
+  return _a.level_id == _b.level_id &&
+      std::strcmp(_a.level_name, _b.level_name) == 0;
+}
+
+} // namespace
+
 void convert(const RobotMode& _input, FreeFleetData_RobotMode& _output)
 {
   // Consequently, free fleet robot modes need to be ordered similarly as 
@@ -45,7 +263,8 @@ void convert(const Location& _input, FreeFleetData_Location& _output)
   _output.x = _input.x;
   _output.y = _input.y;
   _output.yaw = _input.yaw;
-  _output.level_name = common::dds_string_alloc_and_copy(_input.level_name);
+  _output.level_name = borrow(_input.level_name);
+  _output.level_id = _input.level_id;
 }
 
 void convert(const FreeFleetData_Location& _input, Location& _output)
@@ -55,141 +274,386 @@ void convert(const FreeFleetData_Location& _input, Location& _output)
   _output.x = _input.x;
   _output.y = _input.y;
   _output.yaw = _input.yaw;
-  _output.level_name = std::string(_input.level_name);
+  _output.level_name.assign(_input.level_name);
+  _output.level_id = _input.level_id;
 }
 
-void convert(const RobotState& _input, FreeFleetData_RobotState& _output)
+void convert(
+    const RobotState& _input,
+    FreeFleetData_RobotState& _output,
+    std::vector<FreeFleetData_Location>& _path_buffer)
 {
-  _output.name = common::dds_string_alloc_and_copy(_input.name);
-  _output.model = common::dds_string_alloc_and_copy(_input.model);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  _output.name = borrow(_input.name);
+  _output.model = borrow(_input.model);
+  _output.task_id = borrow(_input.task_id);
   convert(_input.mode, _output.mode);
   _output.battery_percent = _input.battery_percent;
   convert(_input.location, _output.location);
 
-  size_t path_length = _input.path.size();
-  _output.path._maximum = static_cast<uint32_t>(path_length);
-  _output.path._length = static_cast<uint32_t>(path_length);
-  _output.path._buffer = 
-      FreeFleetData_RobotState_path_seq_allocbuf(path_length);
-  _output.path._release = false;
-  for (size_t i = 0; i < path_length; ++i)
+  borrow(_input.path.size(), _path_buffer, _output.path);
+  for (size_t i = 0; i < _input.path.size(); ++i)
     convert(_input.path[i], _output.path._buffer[i]);
+  clear(_output.compact_path);
 }
 
 void convert(const FreeFleetData_RobotState& _input, RobotState& _output)
 {
-  _output.name = std::string(_input.name);
-  _output.model = std::string(_input.model);
-  _output.task_id = std::string(_input.task_id);
+  _output.name.assign(_input.name);
+  _output.model.assign(_input.model);
+  _output.task_id.assign(_input.task_id);
   convert(_input.mode, _output.mode);
   _output.battery_percent = _input.battery_percent;
   convert(_input.location, _output.location);
+  convert_path(_input, _output.path);
+}
 
-  _output.path.clear();
-  for (uint32_t i = 0; i < _input.path._length; ++i)
-  {
-    Location tmp;
-    convert(_input.path._buffer[i], tmp);
-    _output.path.push_back(tmp);
-  }
+void convert(const Location& _input, FreeFleetData_BoundedLocation& _output)
+{
+  _output.sec = _input.sec;
+  _output.nanosec = _input.nanosec;
+  _output.x = _input.x;
+  _output.y = _input.y;
+  _output.yaw = _input.yaw;
+  copy_bounded(_input.level_name, _output.level_name);
+}
+
+void convert(const FreeFleetData_BoundedLocation& _input, Location& _output)
+{
+  _output.sec = _input.sec;
+  _output.nanosec = _input.nanosec;
+  _output.x = _input.x;
+  _output.y = _input.y;
+  _output.yaw = _input.yaw;
+  assign_bounded(_input.level_name, _output.level_name);
+  _output.level_id = 0;
 }
 
+void convert(
+    const RobotState& _input, FreeFleetData_BoundedRobotState& _output)
+{
+  copy_bounded(_input.name, _output.name);
+  copy_bounded(_input.model, _output.model);
+  copy_bounded(_input.task_id, _output.task_id);
+  convert(_input.mode, _output.mode);
+  _output.battery_percent = _input.battery_percent;
+  convert(_input.location, _output.location);
+
+  // Waypoints past the length are still sent, as the sample has a fixed
+  // size, but never read. They are zeroed, as a loaned sample holds whatever
+  // was last written to its memory.
+  const std::size_t path_length = std::min<std::size_t>(
+      _input.path.size(),
+      FreeFleetData_BoundedRobotState_Constants_PATH_SIZE);
+  _output.path_length = static_cast<uint32_t>(path_length);
+  for (std::size_t i = 0; i < path_length; ++i)
+    convert(_input.path[i], _output.path[i]);
+  std::memset(
+      _output.path + path_length, 0,
+      (FreeFleetData_BoundedRobotState_Constants_PATH_SIZE - path_length) *
+          sizeof(FreeFleetData_BoundedLocation));
+}
+
+void convert(
+    const FreeFleetData_BoundedRobotState& _input, RobotState& _output)
+{
+  assign_bounded(_input.name, _output.name);
+  assign_bounded(_input.model, _output.model);
+  assign_bounded(_input.task_id, _output.task_id);
+  convert(_input.mode, _output.mode);
+  _output.battery_percent = _input.battery_percent;
+  convert(_input.location, _output.location);
+
+  const uint32_t path_length = std::min<uint32_t>(
+      _input.path_length,
+      FreeFleetData_BoundedRobotState_Constants_PATH_SIZE);
+  _output.path.resize(path_length);
+  for (uint32_t i = 0; i < path_length; ++i)
+    convert(_input.path[i], _output.path[i]);
+}
 
 void convert(const ModeParameter& _input, FreeFleetData_ModeParameter& _output)
 {
-  _output.name = common::dds_string_alloc_and_copy(_input.name);
-  _output.value = common::dds_string_alloc_and_copy(_input.value);
+  _output.name = borrow(_input.name);
+  _output.value = borrow(_input.value);
 }
 
 void convert(const FreeFleetData_ModeParameter& _input, ModeParameter& _output)
 {
-  _output.name = std::string(_input.name);
-  _output.value = std::string(_input.value);
+  _output.name.assign(_input.name);
+  _output.value.assign(_input.value);
 }
 
-void convert(const ModeRequest& _input, FreeFleetData_ModeRequest& _output)
+void convert(
+    const ModeRequest& _input,
+    FreeFleetData_ModeRequest& _output,
+    std::vector<FreeFleetData_ModeParameter>& _parameters_buffer)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
+  _output.fleet_name = borrow(_input.fleet_name);
+  _output.robot_name = borrow(_input.robot_name);
   convert(_input.mode, _output.mode);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
-
-  size_t mode_parameter_num = _input.parameters.size();
-  _output.parameters._maximum = static_cast<uint32_t>(mode_parameter_num);
-  _output.parameters._length = static_cast<uint32_t>(mode_parameter_num);
-  _output.parameters._buffer = 
-      FreeFleetData_ModeRequest_parameters_seq_allocbuf(mode_parameter_num);
-  for (size_t i = 0; i < mode_parameter_num; ++i)
+  _output.task_id = borrow(_input.task_id);
+
+  borrow(_input.parameters.size(), _parameters_buffer, _output.parameters);
+  for (size_t i = 0; i < _input.parameters.size(); ++i)
     convert(_input.parameters[i], _output.parameters._buffer[i]);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
 }
 
 void convert(const FreeFleetData_ModeRequest& _input, ModeRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
+  _output.fleet_name.assign(_input.fleet_name);
+  _output.robot_name.assign(_input.robot_name);
   convert(_input.mode, _output.mode);
-  _output.task_id = std::string(_input.task_id);
+  _output.task_id.assign(_input.task_id);
 
-  _output.parameters.clear();
+  _output.parameters.resize(_input.parameters._length);
   for (uint32_t i = 0; i < _input.parameters._length; ++i)
-  {
-    ModeParameter tmp;
-    convert(_input.parameters._buffer[i], tmp);
-    _output.parameters.push_back(tmp);
-  }
+    convert(_input.parameters._buffer[i], _output.parameters[i]);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
 }
 
-void convert(const PathRequest& _input, FreeFleetData_PathRequest& _output)
+void convert(
+    const PathRequest& _input,
+    FreeFleetData_PathRequest& _output,
+    std::vector<FreeFleetData_Location>& _path_buffer)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
+  _output.fleet_name = borrow(_input.fleet_name);
+  _output.robot_name = borrow(_input.robot_name);
 
-  size_t path_length = _input.path.size();
-  _output.path._maximum = static_cast<uint32_t>(path_length);
-  _output.path._length = static_cast<uint32_t>(path_length);
-  _output.path._buffer = 
-      FreeFleetData_PathRequest_path_seq_allocbuf(path_length);
-  for (size_t i = 0; i < path_length; ++i)
+  borrow(_input.path.size(), _path_buffer, _output.path);
+  for (size_t i = 0; i < _input.path.size(); ++i)
     convert(_input.path[i], _output.path._buffer[i]);
+  clear(_output.compact_path);
 
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  _output.task_id = borrow(_input.task_id);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
 }
 
 void convert(const FreeFleetData_PathRequest& _input, PathRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
+  _output.fleet_name.assign(_input.fleet_name);
+  _output.robot_name.assign(_input.robot_name);
 
-  _output.path.clear();
-  for (uint32_t i = 0; i < _input.path._length; ++i)
-  {
-    Location tmp;
-    convert(_input.path._buffer[i], tmp);
-    _output.path.push_back(tmp);
-  }
+  convert_path(_input, _output.path);
 
-  _output.task_id = std::string(_input.task_id);
+  _output.task_id.assign(_input.task_id);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
 }
 
 void convert(
     const DestinationRequest& _input, 
     FreeFleetData_DestinationRequest& _output)
 {
-  _output.fleet_name = common::dds_string_alloc_and_copy(_input.fleet_name);
-  _output.robot_name = common::dds_string_alloc_and_copy(_input.robot_name);
+  _output.fleet_name = borrow(_input.fleet_name);
+  _output.robot_name = borrow(_input.robot_name);
   convert(_input.destination, _output.destination);
-  _output.task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  _output.task_id = borrow(_input.task_id);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
 }
 
 void convert(
     const FreeFleetData_DestinationRequest& _input,
     DestinationRequest& _output)
 {
-  _output.fleet_name = std::string(_input.fleet_name);
-  _output.robot_name = std::string(_input.robot_name);
+  _output.fleet_name.assign(_input.fleet_name);
+  _output.robot_name.assign(_input.robot_name);
   convert(_input.destination, _output.destination);
-  _output.task_id = std::string(_input.task_id);
+  _output.task_id.assign(_input.task_id);
+  _output.fleet_id = _input.fleet_id;
+  _output.robot_id = _input.robot_id;
+}
+
+void convert(const RequestAck& _input, FreeFleetData_RequestAck& _output)
+{
+  _output.fleet_name = borrow(_input.fleet_name);
+  _output.robot_name = borrow(_input.robot_name);
+  _output.task_id = borrow(_input.task_id);
+  _output.request_type = _input.request_type;
+  _output.accepted = _input.accepted;
+  _output.reason = borrow(_input.reason);
+}
+
+void convert(const FreeFleetData_RequestAck& _input, RequestAck& _output)
+{
+  _output.fleet_name.assign(_input.fleet_name);
+  _output.robot_name.assign(_input.robot_name);
+  _output.task_id.assign(_input.task_id);
+  _output.request_type = _input.request_type;
+  _output.accepted = _input.accepted;
+  _output.reason.assign(_input.reason);
+}
+
+void encode_path(
+    const FreeFleetData_Location* _path,
+    uint32_t _size,
+    std::vector<uint8_t>& _output)
+{
+  _output.clear();
+  put_varint(_size, _output);
+  if (_size == 0)
+    return;
+
+  // Differences are taken to the previous values as the receiver decodes
+  // them, so that rounding errors do not add up along the path.
+  int64_t previous_nanosec = get_nanosec(_path[0]);
+  put_varint(zigzag(_path[0].sec), _output);
+  put_varint(_path[0].nanosec, _output);
+
+  int64_t previous_x = 0;
+  int64_t previous_y = 0;
+  int64_t previous_yaw = 0;
+  for (uint32_t i = 0; i < _size; ++i)
+  {
+    const FreeFleetData_Location& location = _path[i];
+    if (i > 0)
+    {
+      const int64_t time_steps = static_cast<int64_t>(std::llround(
+          static_cast<double>(get_nanosec(location) - previous_nanosec) /
+          static_cast<double>(nanosec_per_time_step)));
+      put_varint(zigzag(time_steps), _output);
+      previous_nanosec += time_steps * nanosec_per_time_step;
+    }
+
+    const int64_t x = quantize(location.x, position_scale);
+    const int64_t y = quantize(location.y, position_scale);
+    const int64_t yaw = quantize(location.yaw, yaw_scale);
+    put_varint(zigzag(x - previous_x), _output);
+    put_varint(zigzag(y - previous_y), _output);
+    put_varint(zigzag(yaw - previous_yaw), _output);
+    previous_x = x;
+    previous_y = y;
+    previous_yaw = yaw;
+  }
+
+  uint32_t num_runs = 1;
+  for (uint32_t i = 1; i < _size; ++i)
+  {
+    if (!is_same_level(_path[i - 1], _path[i]))
+      ++num_runs;
+  }
+  put_varint(num_runs, _output);
+
+  uint32_t run_start = 0;
+  for (uint32_t i = 1; i <= _size; ++i)
+  {
+    if (i < _size && is_same_level(_path[run_start], _path[i]))
+      continue;
+
+    const FreeFleetData_Location& location = _path[run_start];
+    const std::size_t name_length = std::strlen(location.level_name);
+    put_varint(i - run_start, _output);
+    put_varint(location.level_id, _output);
+    put_varint(name_length, _output);
+    _output.insert(
+        _output.end(), location.level_name, location.level_name + name_length);
+    run_start = i;
+  }
+}
+
+bool decode_path(
+    const uint8_t* _data, uint32_t _size, std::vector<Location>& _output)
+{
+  ByteReader reader{_data, _size, 0};
+
+  // Every waypoint takes at least three bytes, which bounds the size before
+  // anything is allocated for it.
+  uint64_t num_waypoints;
+  if (!reader.read_varint(num_waypoints) || num_waypoints > _size / 3)
+    return false;
+  _output.resize(static_cast<std::size_t>(num_waypoints));
+  if (num_waypoints == 0)
+    return reader.offset == _size;
+
+  int64_t sec;
+  uint64_t nanosec;
+  if (!reader.read_signed(sec) ||
+      sec < INT32_MIN || sec > INT32_MAX ||
+      !reader.read_varint(nanosec) ||
+      nanosec >= static_cast<uint64_t>(nanosec_per_sec))
+    return false;
+  int64_t current_nanosec =
+      sec * nanosec_per_sec + static_cast<int64_t>(nanosec);
+
+  int64_t x = 0;
+  int64_t y = 0;
+  int64_t yaw = 0;
+  for (std::size_t i = 0; i < _output.size(); ++i)
+  {
+    int64_t time_steps = 0;
+    int64_t dx;
+    int64_t dy;
+    int64_t dyaw;
+    if ((i > 0 && !reader.read_signed(time_steps)) ||
+        !reader.read_signed(dx) ||
+        !reader.read_signed(dy) ||
+        !reader.read_signed(dyaw) ||
+        !is_within(time_steps, max_time_steps) ||
+        !is_within(dx, 2 * max_quantized_value) ||
+        !is_within(dy, 2 * max_quantized_value) ||
+        !is_within(dyaw, 2 * max_quantized_value))
+      return false;
+
+    current_nanosec += time_steps * nanosec_per_time_step;
+    x += dx;
+    y += dy;
+    yaw += dyaw;
+    if (!is_within(current_nanosec, max_path_nanosec) ||
+        !is_within(x, max_quantized_value) ||
+        !is_within(y, max_quantized_value) ||
+        !is_within(yaw, max_quantized_value))
+      return false;
+
+    Location& location = _output[i];
+    set_time(current_nanosec, location);
+    location.x = static_cast<float>(static_cast<double>(x) / position_scale);
+    location.y = static_cast<float>(static_cast<double>(y) / position_scale);
+    location.yaw = static_cast<float>(static_cast<double>(yaw) / yaw_scale);
+  }
+
+  uint64_t num_runs;
+  if (!reader.read_varint(num_runs))
+    return false;
+  std::size_t run_start = 0;
+  for (uint64_t run = 0; run < num_runs; ++run)
+  {
+    uint64_t run_length;
+    uint64_t level_id;
+    if (!reader.read_varint(run_length) ||
+        run_length == 0 ||
+        run_length > _output.size() - run_start ||
+        !reader.read_varint(level_id) ||
+        level_id > UINT32_MAX ||
+        !reader.read_string(_output[run_start].level_name))
+      return false;
+
+    const std::size_t run_end =
+        run_start + static_cast<std::size_t>(run_length);
+    _output[run_start].level_id = static_cast<uint32_t>(level_id);
+    for (std::size_t i = run_start + 1; i < run_end; ++i)
+    {
+      _output[i].level_name.assign(_output[run_start].level_name);
+      _output[i].level_id = _output[run_start].level_id;
+    }
+    run_start = run_end;
+  }
+  return run_start == _output.size() && reader.offset == _size;
+}
+
+void compact_path(
+    FreeFleetData_RobotState& _sample, std::vector<uint8_t>& _buffer)
+{
+  compact_path_of(_sample, _buffer);
+}
+
+void compact_path(
+    FreeFleetData_PathRequest& _sample, std::vector<uint8_t>& _buffer)
+{
+  compact_path_of(_sample, _buffer);
 }
 
 } // namespace messages
@@ -18,6 +18,9 @@
 #ifndef FREE_FLEET__SRC__MESSAGES__MESSAGE_UTILS_HPP
 #define FREE_FLEET__SRC__MESSAGES__MESSAGE_UTILS_HPP
 
+#include <vector>
+#include <cstdint>
+
 #include <free_fleet/messages/Location.hpp>
 #include <free_fleet/messages/RobotMode.hpp>
 #include <free_fleet/messages/RobotState.hpp>
@@ -25,12 +28,24 @@
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 
 #include "FleetMessages.h"
 
 namespace free_fleet {
 namespace messages {
 
+// Conversions into DDS samples do not copy or allocate anything: the strings
+// of the sample point into the strings of the input, and sequences point into
+// the given buffers, which only grow when a longer sequence than before is
+// converted. The sample is therefore only valid while the input and buffers
+// are alive and unchanged, which is long enough for it to be written, and it
+// must never be freed with the DDS free functions.
+//
+// Conversions from DDS samples assign into the output, reusing the capacity
+// of its strings and vectors, so converting into the same output again does
+// not allocate once it is large enough.
+
 void convert(const RobotMode& _input, FreeFleetData_RobotMode& _output);
 
 void convert(const FreeFleetData_RobotMode& _input, RobotMode& _output);
@@ -39,19 +54,43 @@ void convert(const Location& _input, FreeFleetData_Location& _output);
 
 void convert(const FreeFleetData_Location& _input, Location& _output);
 
-void convert(const RobotState& _input, FreeFleetData_RobotState& _output);
+void convert(
+    const RobotState& _input,
+    FreeFleetData_RobotState& _output,
+    std::vector<FreeFleetData_Location>& _path_buffer);
 
 void convert(const FreeFleetData_RobotState& _input, RobotState& _output);
 
+// Conversions into bounded DDS samples copy everything into the fixed size
+// sample, so they never allocate and the sample does not depend on the
+// input. Strings longer than their bound are truncated, and only the first
+// BoundedRobotState_Constants_PATH_SIZE waypoints of a path are kept.
+
+void convert(const Location& _input, FreeFleetData_BoundedLocation& _output);
+
+void convert(const FreeFleetData_BoundedLocation& _input, Location& _output);
+
+void convert(
+    const RobotState& _input, FreeFleetData_BoundedRobotState& _output);
+
+void convert(
+    const FreeFleetData_BoundedRobotState& _input, RobotState& _output);
+
 void convert(const ModeParameter& _input, FreeFleetData_ModeParameter& _output);
 
 void convert(const FreeFleetData_ModeParameter& _input, ModeParameter& _output);
 
-void convert(const ModeRequest& _input, FreeFleetData_ModeRequest& _output);
+void convert(
+    const ModeRequest& _input,
+    FreeFleetData_ModeRequest& _output,
+    std::vector<FreeFleetData_ModeParameter>& _parameters_buffer);
 
 void convert(const FreeFleetData_ModeRequest& _input, ModeRequest& _output);
 
-void convert(const PathRequest& _input, FreeFleetData_PathRequest& _output);
+void convert(
+    const PathRequest& _input,
+    FreeFleetData_PathRequest& _output,
+    std::vector<FreeFleetData_Location>& _path_buffer);
 
 void convert(const FreeFleetData_PathRequest& _input, PathRequest& _output);
 
@@ -63,6 +102,39 @@ void convert(
     const FreeFleetData_DestinationRequest& _input,
     DestinationRequest& _output);
 
+void convert(const RequestAck& _input, FreeFleetData_RequestAck& _output);
+
+void convert(const FreeFleetData_RequestAck& _input, RequestAck& _output);
+
+// Paths can also be sent compactly, as a sequence of octets in place of the
+// sequence of locations. The first waypoint keeps its exact time, while the
+// times of the others are sent in milliseconds relative to the previous
+// waypoint. Coordinates are quantized to millimeters and yaws to
+// milliradians, and only their differences to the previous waypoint are
+// sent, all as variable length integers. Levels are sent once for every run
+// of waypoints on the same level. Conversions from DDS samples decode compact
+// paths transparently, so only senders need to choose.
+
+/// Encodes a path, replacing the contents of the output.
+void encode_path(
+    const FreeFleetData_Location* _path,
+    uint32_t _size,
+    std::vector<uint8_t>& _output);
+
+/// Decodes a path into the output, reusing its capacity. Returns false if the
+/// data is not a valid compact path, in which case the output is undefined.
+bool decode_path(
+    const uint8_t* _data, uint32_t _size, std::vector<Location>& _output);
+
+/// Replaces the path of a converted sample with its compact encoding, which
+/// is written into the buffer and borrowed by the sample like any other
+/// sequence.
+void compact_path(
+    FreeFleetData_RobotState& _sample, std::vector<uint8_t>& _buffer);
+
+void compact_path(
+    FreeFleetData_PathRequest& _sample, std::vector<uint8_t>& _buffer);
+
 } // namespace 
 } // namespace free_fleet
 
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <free_fleet/ClientConfig.hpp>
+#include <free_fleet/RobotStateFilter.hpp>
+#include <free_fleet/messages/RobotMode.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+#include "test_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::tests;
+
+std::size_t get_cdr_size(const messages::Location& _location)
+{
+  return 5 * 4 + get_cdr_size(_location.level_name) + 4;
+}
+
+/// Estimated serialized size of a robot state sample sent with its path as
+/// locations, with its encapsulation header.
+std::size_t get_cdr_size(const messages::RobotState& _robot_state)
+{
+  std::size_t size = 4 + get_cdr_size(_robot_state.name) +
+      get_cdr_size(_robot_state.model) + get_cdr_size(_robot_state.task_id) +
+      4 + 4 + get_cdr_size(_robot_state.location) + 4 + 4;
+  for (const messages::Location& location : _robot_state.path)
+    size += get_cdr_size(location);
+  return size;
+}
+
+/// Robot of the simulated fleet. Some sit on their charger or are parked,
+/// the others carry out tasks of a few waypoints, resting for a while
+/// between them.
+struct SimulatedRobot
+{
+  messages::RobotState state;
+  bool charger = false;
+  bool parked = false;
+  double speed = 0.0;
+  double x = 0.0;
+  double y = 0.0;
+  double rest_until = 0.0;
+  int num_tasks = 0;
+  std::mt19937 random;
+};
+
+/// Robot state the server last received with every way of publishing.
+struct Receiver
+{
+  Receiver(const char* _name, std::size_t _num_robots) :
+    name(_name),
+    last_x(_num_robots, 0.0),
+    last_y(_num_robots, 0.0),
+    last_time(_num_robots, -1.0)
+  {}
+
+  const char* name;
+  std::size_t samples = 0;
+  std::size_t bytes = 0;
+  double max_position_error = 0.0;
+  double max_gap = 0.0;
+  double min_interval = 1e9;
+  std::vector<double> last_x;
+  std::vector<double> last_y;
+  std::vector<double> last_time;
+
+  void receive(
+      std::size_t _robot, const SimulatedRobot& _sim_robot, double _now)
+  {
+    if (last_time[_robot] >= 0.0)
+      min_interval = std::min(min_interval, _now - last_time[_robot]);
+    ++samples;
+    bytes += get_cdr_size(_sim_robot.state);
+    last_x[_robot] = _sim_robot.x;
+    last_y[_robot] = _sim_robot.y;
+    last_time[_robot] = _now;
+  }
+
+  void measure(
+      std::size_t _robot, const SimulatedRobot& _sim_robot, double _now)
+  {
+    max_position_error = std::max(max_position_error, std::hypot(
+        _sim_robot.x - last_x[_robot], _sim_robot.y - last_y[_robot]));
+    max_gap = std::max(max_gap, _now - last_time[_robot]);
+  }
+};
+
+SimulatedRobot make_robot(std::size_t _index, std::size_t _num_robots)
+{
+  SimulatedRobot sim_robot;
+  sim_robot.random.seed(static_cast<unsigned>(_index));
+  sim_robot.state.name = "adaptive_robot_" + std::to_string(_index);
+  sim_robot.state.model = "adaptive_model";
+  sim_robot.state.battery_percent = 50.0f;
+  sim_robot.state.location.level_name = "L1";
+  sim_robot.x = static_cast<double>(_index % 10) * 3.0;
+  sim_robot.y = static_cast<double>(_index / 10) * 3.0;
+
+  // A fifth of the fleet charges and another fifth is parked, while the
+  // rest move at walking pace or faster, resting at first for a spread out
+  // time.
+  sim_robot.charger = _index % 5 == 0;
+  sim_robot.parked = _index % 5 == 1;
+  sim_robot.speed = 0.5 + 0.75 * static_cast<double>(_index % 3);
+  sim_robot.rest_until =
+      60.0 * static_cast<double>(_index) / static_cast<double>(_num_robots);
+  sim_robot.state.mode.mode = sim_robot.charger ?
+      messages::RobotMode::MODE_CHARGING : messages::RobotMode::MODE_IDLE;
+  return sim_robot;
+}
+
+void step(SimulatedRobot& _sim_robot, double _now, double _dt)
+{
+  messages::RobotState& state = _sim_robot.state;
+  if (_sim_robot.charger)
+  {
+    state.battery_percent =
+        std::min(100.0f, state.battery_percent + static_cast<float>(0.02 * _dt));
+  }
+  else if (!_sim_robot.parked && state.path.empty() &&
+      _now >= _sim_robot.rest_until)
+  {
+    std::uniform_real_distribution<double> coordinate(0.0, 30.0);
+    state.task_id =
+        state.name + "_task_" + std::to_string(++_sim_robot.num_tasks);
+    state.mode.mode = messages::RobotMode::MODE_MOVING;
+    for (int i = 0; i < 8; ++i)
+    {
+      messages::Location waypoint;
+      waypoint.sec = static_cast<int32_t>(_now) + 10 * (i + 1);
+      waypoint.nanosec = 0;
+      waypoint.x = static_cast<float>(coordinate(_sim_robot.random));
+      waypoint.y = static_cast<float>(coordinate(_sim_robot.random));
+      waypoint.yaw = 0.0f;
+      waypoint.level_name = "L1";
+      state.path.push_back(waypoint);
+    }
+  }
+  else if (!state.path.empty())
+  {
+    const double dx = state.path.front().x - _sim_robot.x;
+    const double dy = state.path.front().y - _sim_robot.y;
+    const double distance = std::hypot(dx, dy);
+    const double travel = _sim_robot.speed * _dt;
+    if (distance <= travel)
+    {
+      _sim_robot.x = state.path.front().x;
+      _sim_robot.y = state.path.front().y;
+      state.path.erase(state.path.begin());
+    }
+    else
+    {
+      _sim_robot.x += dx / distance * travel;
+      _sim_robot.y += dy / distance * travel;
+      state.location.yaw = static_cast<float>(std::atan2(dy, dx));
+    }
+    state.battery_percent -= static_cast<float>(0.01 * _dt);
+
+    if (state.path.empty())
+    {
+      state.mode.mode = messages::RobotMode::MODE_IDLE;
+      _sim_robot.rest_until = _now + 60.0;
+    }
+  }
+
+  state.location.sec = static_cast<int32_t>(_now);
+  state.location.nanosec =
+      static_cast<uint32_t>((_now - std::floor(_now)) * 1e9);
+  state.location.x = static_cast<float>(_sim_robot.x);
+  state.location.y = static_cast<float>(_sim_robot.y);
+}
+
+/// States given at the rate cap by a timer that jitters by a tenth of a
+/// period must all be sent while the robot moves, instead of every other one
+/// being held back for coming in a little early.
+bool check_jitter(const ClientConfig& _config)
+{
+  RobotStateFilter filter(_config);
+  SimulatedRobot sim_robot = make_robot(2, 1);
+  sim_robot.rest_until = 0.0;
+
+  std::mt19937 random(0);
+  const long period_us = std::lround(_config.state_min_period * 1e6);
+  std::uniform_int_distribution<long> jitter(-period_us / 10, period_us / 10);
+  const long num_ticks = 100;
+  long num_sent = 0;
+  long last_sent_us = 0;
+  long min_interval_us = period_us;
+  for (long tick = 0; tick < num_ticks; ++tick)
+  {
+    // Keeps the robot moving so that every state changed enough to be sent.
+    sim_robot.state.location.x = static_cast<float>(tick);
+    const long now_us = tick * period_us + jitter(random);
+    if (!filter.should_send(
+        sim_robot.state,
+        RobotStateFilter::Clock::time_point(
+            std::chrono::microseconds(now_us))))
+      continue;
+
+    if (num_sent > 0)
+      min_interval_us = std::min(min_interval_us, now_us - last_sent_us);
+    ++num_sent;
+    last_sent_us = now_us;
+  }
+
+  printf("  jittered states sent %ld of %ld, closest %.3f s apart\n",
+      num_sent, num_ticks, static_cast<double>(min_interval_us) * 1e-6);
+  return check(num_sent == num_ticks, "jittered states sent") &&
+      check(min_interval_us * 4 >= period_us * 3, "jittered rate cap");
+}
+
+int main(int argc, char** argv)
+{
+  // Simulates a fleet of robots, of which some charge and the rest carry out
+  // tasks with rests in between, and compares the bytes of robot states sent
+  // at a fixed rate of 1 Hz, at a fixed rate of 10 Hz, and adaptively with a
+  // heartbeat of 1 Hz and a cap of 10 Hz, together with how far the robots
+  // the server sees are from where they actually are.
+  std::size_t num_robots = 100;
+  double duration = 600.0;
+  if (argc > 1)
+    num_robots = static_cast<std::size_t>(std::stoul(argv[1]));
+  if (argc > 2)
+    duration = std::stod(argv[2]);
+
+  ClientConfig config;
+  config.adaptive_state_publishing = true;
+  const double dt = config.state_min_period;
+  const int ticks_per_heartbeat =
+      static_cast<int>(std::lround(config.state_heartbeat_period / dt));
+
+  std::vector<SimulatedRobot> sim_robots;
+  std::vector<RobotStateFilter> filters;
+  for (std::size_t i = 0; i < num_robots; ++i)
+  {
+    sim_robots.push_back(make_robot(i, num_robots));
+    filters.emplace_back(config);
+  }
+
+  Receiver fixed_slow("fixed 1 Hz", num_robots);
+  Receiver fixed_fast("fixed 10 Hz", num_robots);
+  Receiver adaptive("adaptive", num_robots);
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const long num_ticks = std::lround(duration / dt);
+  for (long tick = 0; tick < num_ticks; ++tick)
+  {
+    const double now = static_cast<double>(tick) * dt;
+    const RobotStateFilter::Clock::time_point filter_now =
+        RobotStateFilter::Clock::time_point(
+            std::chrono::duration_cast<RobotStateFilter::Clock::duration>(
+                std::chrono::milliseconds(tick * 100)));
+    for (std::size_t i = 0; i < num_robots; ++i)
+    {
+      SimulatedRobot& sim_robot = sim_robots[i];
+      step(sim_robot, now, dt);
+
+      // Robots started at different times publish at different phases.
+      if ((tick + static_cast<long>(i)) % ticks_per_heartbeat == 0)
+        fixed_slow.receive(i, sim_robot, now);
+      fixed_fast.receive(i, sim_robot, now);
+      if (filters[i].should_send(sim_robot.state, filter_now))
+        adaptive.receive(i, sim_robot, now);
+
+      if (tick >= ticks_per_heartbeat)
+      {
+        fixed_slow.measure(i, sim_robot, now);
+        fixed_fast.measure(i, sim_robot, now);
+        adaptive.measure(i, sim_robot, now);
+      }
+    }
+  }
+  const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+
+  printf("=== %lu robots for %.0f s, states given every %.2f s\n",
+      static_cast<unsigned long>(num_robots), duration, dt);
+  printf("  %-12s %10s %12s %10s %10s %12s\n",
+      "publishing", "samples", "bytes", "bytes/s", "max gap", "max error");
+  for (const Receiver* receiver : {&fixed_slow, &fixed_fast, &adaptive})
+  {
+    printf("  %-12s %10lu %12lu %10.0f %8.2f s %10.3f m\n",
+        receiver->name,
+        static_cast<unsigned long>(receiver->samples),
+        static_cast<unsigned long>(receiver->bytes),
+        static_cast<double>(receiver->bytes) / duration,
+        receiver->max_gap,
+        receiver->max_position_error);
+  }
+  printf("  adaptive saves %.1f%% of the bytes of 10 Hz, and sends %.1f "
+      "times the bytes of 1 Hz\n",
+      100.0 * (1.0 - static_cast<double>(adaptive.bytes) /
+          static_cast<double>(fixed_fast.bytes)),
+      static_cast<double>(adaptive.bytes) /
+          static_cast<double>(fixed_slow.bytes));
+  printf("  filtered %lu states in %.3f s\n",
+      static_cast<unsigned long>(num_robots * num_ticks), elapsed);
+
+  // Every robot is heard from at least once a heartbeat and never more often
+  // than the cap, and is never further away than the threshold from where
+  // the server last saw it.
+  bool passed =
+      check(adaptive.max_gap <= config.state_heartbeat_period + 1e-6,
+          "heartbeat") &&
+      check(adaptive.min_interval >= config.state_min_period - 1e-6,
+          "rate cap") &&
+      check(adaptive.max_position_error <=
+          config.state_position_threshold + 1e-3, "position error") &&
+      check_jitter(config);
+
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -64,7 +64,7 @@ int main (int argc, char ** argv)
 
   /* Create a Writer. */
   qos = dds_create_qos();
-  dds_qset_reliability(qos, DDS_RELIABILITY_BEST_EFFORT, 0);
+  dds_qset_reliability(qos, DDS_RELIABILITY_RELIABLE, DDS_MSECS(100));
   writer = dds_create_writer (participant, topic, qos, NULL);
   if (writer < 0)
     DDS_FATAL("dds_create_write: %s\n", dds_strretcode(-writer));
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <dds/dds.h>
+
+#include <free_fleet/QoSProfile.hpp>
+
+#include "../messages/FleetMessages.h"
+#include "../dds_utils/common.hpp"
+#include "../dds_utils/DDSPublishHandler.hpp"
+#include "../dds_utils/DDSSubscribeHandler.hpp"
+
+using namespace free_fleet;
+
+/// Publishes robot states with the given profile on both ends, stamping each
+/// with the time it was written, and reports the latency of every state
+/// received through the subscriber callback, as well as how many were lost.
+bool run_profile(
+    const std::string& _preset, long _num_states, long _period_us)
+{
+  QoSProfile qos;
+  if (!QoSProfile::from_preset(_preset, qos))
+    return false;
+
+  dds_entity_t pub_participant = dds_create_participant(42, NULL, NULL);
+  dds_entity_t sub_participant = dds_create_participant(42, NULL, NULL);
+  if (pub_participant < 0 || sub_participant < 0)
+    DDS_FATAL("dds_create_participant failed\n");
+
+  const std::string topic_name = "qos_bench_" + _preset;
+  std::mutex latencies_mutex;
+  std::vector<double> latencies_ms;
+  latencies_ms.reserve(static_cast<size_t>(_num_states));
+  long num_warm_up = 0;
+  uint64_t num_dropped = 0;
+
+  {
+    dds::DDSPublishHandler<FreeFleetData_RobotState> state_pub(
+        pub_participant, &FreeFleetData_RobotState_desc, topic_name, qos);
+    dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10> state_sub(
+        sub_participant, &FreeFleetData_RobotState_desc, topic_name, qos);
+    if (!state_pub.is_ready() || !state_sub.is_ready())
+      return false;
+
+    state_sub.set_callback(
+        [&](const FreeFleetData_RobotState& _state)
+        {
+          const dds_time_t now = dds_time();
+          std::unique_lock<std::mutex> lock(latencies_mutex);
+          // Warm up samples are marked with a negative timestamp.
+          if (_state.location.sec < 0)
+          {
+            ++num_warm_up;
+            return;
+          }
+          const dds_time_t sent =
+              static_cast<dds_time_t>(_state.location.sec) * 1000000000LL +
+              static_cast<dds_time_t>(_state.location.nanosec);
+          latencies_ms.push_back(static_cast<double>(now - sent) / 1e6);
+        });
+
+    FreeFleetData_RobotState* msg = FreeFleetData_RobotState__alloc();
+    msg->name = common::dds_string_alloc_and_copy("qos_bench_robot");
+    msg->model = common::dds_string_alloc_and_copy("qos_bench_model");
+    msg->task_id = common::dds_string_alloc_and_copy("");
+    msg->location.level_name = common::dds_string_alloc_and_copy("L1");
+
+    bool matched = false;
+    for (int i = 0; i < 500 && !matched; ++i)
+    {
+      msg->location.sec = -1;
+      state_pub.write(msg);
+      dds_sleepfor(DDS_MSECS(20));
+      std::unique_lock<std::mutex> lock(latencies_mutex);
+      matched = num_warm_up > 0;
+    }
+    if (!matched)
+    {
+      printf("=== [%s] Reader was never matched.\n", _preset.c_str());
+      FreeFleetData_RobotState_free(msg, DDS_FREE_ALL);
+      return false;
+    }
+
+    for (long i = 0; i < _num_states; ++i)
+    {
+      const dds_time_t now = dds_time();
+      msg->location.sec = static_cast<int32_t>(now / 1000000000LL);
+      msg->location.nanosec = static_cast<uint32_t>(now % 1000000000LL);
+      state_pub.write(msg);
+      if (_period_us > 0)
+        dds_sleepfor(DDS_USECS(_period_us));
+    }
+
+    // Give the last samples, and any retransmissions, time to arrive.
+    dds_sleepfor(DDS_MSECS(500));
+    num_dropped = state_sub.get_dropped_count();
+    FreeFleetData_RobotState_free(msg, DDS_FREE_ALL);
+  }
+
+  dds_delete(pub_participant);
+  dds_delete(sub_participant);
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const long num_received = static_cast<long>(latencies_ms.size());
+  auto percentile = [&](double _p)
+  {
+    if (latencies_ms.empty())
+      return 0.0;
+    size_t index = static_cast<size_t>(_p * (latencies_ms.size() - 1));
+    return latencies_ms[index];
+  };
+
+  printf("=== [%s] %s\n", _preset.c_str(), qos.to_string().c_str());
+  printf("    sent %ld, received %ld, lost %.2f%%, dropped by reader %lu\n",
+      _num_states, num_received,
+      100.0 * static_cast<double>(_num_states - num_received) /
+          static_cast<double>(_num_states),
+      static_cast<unsigned long>(num_dropped));
+  printf("    latency p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+      percentile(0.5), percentile(0.99), percentile(1.0));
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  // Compares the latency and loss of the QoS presets. Both ends run in this
+  // process, so to see the effect of a lossy network, run it with the
+  // network emulated, for example with tc netem on the loopback interface.
+  long num_states = 10000;
+  long period_us = 1000;
+  if (argc > 1)
+    num_states = std::stol(argv[1]);
+  if (argc > 2)
+    period_us = std::stol(argv[2]);
+
+  printf("=== Publishing %ld robot states every %ld us per profile\n",
+      num_states, period_us);
+  for (const char* preset :
+      {"state_stream", "command_reliable", "command_urgent"})
+  {
+    if (!run_profile(preset, num_states, period_us))
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
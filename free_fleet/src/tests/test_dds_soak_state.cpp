@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+#include <dds/dds.h>
+
+#include "../messages/FleetMessages.h"
+#include "../dds_utils/common.hpp"
+#include "../dds_utils/DDSPublishHandler.hpp"
+#include "../dds_utils/DDSSubscribeHandler.hpp"
+
+using namespace free_fleet;
+
+/// Resident set size of this process in kilobytes.
+long get_rss_kb()
+{
+  long total_pages = 0;
+  long resident_pages = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> total_pages >> resident_pages;
+  return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(int argc, char** argv)
+{
+  // Publishes robot states with a 50 waypoint path and takes them back
+  // through the subscribe handler, alternating between take_all and read
+  // while holding on to the last read sample, then checks that the resident
+  // memory did not grow after warming up.
+  long num_states = 1000000;
+  long max_rss_growth_kb = 2048;
+  if (argc > 1)
+    num_states = std::stol(argv[1]);
+  if (argc > 2)
+    max_rss_growth_kb = std::stol(argv[2]);
+
+  dds_entity_t pub_participant = dds_create_participant(42, NULL, NULL);
+  dds_entity_t sub_participant = dds_create_participant(42, NULL, NULL);
+  if (pub_participant < 0 || sub_participant < 0)
+    DDS_FATAL("dds_create_participant failed\n");
+
+  const std::string topic_name = "soak_robot_state";
+  dds::DDSPublishHandler<FreeFleetData_RobotState> state_pub(
+      pub_participant, &FreeFleetData_RobotState_desc, topic_name);
+  QoSProfile state_qos;
+  state_qos.history_depth = 0;
+  state_qos.max_samples = 1000;
+  dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10> state_sub(
+      sub_participant, &FreeFleetData_RobotState_desc, topic_name, state_qos);
+  if (!state_pub.is_ready() || !state_sub.is_ready())
+    return EXIT_FAILURE;
+
+  FreeFleetData_RobotState* msg = FreeFleetData_RobotState__alloc();
+  msg->name = common::dds_string_alloc_and_copy("soak_robot");
+  msg->model = common::dds_string_alloc_and_copy("soak_model");
+  msg->task_id = common::dds_string_alloc_and_copy("soak_task");
+  msg->mode.mode = FreeFleetData_RobotMode_Constants_MODE_MOVING;
+  msg->battery_percent = 100.0;
+  msg->location.level_name = common::dds_string_alloc_and_copy("L1");
+  msg->path._maximum = 50;
+  msg->path._length = 50;
+  msg->path._buffer = FreeFleetData_RobotState_path_seq_allocbuf(50);
+  msg->path._release = true;
+  for (uint32_t i = 0; i < 50; ++i)
+  {
+    msg->path._buffer[i].sec = i;
+    msg->path._buffer[i].nanosec = 0;
+    msg->path._buffer[i].x = static_cast<float>(i);
+    msg->path._buffer[i].y = static_cast<float>(i);
+    msg->path._buffer[i].yaw = 0.0;
+    msg->path._buffer[i].level_name = common::dds_string_alloc_and_copy("L1");
+  }
+
+  printf("=== Waiting for the reader to be matched ...\n");
+  fflush(stdout);
+  bool matched = false;
+  for (int i = 0; i < 500 && !matched; ++i)
+  {
+    msg->location.sec = -1;
+    state_pub.write(msg);
+    matched = state_sub.take_all(
+        [](const FreeFleetData_RobotState&) {}) > 0;
+    dds_sleepfor(DDS_MSECS(20));
+  }
+  if (!matched)
+  {
+    printf("=== Reader was never matched.\n");
+    return EXIT_FAILURE;
+  }
+
+  long received = 0;
+  long baseline_rss_kb = 0;
+  bool aliased = false;
+  std::shared_ptr<const FreeFleetData_RobotState> held_state;
+  int32_t held_sec = 0;
+
+  printf("=== Publishing %ld robot states ...\n", num_states);
+  fflush(stdout);
+  for (long i = 0; i < num_states; ++i)
+  {
+    msg->location.sec = static_cast<int32_t>(i);
+    state_pub.write(msg);
+
+    if (i % 2 == 0)
+    {
+      received += state_sub.take_all(
+          [](const FreeFleetData_RobotState&) {});
+    }
+    else
+    {
+      auto states = state_sub.read();
+      if (!states.empty())
+      {
+        received += static_cast<long>(states.size());
+
+        // Samples that are still held must never be overwritten by later
+        // takes.
+        if (held_state && held_state->location.sec != held_sec)
+          aliased = true;
+        held_state = states.back();
+        held_sec = held_state->location.sec;
+      }
+    }
+
+    if (i == num_states / 10)
+      baseline_rss_kb = get_rss_kb();
+  }
+  held_state.reset();
+  received += state_sub.take_all([](const FreeFleetData_RobotState&) {});
+
+  const long final_rss_kb = get_rss_kb();
+  printf("=== Received %ld robot states, dropped %lu\n",
+      received, static_cast<unsigned long>(state_sub.get_dropped_count()));
+  printf("=== RSS after warm up: %ld kB, at the end: %ld kB\n",
+      baseline_rss_kb, final_rss_kb);
+
+  FreeFleetData_RobotState_free(msg, DDS_FREE_ALL);
+  dds_delete(pub_participant);
+  dds_delete(sub_participant);
+
+  if (aliased)
+  {
+    printf("=== FAILED: held samples were overwritten by later takes.\n");
+    return EXIT_FAILURE;
+  }
+  if (final_rss_kb - baseline_rss_kb > max_rss_growth_kb)
+  {
+    printf("=== FAILED: RSS grew by more than %ld kB.\n", max_rss_growth_kb);
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include <dds/dds.h>
+
+#include "../messages/FleetMessages.h"
+#include "../dds_utils/common.hpp"
+#include "../dds_utils/DDSPublishHandler.hpp"
+#include "../dds_utils/DDSSubscribeHandler.hpp"
+
+using namespace free_fleet;
+
+const std::string ping_topic = "transport_latency_ping";
+const std::string pong_topic = "transport_latency_pong";
+
+using StatePub = dds::DDSPublishHandler<FreeFleetData_RobotState>;
+using StateSub = dds::DDSSubscribeHandler<FreeFleetData_RobotState, 10>;
+
+/// Seconds of CPU time used so far by this process, or by its waited for
+/// children.
+double get_cpu_seconds(int _who)
+{
+  struct rusage usage;
+  getrusage(_who, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+      static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) /
+          1e6;
+}
+
+/// Robot state the size of what a client sends while following a path.
+FreeFleetData_RobotState* make_robot_state(uint32_t _num_waypoints)
+{
+  FreeFleetData_RobotState* msg = FreeFleetData_RobotState__alloc();
+  msg->name = common::dds_string_alloc_and_copy("latency_robot");
+  msg->model = common::dds_string_alloc_and_copy("latency_model");
+  msg->task_id = common::dds_string_alloc_and_copy("latency_task");
+  msg->mode.mode = FreeFleetData_RobotMode_Constants_MODE_MOVING;
+  msg->battery_percent = 100.0;
+  msg->location.level_name = common::dds_string_alloc_and_copy("L1");
+  msg->path._maximum = _num_waypoints;
+  msg->path._length = _num_waypoints;
+  msg->path._buffer =
+      FreeFleetData_RobotState_path_seq_allocbuf(_num_waypoints);
+  msg->path._release = true;
+  for (uint32_t i = 0; i < _num_waypoints; ++i)
+  {
+    msg->path._buffer[i].sec = static_cast<int32_t>(i);
+    msg->path._buffer[i].nanosec = 0;
+    msg->path._buffer[i].x = static_cast<float>(i);
+    msg->path._buffer[i].y = static_cast<float>(i);
+    msg->path._buffer[i].yaw = 0.0;
+    msg->path._buffer[i].level_name = common::dds_string_alloc_and_copy("L1");
+  }
+  return msg;
+}
+
+/// Loans a fixed size robot state from a writer and writes it, which is how
+/// clients publish bounded robot states. CycloneDDS only loans samples of
+/// types marked as fixed size, and only from 0.9 on, older releases always
+/// write from memory of our own.
+bool loan_bounded_state(dds_entity_t _participant)
+{
+#ifdef FREE_FLEET_DDS_SHARED_MEMORY
+  const dds_entity_t topic = dds_create_topic(
+      _participant, &FreeFleetData_BoundedRobotState_desc,
+      "transport_latency_loan", NULL, NULL);
+  if (topic < 0)
+    return false;
+  dds_qos_t* qos = common::dds_qos_create(QoSProfile::state_stream());
+  const dds_entity_t writer = dds_create_writer(_participant, topic, qos, NULL);
+  dds_delete_qos(qos);
+  if (writer < 0)
+    return false;
+
+  void* loaned_sample = NULL;
+  if (dds_loan_sample(writer, &loaned_sample) != DDS_RETCODE_OK)
+    return false;
+  std::memset(loaned_sample, 0, sizeof(FreeFleetData_BoundedRobotState));
+  return dds_write(writer, loaned_sample) == DDS_RETCODE_OK;
+#else
+  (void)_participant;
+  return true;
+#endif
+}
+
+/// Sends every ping back as a pong, until the ping with a negative sequence
+/// number arrives.
+int run_echo(bool _shared_memory)
+{
+  dds_entity_t domain = 0;
+  dds_entity_t participant =
+      common::dds_participant_create(42, _shared_memory, domain);
+  if (participant < 0)
+    return EXIT_FAILURE;
+
+  StatePub pong_pub(
+      participant, &FreeFleetData_RobotState_desc, pong_topic,
+      QoSProfile::state_stream());
+  StateSub ping_sub(
+      participant, &FreeFleetData_RobotState_desc, ping_topic,
+      QoSProfile::state_stream());
+  if (!pong_pub.is_ready() || !ping_sub.is_ready())
+    return EXIT_FAILURE;
+
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  bool done = false;
+  ping_sub.set_callback(
+      [&](const FreeFleetData_RobotState& _ping)
+      {
+        if (_ping.location.sec < 0)
+        {
+          std::unique_lock<std::mutex> done_lock(done_mutex);
+          done = true;
+          done_cv.notify_all();
+          return;
+        }
+        pong_pub.write(const_cast<FreeFleetData_RobotState*>(&_ping));
+      });
+
+  std::unique_lock<std::mutex> done_lock(done_mutex);
+  done_cv.wait_for(
+      done_lock, std::chrono::seconds(120), [&]() { return done; });
+  done_lock.unlock();
+
+  dds_delete(participant);
+  if (domain > 0)
+    dds_delete(domain);
+  return EXIT_SUCCESS;
+}
+
+/// Sends pings to an echo process and waits for each pong before sending
+/// the next, printing the round trip latency and CPU used per message.
+int run_ping(bool _shared_memory, long _num_messages, uint32_t _num_waypoints)
+{
+  const pid_t echo_pid = fork();
+  if (echo_pid == 0)
+    _exit(run_echo(_shared_memory));
+
+  dds_entity_t domain = 0;
+  dds_entity_t participant =
+      common::dds_participant_create(42, _shared_memory, domain);
+  if (participant < 0)
+    return EXIT_FAILURE;
+
+  if (_shared_memory && !loan_bounded_state(participant))
+  {
+    printf("=== FAILED: no fixed size robot state could be loaned.\n");
+    return EXIT_FAILURE;
+  }
+
+  StatePub ping_pub(
+      participant, &FreeFleetData_RobotState_desc, ping_topic,
+      QoSProfile::state_stream());
+  StateSub pong_sub(
+      participant, &FreeFleetData_RobotState_desc, pong_topic,
+      QoSProfile::state_stream());
+  if (!ping_pub.is_ready() || !pong_sub.is_ready())
+    return EXIT_FAILURE;
+
+  std::mutex pong_mutex;
+  std::condition_variable pong_cv;
+  int32_t last_pong = -1;
+  pong_sub.set_callback(
+      [&](const FreeFleetData_RobotState& _pong)
+      {
+        std::unique_lock<std::mutex> pong_lock(pong_mutex);
+        last_pong = std::max(last_pong, _pong.location.sec);
+        pong_cv.notify_all();
+      });
+
+  FreeFleetData_RobotState* msg = make_robot_state(_num_waypoints);
+
+  // Sends a ping and waits for its pong, best effort samples that were lost
+  // are counted rather than sent again.
+  auto ping = [&](int32_t _sequence, std::chrono::milliseconds _timeout)
+  {
+    msg->location.sec = _sequence;
+    ping_pub.write(msg);
+    std::unique_lock<std::mutex> pong_lock(pong_mutex);
+    return pong_cv.wait_for(pong_lock, _timeout,
+        [&]() { return last_pong >= _sequence; });
+  };
+
+  bool matched = false;
+  for (int32_t i = 0; i < 500 && !matched; ++i)
+    matched = ping(i, std::chrono::milliseconds(20));
+  if (!matched)
+  {
+    printf("=== Echo was never matched.\n");
+    return EXIT_FAILURE;
+  }
+  const int32_t first_sequence = last_pong + 1;
+
+  std::vector<double> latencies_us;
+  latencies_us.reserve(static_cast<std::size_t>(_num_messages));
+  long lost = 0;
+  const double start_cpu_s = get_cpu_seconds(RUSAGE_SELF);
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < _num_messages; ++i)
+  {
+    const auto ping_start = std::chrono::steady_clock::now();
+    if (!ping(
+        first_sequence + static_cast<int32_t>(i),
+        std::chrono::milliseconds(100)))
+    {
+      ++lost;
+      continue;
+    }
+    latencies_us.push_back(std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - ping_start).count());
+  }
+  const double elapsed_s = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  const double ping_cpu_s = get_cpu_seconds(RUSAGE_SELF) - start_cpu_s;
+
+  // The echo only stops after the last ping, so the CPU it used while
+  // matching is included, which is small compared to the run.
+  msg->location.sec = -1;
+  for (int i = 0; i < 10; ++i)
+    ping_pub.write(msg);
+  int echo_status = 0;
+  waitpid(echo_pid, &echo_status, 0);
+  const double echo_cpu_s = get_cpu_seconds(RUSAGE_CHILDREN);
+
+  FreeFleetData_RobotState_free(msg, DDS_FREE_ALL);
+  dds_delete(participant);
+  if (domain > 0)
+    dds_delete(domain);
+
+  if (latencies_us.empty())
+  {
+    printf("=== FAILED: no pong arrived.\n");
+    return EXIT_FAILURE;
+  }
+  std::sort(latencies_us.begin(), latencies_us.end());
+  const std::size_t size = latencies_us.size();
+  const double messages = 2.0 * static_cast<double>(size);
+  printf("=== %s, %lu round trips of %u waypoints in %.2fs, %ld lost\n",
+      _shared_memory ? "shared memory" : "UDP loopback",
+      static_cast<unsigned long>(size), _num_waypoints, elapsed_s, lost);
+  printf("  round trip   p50 %8.1f us   p99 %8.1f us   max %8.1f us\n",
+      latencies_us[size / 2],
+      latencies_us[std::min(size - 1, size * 99 / 100)],
+      latencies_us.back());
+  printf("  CPU per message   ping %6.1f us   echo %6.1f us\n",
+      ping_cpu_s * 1e6 / messages, echo_cpu_s * 1e6 / messages);
+  return WIFEXITED(echo_status) ? WEXITSTATUS(echo_status) : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv)
+{
+  // Bounces robot states between this process and an echo process on the
+  // same host, once over UDP loopback and once over shared memory, and
+  // compares the round trip latency and the CPU used per message. The
+  // transport is fixed for the lifetime of a process, so every run forks
+  // processes of its own. Shared memory needs a running iox-roudi, and its
+  // run also checks that fixed size robot states are loaned from writers.
+  long num_messages = 10000;
+  uint32_t num_waypoints = 50;
+  std::string transports = "udp,shm";
+  if (argc > 1)
+    num_messages = std::stol(argv[1]);
+  if (argc > 2)
+    num_waypoints = static_cast<uint32_t>(std::stoul(argv[2]));
+  if (argc > 3)
+    transports = argv[3];
+
+  bool passed = true;
+  for (const bool shared_memory : {false, true})
+  {
+    if (transports.find(shared_memory ? "shm" : "udp") == std::string::npos)
+      continue;
+
+    fflush(stdout);
+    const pid_t run_pid = fork();
+    if (run_pid == 0)
+      _exit(run_ping(shared_memory, num_messages, num_waypoints));
+
+    int run_status = 0;
+    waitpid(run_pid, &run_status, 0);
+    if (!WIFEXITED(run_status) || WEXITSTATUS(run_status) != EXIT_SUCCESS)
+      passed = false;
+  }
+
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <free_fleet/FleetTable.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+#include "test_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::tests;
+
+/// Registry of robot states the way the ROS 2 server kept them before the
+/// fleet table, for comparison.
+struct MapRegistry
+{
+  std::mutex mutex;
+  std::unordered_map<std::string, messages::RobotState> robot_states;
+
+  void update(const messages::RobotState& _robot_state)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    robot_states[_robot_state.name] = _robot_state;
+  }
+
+  void publish(std::vector<messages::RobotState>& _fleet_state)
+  {
+    _fleet_state.clear();
+    std::unique_lock<std::mutex> lock(mutex);
+    for (const auto& it : robot_states)
+    {
+      // Every entry used to be copied twice before being added.
+      const auto entry = it;
+      const auto robot_state = entry.second;
+      _fleet_state.push_back(robot_state);
+    }
+  }
+};
+
+/// Publishes from the fleet table the way the ROS 2 server does, writing the
+/// hot fields from the snapshot into reused messages.
+void publish_from_table(
+    const FleetTable& _table,
+    FleetTable::Snapshot& _snapshot,
+    std::vector<messages::RobotState>& _fleet_state)
+{
+  _table.read_all(_snapshot);
+  _fleet_state.resize(_snapshot.size());
+  for (std::size_t i = 0; i < _snapshot.size(); ++i)
+  {
+    messages::RobotState& robot_state = _fleet_state[i];
+    const FleetTable::Details& details = *_snapshot.details[i];
+    robot_state.name = details.name;
+    robot_state.model = details.model;
+    robot_state.task_id = details.task_id;
+    robot_state.mode.mode = _snapshot.mode[i];
+    robot_state.battery_percent = _snapshot.battery_percent[i];
+    robot_state.location.sec = _snapshot.sec[i];
+    robot_state.location.nanosec = _snapshot.nanosec[i];
+    robot_state.location.x = _snapshot.x[i];
+    robot_state.location.y = _snapshot.y[i];
+    robot_state.location.yaw = _snapshot.yaw[i];
+    robot_state.location.level_name = details.level_name;
+    robot_state.path = details.path;
+  }
+}
+
+std::vector<messages::RobotState> make_robot_states(std::size_t _num_robots)
+{
+  std::vector<messages::RobotState> robot_states(_num_robots);
+  for (std::size_t i = 0; i < _num_robots; ++i)
+  {
+    messages::RobotState& robot_state = robot_states[i];
+    robot_state.name = "table_robot_" + std::to_string(i);
+    robot_state.model = "table_model";
+    robot_state.task_id = "table_task_" + std::to_string(i);
+    robot_state.mode.mode = messages::RobotMode::MODE_MOVING;
+    robot_state.battery_percent = 100.0;
+    robot_state.location.level_name = "L1";
+    robot_state.path.resize(10);
+    for (std::size_t j = 0; j < robot_state.path.size(); ++j)
+    {
+      robot_state.path[j].sec = static_cast<int32_t>(j);
+      robot_state.path[j].x = static_cast<float>(j);
+      robot_state.path[j].y = static_cast<float>(i);
+      robot_state.path[j].level_name = "L1";
+    }
+  }
+  return robot_states;
+}
+
+/// Updates every robot from one thread while another publishes as fast as
+/// it can for the given duration.
+///
+/// \return
+///   Number of robot updates per second.
+template <typename Update, typename Publish>
+double measure_contended_updates(
+    std::vector<messages::RobotState>& _robot_states,
+    double _seconds,
+    Update _update,
+    Publish _publish)
+{
+  std::atomic<bool> done(false);
+  std::thread publisher([&]()
+  {
+    while (!done)
+      _publish();
+  });
+
+  long num_updates = 0;
+  const auto start = std::chrono::steady_clock::now();
+  const auto end = start + std::chrono::duration<double>(_seconds);
+  while (std::chrono::steady_clock::now() < end)
+  {
+    for (auto& robot_state : _robot_states)
+    {
+      robot_state.location.x += 0.01f;
+      _update(robot_state);
+    }
+    num_updates += static_cast<long>(_robot_states.size());
+  }
+  const double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  done = true;
+  publisher.join();
+  return static_cast<double>(num_updates) / elapsed;
+}
+
+bool run(std::size_t _num_robots, long _iterations, double _seconds)
+{
+  std::vector<messages::RobotState> robot_states =
+      make_robot_states(_num_robots);
+
+  MapRegistry registry;
+  FleetTable table(_num_robots);
+  std::size_t id = 0;
+  for (const auto& robot_state : robot_states)
+  {
+    registry.update(robot_state);
+    if (!table.update(robot_state, id))
+      return false;
+  }
+
+  // Moving robots only change their pose between updates.
+  std::size_t next = 0;
+  const double map_update_ns = measure_ns(_iterations, [&]()
+  {
+    messages::RobotState& robot_state = robot_states[next++ % _num_robots];
+    robot_state.location.x += 0.01f;
+    registry.update(robot_state);
+  });
+  const double table_update_ns = measure_ns(_iterations, [&]()
+  {
+    messages::RobotState& robot_state = robot_states[next++ % _num_robots];
+    robot_state.location.x += 0.01f;
+    table.update(robot_state, id);
+  });
+
+  std::vector<messages::RobotState> map_fleet_state;
+  std::vector<messages::RobotState> table_fleet_state;
+  FleetTable::Snapshot snapshot;
+  const long publish_iterations =
+      std::max(1L, _iterations / static_cast<long>(_num_robots));
+  const double map_publish_ns = measure_ns(publish_iterations,
+      [&]() { registry.publish(map_fleet_state); });
+  const double table_publish_ns = measure_ns(publish_iterations,
+      [&]() { publish_from_table(table, snapshot, table_fleet_state); });
+
+  if (table_fleet_state.size() != _num_robots ||
+      table_fleet_state.back().location.x !=
+          robot_states.back().location.x)
+  {
+    printf("=== FAILED: snapshot does not match the latest robot states.\n");
+    return false;
+  }
+
+  std::vector<messages::RobotState> map_contended_fleet_state;
+  std::vector<messages::RobotState> table_contended_fleet_state;
+  FleetTable::Snapshot contended_snapshot;
+  const double map_updates_per_s = measure_contended_updates(
+      robot_states, _seconds,
+      [&](const messages::RobotState& _robot_state)
+      {
+        registry.update(_robot_state);
+      },
+      [&]() { registry.publish(map_contended_fleet_state); });
+  const double table_updates_per_s = measure_contended_updates(
+      robot_states, _seconds,
+      [&](const messages::RobotState& _robot_state)
+      {
+        table.update(_robot_state, id);
+      },
+      [&]()
+      {
+        publish_from_table(
+            table, contended_snapshot, table_contended_fleet_state);
+      });
+
+  printf("=== %lu robots\n", static_cast<unsigned long>(_num_robots));
+  printf("  update           map %9.1f ns   table %9.1f ns\n",
+      map_update_ns, table_update_ns);
+  printf("  publish          map %9.1f us   table %9.1f us\n",
+      map_publish_ns / 1e3, table_publish_ns / 1e3);
+  printf("  contended update map %9.0f /s   table %9.0f /s\n",
+      map_updates_per_s, table_updates_per_s);
+  return true;
+}
+
+/// Lets a few robots of a full table go silent, and checks that they are
+/// marked as stale, then evicted, and that their ids are given to new robots.
+bool run_expiry(std::size_t _num_robots, std::size_t _num_silent)
+{
+  std::vector<messages::RobotState> robot_states =
+      make_robot_states(_num_robots);
+
+  FleetTable table(_num_robots, 1.0, 10.0);
+  const FleetTable::TimePoint start = std::chrono::steady_clock::now();
+  std::size_t id = 0;
+  for (const auto& robot_state : robot_states)
+  {
+    if (!table.update(robot_state, start, id))
+      return false;
+  }
+
+  // Every robot but the silent ones keeps sending updates.
+  std::vector<std::string> stale_robots;
+  std::vector<std::string> evicted_robots;
+  double max_expire_ns = 0.0;
+  for (int second = 1; second <= 12; ++second)
+  {
+    const FleetTable::TimePoint now = start + std::chrono::seconds(second);
+    for (std::size_t i = _num_silent; i < _num_robots; ++i)
+      table.update(robot_states[i], now, id);
+
+    const auto expire_start = std::chrono::steady_clock::now();
+    table.expire(now, stale_robots, evicted_robots);
+    max_expire_ns = std::max(max_expire_ns,
+        std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - expire_start).count());
+
+    if (second == 2 && (stale_robots.size() != _num_silent ||
+        !table.find(robot_states[0].name, id) || !table.is_stale(id)))
+    {
+      printf("=== FAILED: silent robots were not marked as stale.\n");
+      return false;
+    }
+  }
+
+  if (stale_robots.size() != _num_silent ||
+      evicted_robots.size() != _num_silent ||
+      table.size() != _num_robots - _num_silent ||
+      table.find(robot_states[0].name, id))
+  {
+    printf("=== FAILED: silent robots were not evicted.\n");
+    return false;
+  }
+
+  // The table was full, so new robots can only be added in evicted slots,
+  // and are still reported as new even though their ids are not.
+  bool is_new = false;
+  for (std::size_t i = 0; i < _num_silent; ++i)
+  {
+    messages::RobotState robot_state = robot_states[i];
+    robot_state.name = "new_" + robot_state.name;
+    if (!table.update(robot_state, id, &is_new) || id >= _num_robots)
+    {
+      printf("=== FAILED: ids of evicted robots were not reused.\n");
+      return false;
+    }
+    if (!is_new || !table.update(robot_state, id, &is_new) || is_new)
+    {
+      printf("=== FAILED: new robots in evicted slots were not reported.\n");
+      return false;
+    }
+  }
+
+  printf("=== %lu robots, %lu silent\n",
+      static_cast<unsigned long>(_num_robots),
+      static_cast<unsigned long>(_num_silent));
+  printf("  slowest expire %9.1f ns\n", max_expire_ns);
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  // Compares the fleet table against a mutex guarded map of robot states,
+  // for updates alone, publishing alone, and updates while a publisher is
+  // continuously reading the whole fleet, then checks that robots which go
+  // silent expire.
+  long iterations = 100000;
+  double seconds = 1.0;
+  if (argc > 1)
+    iterations = std::stol(argv[1]);
+  if (argc > 2)
+    seconds = std::stod(argv[2]);
+
+  for (std::size_t num_robots : {10, 100, 1000})
+  {
+    if (!run(num_robots, iterations, seconds))
+      return EXIT_FAILURE;
+  }
+  if (!run_expiry(1000, 10))
+    return EXIT_FAILURE;
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <free_fleet/FrameTransform.hpp>
+#include <free_fleet/messages/Location.hpp>
+
+#include "test_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::tests;
+
+const double scale = 1.5;
+const double rotation = 0.7;
+const double translation_x = 12.0;
+const double translation_y = -4.0;
+
+/// Transforms a single location from the frame of the fleet to the frame of
+/// RMF the way the ROS 2 server did before, building the rotation for every
+/// point.
+void transform_per_point(
+    const messages::Location& _fleet_frame_location,
+    messages::Location& _rmf_frame_location)
+{
+  const double translated_x = _fleet_frame_location.x - translation_x;
+  const double translated_y = _fleet_frame_location.y - translation_y;
+
+  const double cos_rotation = std::cos(-rotation);
+  const double sin_rotation = std::sin(-rotation);
+  const double rotated_x =
+      cos_rotation * translated_x - sin_rotation * translated_y;
+  const double rotated_y =
+      sin_rotation * translated_x + cos_rotation * translated_y;
+
+  _rmf_frame_location.x = static_cast<float>(1.0 / scale * rotated_x);
+  _rmf_frame_location.y = static_cast<float>(1.0 / scale * rotated_y);
+  _rmf_frame_location.yaw =
+      static_cast<float>(_fleet_frame_location.yaw - rotation);
+  _rmf_frame_location.sec = _fleet_frame_location.sec;
+  _rmf_frame_location.nanosec = _fleet_frame_location.nanosec;
+  _rmf_frame_location.level_name = _fleet_frame_location.level_name;
+}
+
+int main(int argc, char** argv)
+{
+  // Transforms the locations and paths of a whole fleet from the frame of
+  // the fleet to the frame of RMF, point by point as before, and through the
+  // precomputed transform on contiguous arrays, then checks that both agree.
+  std::size_t num_robots = 1000;
+  std::size_t num_waypoints = 50;
+  long iterations = 200;
+  if (argc > 1)
+    num_robots = static_cast<std::size_t>(std::stol(argv[1]));
+  if (argc > 2)
+    num_waypoints = static_cast<std::size_t>(std::stol(argv[2]));
+  if (argc > 3)
+    iterations = std::stol(argv[3]);
+
+  const std::size_t num_points = num_robots * (num_waypoints + 1);
+  std::vector<messages::Location> fleet_frame_points(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    fleet_frame_points[i].sec = static_cast<int32_t>(i);
+    fleet_frame_points[i].nanosec = 0;
+    fleet_frame_points[i].x = static_cast<float>(i % 97) * 0.5f;
+    fleet_frame_points[i].y = static_cast<float>(i % 89) * 0.25f;
+    fleet_frame_points[i].yaw = static_cast<float>(i % 7) * 0.1f;
+    fleet_frame_points[i].level_name = "L1";
+  }
+
+  // Every robot got a new path of transformed locations on every publish.
+  std::vector<std::vector<messages::Location>> per_point_output;
+  const double per_point_us = measure_us(iterations, [&]()
+  {
+    per_point_output.clear();
+    for (std::size_t r = 0; r < num_robots; ++r)
+    {
+      std::vector<messages::Location> rmf_frame_path;
+      for (std::size_t w = 0; w <= num_waypoints; ++w)
+      {
+        messages::Location rmf_frame_location;
+        transform_per_point(
+            fleet_frame_points[r * (num_waypoints + 1) + w],
+            rmf_frame_location);
+        rmf_frame_path.push_back(rmf_frame_location);
+      }
+      per_point_output.push_back(rmf_frame_path);
+    }
+  });
+
+  const FrameTransform frame_transform(
+      scale, rotation, translation_x, translation_y);
+  std::vector<float> x(num_points);
+  std::vector<float> y(num_points);
+  std::vector<float> yaw(num_points);
+
+  const double arrays_only_us = measure_us(iterations, [&]()
+  {
+    frame_transform.fleet_to_rmf(num_points, x.data(), y.data(), yaw.data());
+  });
+
+  // Gathering into the arrays and writing back into reused locations is
+  // what the server does when publishing.
+  std::vector<messages::Location> vectorized_output(num_points);
+  const double vectorized_us = measure_us(iterations, [&]()
+  {
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      x[i] = fleet_frame_points[i].x;
+      y[i] = fleet_frame_points[i].y;
+      yaw[i] = fleet_frame_points[i].yaw;
+    }
+    frame_transform.fleet_to_rmf(num_points, x.data(), y.data(), yaw.data());
+    for (std::size_t i = 0; i < num_points; ++i)
+    {
+      messages::Location& rmf_frame_location = vectorized_output[i];
+      rmf_frame_location.sec = fleet_frame_points[i].sec;
+      rmf_frame_location.nanosec = fleet_frame_points[i].nanosec;
+      rmf_frame_location.x = x[i];
+      rmf_frame_location.y = y[i];
+      rmf_frame_location.yaw = yaw[i];
+      rmf_frame_location.level_name = fleet_frame_points[i].level_name;
+    }
+  });
+
+  double max_error = 0.0;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const messages::Location& expected =
+        per_point_output[i / (num_waypoints + 1)][i % (num_waypoints + 1)];
+    const messages::Location& actual = vectorized_output[i];
+    max_error = std::max(max_error, std::abs(
+        static_cast<double>(expected.x) - static_cast<double>(actual.x)));
+    max_error = std::max(max_error, std::abs(
+        static_cast<double>(expected.y) - static_cast<double>(actual.y)));
+    max_error = std::max(max_error, std::abs(
+        static_cast<double>(expected.yaw) - static_cast<double>(actual.yaw)));
+  }
+
+  // Going back to the frame of the fleet must give the original points.
+  frame_transform.rmf_to_fleet(num_points, x.data(), y.data(), yaw.data());
+  double max_round_trip_error = 0.0;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    max_round_trip_error = std::max(max_round_trip_error, std::abs(
+        static_cast<double>(x[i]) -
+        static_cast<double>(fleet_frame_points[i].x)));
+    max_round_trip_error = std::max(max_round_trip_error, std::abs(
+        static_cast<double>(y[i]) -
+        static_cast<double>(fleet_frame_points[i].y)));
+  }
+
+  printf("=== Transforming %lu robots with %lu waypoints each\n",
+      static_cast<unsigned long>(num_robots),
+      static_cast<unsigned long>(num_waypoints));
+  printf("  per point                   %10.1f us\n", per_point_us);
+  printf("  vectorized, with messages   %10.1f us\n", vectorized_us);
+  printf("  vectorized, arrays only     %10.1f us\n", arrays_only_us);
+  printf("  max error %.2e, max round trip error %.2e\n",
+      max_error, max_round_trip_error);
+
+  if (max_error > 1e-3 || max_round_trip_error > 1e-3)
+  {
+    printf("=== FAILED: transforms do not agree.\n");
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
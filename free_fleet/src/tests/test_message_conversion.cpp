@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <new>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dds/dds.h>
+
+#include "../messages/FleetMessages.h"
+#include "../messages/message_utils.hpp"
+#include "../dds_utils/common.hpp"
+
+using namespace free_fleet;
+
+namespace {
+
+std::atomic<uint64_t> num_allocations(0);
+
+} // namespace
+
+void* operator new(std::size_t _size)
+{
+  ++num_allocations;
+  void* ptr = std::malloc(_size > 0 ? _size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* _ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+void operator delete(void* _ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/// Converts the way it was done before samples were reused, allocating and
+/// copying every string and sequence, for comparison.
+void convert_by_copy(const messages::RobotState& _input)
+{
+  FreeFleetData_RobotState* output = FreeFleetData_RobotState__alloc();
+  output->name = common::dds_string_alloc_and_copy(_input.name);
+  output->model = common::dds_string_alloc_and_copy(_input.model);
+  output->task_id = common::dds_string_alloc_and_copy(_input.task_id);
+  output->location.level_name =
+      common::dds_string_alloc_and_copy(_input.location.level_name);
+  output->path._maximum = static_cast<uint32_t>(_input.path.size());
+  output->path._length = static_cast<uint32_t>(_input.path.size());
+  output->path._buffer =
+      FreeFleetData_RobotState_path_seq_allocbuf(_input.path.size());
+  output->path._release = true;
+  for (size_t i = 0; i < _input.path.size(); ++i)
+  {
+    output->path._buffer[i].x = _input.path[i].x;
+    output->path._buffer[i].y = _input.path[i].y;
+    output->path._buffer[i].level_name =
+        common::dds_string_alloc_and_copy(_input.path[i].level_name);
+  }
+  FreeFleetData_RobotState_free(output, DDS_FREE_ALL);
+}
+
+/// Whether the fields that are sent over DDS are the same.
+bool is_same_robot_state(
+    const messages::RobotState& _a, const messages::RobotState& _b)
+{
+  if (_a.name != _b.name || _a.model != _b.model ||
+      _a.task_id != _b.task_id || _a.mode.mode != _b.mode.mode ||
+      _a.battery_percent != _b.battery_percent ||
+      _a.location.level_name != _b.location.level_name ||
+      _a.path.size() != _b.path.size())
+    return false;
+
+  for (size_t i = 0; i < _a.path.size(); ++i)
+  {
+    if (_a.path[i].sec != _b.path[i].sec ||
+        _a.path[i].x != _b.path[i].x ||
+        _a.path[i].y != _b.path[i].y ||
+        _a.path[i].level_name != _b.path[i].level_name)
+      return false;
+  }
+  return true;
+}
+
+/// Runs the function repeatedly after warming up, and prints the time and
+/// number of allocations per run.
+///
+/// \return
+///   Number of allocations after warming up.
+template <typename Function>
+uint64_t measure(const char* _name, long _iterations, Function _function)
+{
+  // Warm up once, so that buffers have grown to their final size.
+  _function();
+
+  const uint64_t allocations_before = num_allocations;
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < _iterations; ++i)
+    _function();
+  const auto end = std::chrono::steady_clock::now();
+  const uint64_t allocations = num_allocations - allocations_before;
+
+  printf("  %-32s %8.1f ns/op  %6.2f allocations/op\n",
+      _name,
+      std::chrono::duration<double, std::nano>(end - start).count() /
+          static_cast<double>(_iterations),
+      static_cast<double>(allocations) / static_cast<double>(_iterations));
+  return allocations;
+}
+
+int main(int argc, char** argv)
+{
+  // Measures the conversions used on every robot state sent and received,
+  // with a 50 waypoint path. Converting into reused samples and messages must
+  // not allocate once warm. Allocations are counted through operator new,
+  // allocations made by DDS itself, including those of the copying
+  // conversion, are not counted.
+  long iterations = 1000000;
+  if (argc > 1)
+    iterations = std::stol(argv[1]);
+
+  messages::RobotState robot_state;
+  robot_state.name = "conversion_robot";
+  robot_state.model = "conversion_model";
+  robot_state.task_id = "conversion_task_with_a_long_id";
+  robot_state.mode.mode = messages::RobotMode::MODE_MOVING;
+  robot_state.battery_percent = 100.0;
+  robot_state.location.level_name = "conversion_level";
+  robot_state.path.resize(50);
+  for (size_t i = 0; i < robot_state.path.size(); ++i)
+  {
+    robot_state.path[i].sec = static_cast<int32_t>(i);
+    robot_state.path[i].x = static_cast<float>(i);
+    robot_state.path[i].y = static_cast<float>(i);
+    robot_state.path[i].level_name = "conversion_level";
+  }
+
+  FreeFleetData_RobotState sample;
+  std::vector<FreeFleetData_Location> path_buffer;
+  messages::RobotState received_robot_state;
+
+  printf("=== Converting a robot state with %lu waypoints %ld times\n",
+      static_cast<unsigned long>(robot_state.path.size()), iterations);
+  measure("to DDS, copying", iterations,
+      [&]() { convert_by_copy(robot_state); });
+
+  const uint64_t to_dds_allocations = measure(
+      "to DDS, reused sample", iterations,
+      [&]() { messages::convert(robot_state, sample, path_buffer); });
+  const uint64_t from_dds_allocations = measure(
+      "from DDS, reused message", iterations,
+      [&]() { messages::convert(sample, received_robot_state); });
+
+  FreeFleetData_BoundedRobotState bounded_sample;
+  const uint64_t to_bounded_allocations = measure(
+      "to DDS, fixed size sample", iterations,
+      [&]() { messages::convert(robot_state, bounded_sample); });
+  const uint64_t from_bounded_allocations = measure(
+      "from DDS, fixed size sample", iterations,
+      [&]() { messages::convert(bounded_sample, received_robot_state); });
+
+  if (to_dds_allocations > 0 || from_dds_allocations > 0 ||
+      to_bounded_allocations > 0 || from_bounded_allocations > 0)
+  {
+    printf("=== FAILED: conversions into reused buffers allocated.\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!is_same_robot_state(robot_state, received_robot_state))
+  {
+    printf("=== FAILED: fixed size sample did not convert back.\n");
+    return EXIT_FAILURE;
+  }
+
+  // Anything beyond the fixed sizes is cut off.
+  robot_state.name = std::string(100, 'n');
+  robot_state.path.resize(100);
+  messages::convert(robot_state, bounded_sample);
+  messages::convert(bounded_sample, received_robot_state);
+  if (received_robot_state.name.size() !=
+          FreeFleetData_BoundedRobotState_Constants_STRING_SIZE - 1 ||
+      received_robot_state.path.size() !=
+          FreeFleetData_BoundedRobotState_Constants_PATH_SIZE)
+  {
+    printf("=== FAILED: fixed size sample was not truncated.\n");
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <free_fleet/messages/NameId.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+#include "../messages/NameTable.hpp"
+#include "test_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::tests;
+
+/// Estimated size of a robot state in CDR, with every level name that has an
+/// id sent as an empty string.
+std::size_t get_cdr_size(
+    const messages::RobotState& _robot_state, bool _with_level_ids)
+{
+  auto get_location_size = [&](const messages::Location& _location)
+  {
+    return 5 * 4 + 4 +
+        get_cdr_size(_with_level_ids ? std::string() : _location.level_name);
+  };
+
+  std::size_t size = get_cdr_size(_robot_state.name) +
+      get_cdr_size(_robot_state.model) + get_cdr_size(_robot_state.task_id) +
+      4 + 4 + get_location_size(_robot_state.location) + 4;
+  for (const auto& location : _robot_state.path)
+    size += get_location_size(location);
+  return size;
+}
+
+int main(int argc, char** argv)
+{
+  // Gives out ids the way the server does and learns them the way a client
+  // does, then prints the bytes estimated to be saved on a robot state by
+  // sending its level names as ids.
+  std::size_t num_waypoints = 50;
+  std::string level_name = "building_1_level_1";
+  if (argc > 1)
+    num_waypoints = static_cast<std::size_t>(std::stol(argv[1]));
+  if (argc > 2)
+    level_name = argv[2];
+
+  const uint16_t generation = messages::NameTable::make_generation();
+  messages::NameTable server_table(generation);
+  messages::NameTable client_table;
+
+  bool added;
+  const uint32_t empty_id = server_table.intern("", added);
+  const uint32_t level_id = server_table.intern(level_name, added);
+  bool passed = check(added, "new name was not added");
+  passed &= check(
+      server_table.intern(level_name, added) == level_id && !added,
+      "name was given a second id");
+  passed &= check(
+      messages::get_name_id_generation(level_id) == generation &&
+          empty_id != 0,
+      "id is not of the generation of the table");
+
+  passed &= check(
+      client_table.intern(level_name, added) == 0 && !added,
+      "a learning table gave out an id");
+  passed &= check(
+      client_table.find_id(level_name) == 0, "id is known before learning");
+  client_table.learn(level_name, level_id);
+  client_table.learn("", empty_id);
+  passed &= check(
+      client_table.find_id(level_name) == level_id, "id was not learned");
+
+  std::string name;
+  passed &= check(
+      server_table.find_name(level_id, name) && name == level_name,
+      "name of id not found");
+  passed &= check(
+      !client_table.find_name(level_id + 1, name),
+      "name of an unknown id found");
+
+  // A restarted server gives out ids of another generation.
+  const uint32_t restarted_id =
+      (static_cast<uint32_t>(generation == 0xFFFF ? 1 : generation + 1)
+          << 16) | 1;
+  client_table.learn("other_level", restarted_id);
+  passed &= check(
+      client_table.find_id(level_name) == 0,
+      "ids of the previous generation were kept");
+  passed &= check(
+      messages::is_same_name(level_id, level_name, 0, level_name) &&
+          !messages::is_same_name(
+              level_id, level_name, restarted_id, "other_level") &&
+          messages::is_same_name(
+              level_id, level_name, restarted_id, level_name),
+      "names were not compared by id within a generation only");
+
+  messages::RobotState robot_state;
+  robot_state.name = "name_table_robot";
+  robot_state.model = "name_table_model";
+  robot_state.task_id = "name_table_task";
+  robot_state.location.level_name = level_name;
+  robot_state.path.resize(num_waypoints);
+  for (auto& location : robot_state.path)
+    location.level_name = level_name;
+
+  const std::size_t with_names = get_cdr_size(robot_state, false);
+  const std::size_t with_ids = get_cdr_size(robot_state, true);
+  printf("=== Robot state with %lu waypoints on level \"%s\"\n",
+      static_cast<unsigned long>(num_waypoints), level_name.c_str());
+  printf("  level names as strings   %6lu bytes\n",
+      static_cast<unsigned long>(with_names));
+  printf("  level names as ids       %6lu bytes, %.1f%% saved\n",
+      static_cast<unsigned long>(with_ids),
+      100.0 * static_cast<double>(with_names - with_ids) /
+          static_cast<double>(with_names));
+
+  if (!passed)
+    return EXIT_FAILURE;
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <free_fleet/messages/Location.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+#include "../messages/FleetMessages.h"
+#include "../messages/message_utils.hpp"
+#include "test_utils.hpp"
+
+using namespace free_fleet;
+using namespace free_fleet::tests;
+
+/// Estimated size in CDR of the path of a robot state sample, either of its
+/// locations or of its compact path.
+std::size_t get_cdr_path_size(const FreeFleetData_RobotState& _sample)
+{
+  std::size_t size = 4 + 4 + (_sample.compact_path._length + 3) / 4 * 4;
+  for (uint32_t i = 0; i < _sample.path._length; ++i)
+    size += 5 * 4 + 4 + get_cdr_size(_sample.path._buffer[i].level_name);
+  return size;
+}
+
+/// Path the way RMF plans them, a waypoint about every half meter and every
+/// second, turning now and then, with the level changing at a lift halfway.
+messages::RobotState make_robot_state(
+    std::size_t _num_waypoints, bool _change_level)
+{
+  messages::RobotState robot_state;
+  robot_state.name = "compression_robot";
+  robot_state.model = "compression_model";
+  robot_state.task_id = "compression_task";
+  robot_state.location.level_name = "L1";
+  robot_state.path.resize(_num_waypoints);
+  double x = 12.345;
+  double y = -6.789;
+  double yaw = 0.3;
+  for (std::size_t i = 0; i < _num_waypoints; ++i)
+  {
+    if (i % 10 == 0)
+      yaw += 0.7;
+    x += 0.5 * std::cos(yaw);
+    y += 0.5 * std::sin(yaw);
+
+    messages::Location& location = robot_state.path[i];
+    location.sec = 1600000000 + static_cast<int32_t>(i);
+    location.nanosec = static_cast<uint32_t>((i * 123456789) % 1000000000);
+    location.x = static_cast<float>(x);
+    location.y = static_cast<float>(y);
+    location.yaw = static_cast<float>(std::remainder(yaw, 2.0 * M_PI));
+    const bool upstairs = _change_level && i >= _num_waypoints / 2;
+    location.level_name = upstairs ? "L2" : "L1";
+    location.level_id = upstairs ? 0x10002 : 0x10001;
+  }
+  return robot_state;
+}
+
+/// Compresses a path and decodes it again, printing the sizes, the time
+/// taken and the largest errors, which have to stay within the rounding.
+bool run(std::size_t _num_waypoints, bool _change_level, long _iterations)
+{
+  const messages::RobotState robot_state =
+      make_robot_state(_num_waypoints, _change_level);
+  FreeFleetData_RobotState sample;
+  std::vector<FreeFleetData_Location> path_buffer;
+  std::vector<uint8_t> compact_path_buffer;
+
+  messages::convert(robot_state, sample, path_buffer);
+  const std::size_t plain_size = get_cdr_path_size(sample);
+  messages::compact_path(sample, compact_path_buffer);
+  const std::size_t compact_size = get_cdr_path_size(sample);
+
+  const double encode_ns = measure_ns(_iterations, [&]()
+  {
+    messages::encode_path(
+        path_buffer.data(),
+        static_cast<uint32_t>(robot_state.path.size()),
+        compact_path_buffer);
+  });
+
+  messages::RobotState decoded;
+  const double decode_ns = measure_ns(_iterations, [&]()
+  {
+    messages::convert(sample, decoded);
+  });
+
+  bool passed = check(
+      decoded.path.size() == robot_state.path.size(), "path size");
+  double max_position_error = 0.0;
+  double max_yaw_error = 0.0;
+  double max_time_error = 0.0;
+  for (std::size_t i = 0; passed && i < decoded.path.size(); ++i)
+  {
+    const messages::Location& expected = robot_state.path[i];
+    const messages::Location& actual = decoded.path[i];
+    max_position_error = std::max(max_position_error, std::max(
+        std::abs(static_cast<double>(expected.x - actual.x)),
+        std::abs(static_cast<double>(expected.y - actual.y))));
+    max_yaw_error = std::max(max_yaw_error,
+        std::abs(static_cast<double>(expected.yaw - actual.yaw)));
+    max_time_error = std::max(max_time_error, std::abs(
+        (static_cast<double>(expected.sec) - actual.sec) +
+        (static_cast<double>(expected.nanosec) - actual.nanosec) / 1e9));
+    passed = check(actual.level_name == expected.level_name &&
+        actual.level_id == expected.level_id, "level");
+  }
+
+  printf("=== %lu waypoints%s\n",
+      static_cast<unsigned long>(_num_waypoints),
+      _change_level ? ", changing level" : "");
+  printf("  bytes per path   plain %6lu   compact %6lu   saved %5.1f%%\n",
+      static_cast<unsigned long>(plain_size),
+      static_cast<unsigned long>(compact_size),
+      100.0 * (1.0 - static_cast<double>(compact_size) /
+          static_cast<double>(plain_size)));
+  printf("  encode %8.1f ns   decode %8.1f ns\n", encode_ns, decode_ns);
+  printf("  max error   position %.2e m   yaw %.2e rad   time %.2e s\n",
+      max_position_error, max_yaw_error, max_time_error);
+
+  // Floats of coordinates in the tens of meters are only precise to a few
+  // micrometers themselves, which adds to the rounding.
+  passed = passed &&
+      check(max_position_error <= 0.5e-3 + 1e-5, "position error") &&
+      check(max_yaw_error <= 0.5e-3 + 1e-6, "yaw error") &&
+      check(max_time_error <= 0.5e-3 + 1e-9, "time error");
+  return passed;
+}
+
+/// Paths received from peers may be cut short or made up, which has to be
+/// detected rather than read beyond the end of the data.
+bool run_invalid()
+{
+  const messages::RobotState robot_state = make_robot_state(20, true);
+  FreeFleetData_RobotState sample;
+  std::vector<FreeFleetData_Location> path_buffer;
+  std::vector<uint8_t> compact_path_buffer;
+  messages::convert(robot_state, sample, path_buffer);
+  messages::compact_path(sample, compact_path_buffer);
+
+  std::vector<messages::Location> path;
+  bool passed = check(
+      messages::decode_path(
+          compact_path_buffer.data(),
+          static_cast<uint32_t>(compact_path_buffer.size()),
+          path),
+      "valid path decodes");
+  for (std::size_t size = 0; size < compact_path_buffer.size(); ++size)
+  {
+    passed = passed && check(
+        !messages::decode_path(
+            compact_path_buffer.data(), static_cast<uint32_t>(size), path),
+        "truncated path is rejected");
+  }
+
+  const std::vector<uint8_t> too_long = {0xFF, 0xFF, 0xFF, 0xFF, 0x0F};
+  passed = passed && check(
+      !messages::decode_path(
+          too_long.data(), static_cast<uint32_t>(too_long.size()), path),
+      "made up size is rejected");
+
+  // Values beyond what the encoder sends would overflow once scaled or
+  // summed up, whether they are a time or a coordinate difference.
+  const std::vector<std::vector<uint8_t>> out_of_range = {
+    {0x01, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,
+      0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00},
+    {0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,
+      0x00, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00},
+    {0x01, 0x00, 0x00,
+      0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01,
+      0x00, 0x00, 0x01, 0x01, 0x00, 0x00},
+  };
+  for (const auto& data : out_of_range)
+  {
+    passed = passed && check(
+        !messages::decode_path(
+            data.data(), static_cast<uint32_t>(data.size()), path),
+        "out of range value is rejected");
+  }
+
+  // The largest values the encoder clamps to still decode.
+  std::vector<FreeFleetData_Location> far_path(2);
+  far_path[0].sec = INT32_MIN;
+  far_path[0].x = 1e20f;
+  far_path[0].y = -1e20f;
+  far_path[0].level_name = const_cast<char*>("");
+  far_path[1].sec = INT32_MAX;
+  far_path[1].nanosec = 999999999;
+  far_path[1].x = -1e20f;
+  far_path[1].y = 1e20f;
+  far_path[1].level_name = const_cast<char*>("");
+  std::vector<uint8_t> far_data;
+  messages::encode_path(far_path.data(), 2, far_data);
+  passed = passed && check(
+      messages::decode_path(
+          far_data.data(), static_cast<uint32_t>(far_data.size()), path) &&
+          path.size() == 2 && path[1].sec == INT32_MAX,
+      "clamped path decodes");
+
+  // A robot state with a broken compact path has no path at all.
+  compact_path_buffer.pop_back();
+  sample.compact_path._length =
+      static_cast<uint32_t>(compact_path_buffer.size());
+  messages::RobotState decoded;
+  messages::convert(sample, decoded);
+  passed = passed && check(decoded.path.empty(), "broken path is dropped");
+
+  // Converting again without compacting sends the locations.
+  messages::convert(robot_state, sample, path_buffer);
+  messages::convert(sample, decoded);
+  passed = passed &&
+      check(sample.compact_path._length == 0, "compact path is cleared") &&
+      check(decoded.path.size() == robot_state.path.size(), "plain path");
+  return passed;
+}
+
+int main(int argc, char** argv)
+{
+  // Compares the estimated bytes of the paths of robot states sent as
+  // locations and sent compactly, for paths RMF typically plans, with the
+  // time it takes to encode and decode them.
+  long iterations = 100000;
+  if (argc > 1)
+    iterations = std::stol(argv[1]);
+
+  bool passed = true;
+  passed = run(10, false, iterations) && passed;
+  passed = run(50, false, iterations) && passed;
+  passed = run(200, true, iterations / 4) && passed;
+  passed = run_invalid() && passed;
+
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return EXIT_FAILURE;
+  }
+  printf("=== PASSED\n");
+  return EXIT_SUCCESS;
+}
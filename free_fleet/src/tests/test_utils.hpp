@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef FREE_FLEET__SRC__TESTS__TEST_UTILS_HPP
+#define FREE_FLEET__SRC__TESTS__TEST_UTILS_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace free_fleet {
+namespace tests {
+
+/// Prints the description of a condition that does not hold.
+inline bool check(bool _condition, const char* _description)
+{
+  if (!_condition)
+    printf("=== FAILED: %s\n", _description);
+  return _condition;
+}
+
+/// Average time a function takes over the given number of iterations, in
+/// nanoseconds, after calling it once to warm up.
+template <typename Function>
+double measure_ns(long _iterations, Function _function)
+{
+  _function();
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < _iterations; ++i)
+    _function();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+      static_cast<double>(_iterations);
+}
+
+template <typename Function>
+double measure_us(long _iterations, Function _function)
+{
+  return measure_ns(_iterations, _function) * 1e-3;
+}
+
+/// Estimated size of a string in CDR, with its length, terminator and
+/// padding. Sizes estimated this way leave out the alignment of the members
+/// around the string, and are only printed for comparison.
+inline std::size_t get_cdr_size(const std::string& _str)
+{
+  return 4 + (_str.size() + 1 + 3) / 4 * 4;
+}
+
+} // namespace tests
+} // namespace free_fleet
+
+#endif // FREE_FLEET__SRC__TESTS__TEST_UTILS_HPP
@@ -29,27 +29,12 @@ ClientNode::SharedPtr ClientNode::make(const ClientNodeConfig& _config)
   SharedPtr client_node = SharedPtr(new ClientNode(_config));
   client_node->node.reset(new ros::NodeHandle(_config.robot_name + "_node"));
 
-  /// Starting the free fleet client
-  ClientConfig client_config = _config.get_client_config();
-  Client::SharedPtr client = Client::make(client_config);
-  if (!client)
-    return nullptr;
-
-  /// Setting up the move base action client, wait for server
-  ROS_INFO("waiting for connection with move base action server: %s",
-      _config.move_base_server_name.c_str());
+  /// Setting up the move base action client and the docking server client,
+  /// if required. Their servers are discovered in the background while the
+  /// free fleet client is created, and waited for once the node is running.
   MoveBaseClientSharedPtr move_base_client(
       new MoveBaseClient(_config.move_base_server_name, true));
-  if (!move_base_client->waitForServer(ros::Duration(_config.wait_timeout)))
-  {
-    ROS_ERROR("timed out waiting for action server: %s",
-        _config.move_base_server_name.c_str());
-    return nullptr;
-  }
-  ROS_INFO("connected with move base action server: %s",
-      _config.move_base_server_name.c_str());
 
-  /// Setting up the docking server client, if required, wait for server
   std::unique_ptr<ros::ServiceClient> docking_trigger_client = nullptr;
   if (_config.docking_trigger_server_name != "")
   {
@@ -57,15 +42,14 @@ ClientNode::SharedPtr ClientNode::make(const ClientNodeConfig& _config)
       std::make_unique<ros::ServiceClient>(
         client_node->node->serviceClient<std_srvs::Trigger>(
           _config.docking_trigger_server_name, true));
-    if (!docking_trigger_client->waitForExistence(
-      ros::Duration(_config.wait_timeout)))
-    {
-      ROS_ERROR("timed out waiting for docking trigger server: %s",
-        _config.docking_trigger_server_name.c_str());
-      return nullptr;
-    }
   }
 
+  /// Starting the free fleet client
+  ClientConfig client_config = _config.get_client_config();
+  Client::SharedPtr client = Client::make(client_config);
+  if (!client)
+    return nullptr;
+
   client_node->start(Fields{
       std::move(client),
       std::move(move_base_client),
@@ -82,6 +66,18 @@ ClientNode::ClientNode(const ClientNodeConfig& _config) :
 
 ClientNode::~ClientNode()
 {
+  if (navigation_thread.joinable())
+  {
+    navigation_thread.join();
+    ROS_INFO("Client: navigation_thread joined.");
+  }
+
+  if (pose_thread.joinable())
+  {
+    pose_thread.join();
+    ROS_INFO("Client: pose_thread joined.");
+  }
+
   if (update_thread.joinable())
   {
     update_thread.join();
@@ -100,7 +96,12 @@ void ClientNode::start(Fields _fields)
   fields = std::move(_fields);
 
   update_rate.reset(new ros::Rate(client_node_config.update_frequency));
-  publish_rate.reset(new ros::Rate(client_node_config.publish_frequency));
+  // When publishing adaptively, the state is checked at the highest rate it
+  // may be sent at, and the free fleet client skips the unchanged ones.
+  publish_rate.reset(new ros::Rate(
+      client_node_config.adaptive_publishing ?
+          client_node_config.max_publish_frequency :
+          client_node_config.publish_frequency));
 
   battery_percent_sub = node->subscribe(
       client_node_config.battery_state_topic, 1,
@@ -110,12 +111,76 @@ void ClientNode::start(Fields _fields)
   emergency = false;
   paused = false;
 
+  // Have requests handled as soon as they arrive over DDS, instead of waiting
+  // for the next update to poll for them.
+  requests_event_driven =
+      fields.client->set_mode_request_callback(
+          [this](const std::vector<messages::ModeRequest>& _mode_requests)
+          {
+            handle_mode_requests(_mode_requests);
+          }) &&
+      fields.client->set_path_request_callback(
+          [this](const std::vector<messages::PathRequest>& _path_requests)
+          {
+            handle_path_requests(_path_requests);
+          }) &&
+      fields.client->set_destination_request_callback(
+          [this](const std::vector<messages::DestinationRequest>&
+              _destination_requests)
+          {
+            handle_destination_requests(_destination_requests);
+          });
+  if (!requests_event_driven)
+    ROS_WARN("Client: unable to listen for requests, polling at %.1f Hz "
+        "instead.", client_node_config.update_frequency);
+
+  // The first state is sent right away, for the server to know of the robot
+  // while it is still starting up.
+  publish_robot_state();
+
+  ROS_INFO("Client: starting pose thread.");
+  pose_thread = std::thread(std::bind(&ClientNode::pose_thread_fn, this));
+
   ROS_INFO("Client: starting update thread.");
   update_thread = std::thread(std::bind(&ClientNode::update_thread_fn, this));
 
   ROS_INFO("Client: starting publish thread.");
   publish_thread = 
       std::thread(std::bind(&ClientNode::publish_thread_fn, this));
+
+  ROS_INFO("Client: starting navigation thread.");
+  navigation_thread =
+      std::thread(std::bind(&ClientNode::wait_for_navigation, this));
+}
+
+void ClientNode::wait_for_navigation()
+{
+  ROS_INFO("waiting for connection with move base action server: %s",
+      client_node_config.move_base_server_name.c_str());
+  while (!fields.move_base_client->waitForServer(
+      ros::Duration(client_node_config.wait_timeout)))
+  {
+    ROS_ERROR("timed out waiting for action server: %s",
+        client_node_config.move_base_server_name.c_str());
+    if (!node->ok())
+      return;
+  }
+  ROS_INFO("connected with move base action server: %s",
+      client_node_config.move_base_server_name.c_str());
+
+  if (fields.docking_trigger_client)
+  {
+    while (!fields.docking_trigger_client->waitForExistence(
+        ros::Duration(client_node_config.wait_timeout)))
+    {
+      ROS_ERROR("timed out waiting for docking trigger server: %s",
+          client_node_config.docking_trigger_server_name.c_str());
+      if (!node->ok())
+        return;
+    }
+  }
+
+  navigation_ready = true;
 }
 
 void ClientNode::print_config()
@@ -126,8 +191,12 @@ void ClientNode::print_config()
 void ClientNode::battery_state_callback_fn(
     const sensor_msgs::BatteryState& _msg)
 {
-  WriteLock battery_state_lock(battery_state_mutex);
-  current_battery_state = _msg;
+  /// RMF expects battery to have a percentage in the range for 0-100.
+  /// sensor_msgs/BatteryInfo on the other hand returns a value in 
+  /// the range of 0-1
+  battery_percent = 100*_msg.percentage;
+  charging =
+      _msg.power_supply_status == _msg.POWER_SUPPLY_STATUS_CHARGING;
 }
 
 bool ClientNode::get_robot_transform()
@@ -138,9 +207,7 @@ bool ClientNode::get_robot_transform()
             client_node_config.map_frame,
             client_node_config.robot_frame,
             ros::Time(0));
-    WriteLock robot_transform_lock(robot_transform_mutex);
-    previous_robot_transform = current_robot_transform;
-    current_robot_transform = tmp_transform_stamped;
+    latest_robot_pose.store(to_robot_pose(tmp_transform_stamped));
   }
   catch (tf2::TransformException &ex) {
     ROS_WARN("%s", ex.what());
@@ -159,21 +226,21 @@ messages::RobotMode ClientNode::get_robot_mode()
   if (emergency)
     return messages::RobotMode{messages::RobotMode::MODE_EMERGENCY};
 
-  /// Checks if robot is charging
-  {
-    ReadLock battery_state_lock(battery_state_mutex);
+  /// Checks if the navigation stack is still starting up
+  if (!navigation_ready)
+    return messages::RobotMode{messages::RobotMode::MODE_WAITING};
 
-    if (current_battery_state.power_supply_status ==
-        current_battery_state.POWER_SUPPLY_STATUS_CHARGING)
-      return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
-  }
+  /// Checks if robot is charging
+  if (charging)
+    return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
 
   /// Checks if robot is moving
   {
-    ReadLock robot_transform_lock(robot_transform_mutex);
+    RobotPose current_robot_pose;
+    RobotPose previous_robot_pose;
+    latest_robot_pose.load(current_robot_pose, previous_robot_pose);
 
-    if (!is_transform_close(
-        current_robot_transform, previous_robot_transform))
+    if (!is_pose_close(current_robot_pose, previous_robot_pose))
       return messages::RobotMode{messages::RobotMode::MODE_MOVING};
   }
   
@@ -187,75 +254,175 @@ messages::RobotMode ClientNode::get_robot_mode()
   return messages::RobotMode{messages::RobotMode::MODE_IDLE};
 }
 
-void ClientNode::publish_robot_state()
+void ClientNode::set_current_task_id(const std::string& _task_id)
 {
-  messages::RobotState new_robot_state;
-  new_robot_state.name = client_node_config.robot_name;
-  new_robot_state.model = client_node_config.robot_model;
-
   {
-    ReadLock task_id_lock(task_id_mutex);
-    new_robot_state.task_id = current_task_id;    
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = _task_id;
   }
 
-  new_robot_state.mode = get_robot_mode();
+  WriteLock state_snapshot_lock(state_snapshot_mutex);
+  auto snapshot = std::make_shared<StateSnapshot>(*state_snapshot);
+  snapshot->task_id = _task_id;
+  std::atomic_store(
+      &state_snapshot,
+      std::shared_ptr<const StateSnapshot>(std::move(snapshot)));
+}
 
+void ClientNode::update_path_snapshot()
+{
+  auto path = std::make_shared<std::vector<messages::Location>>();
+  path->reserve(goal_path.size());
+  for (const Goal& goal : goal_path)
   {
-    ReadLock battery_state_lock(battery_state_mutex);
-    /// RMF expects battery to have a percentage in the range for 0-100.
-    /// sensor_msgs/BatteryInfo on the other hand returns a value in 
-    /// the range of 0-1
-    new_robot_state.battery_percent = 100*current_battery_state.percentage;
+    path->push_back(
+        messages::Location{
+            (int32_t)goal.goal.target_pose.header.stamp.sec,
+            goal.goal.target_pose.header.stamp.nsec,
+            (float)goal.goal.target_pose.pose.position.x,
+            (float)goal.goal.target_pose.pose.position.y,
+            (float)(get_yaw_from_quat(
+                goal.goal.target_pose.pose.orientation)),
+            goal.level_name
+        });
   }
 
+  WriteLock state_snapshot_lock(state_snapshot_mutex);
+  auto snapshot = std::make_shared<StateSnapshot>(*state_snapshot);
+  snapshot->path = std::move(path);
+  std::atomic_store(
+      &state_snapshot,
+      std::shared_ptr<const StateSnapshot>(std::move(snapshot)));
+}
+
+void ClientNode::publish_robot_state()
+{
+  // The task id and path are read from the latest snapshot, which only waits
+  // for a snapshot pointer being copied, and everything else from atomics.
+  const std::shared_ptr<const StateSnapshot> snapshot =
+      std::atomic_load(&state_snapshot);
+
+  robot_state.name = client_node_config.robot_name;
+  robot_state.model = client_node_config.robot_model;
+  robot_state.task_id = snapshot->task_id;
+  robot_state.mode = get_robot_mode();
+  robot_state.battery_percent = battery_percent;
+
   {
-    ReadLock robot_transform_lock(robot_transform_mutex);
-    new_robot_state.location.sec = current_robot_transform.header.stamp.sec;
-    new_robot_state.location.nanosec = 
-        current_robot_transform.header.stamp.nsec;
-    new_robot_state.location.x = 
-        current_robot_transform.transform.translation.x;
-    new_robot_state.location.y = 
-        current_robot_transform.transform.translation.y;
-    new_robot_state.location.yaw = 
-        get_yaw_from_transform(current_robot_transform);
-    new_robot_state.location.level_name = client_node_config.level_name;
+    const RobotPose current_robot_pose = latest_robot_pose.load();
+    robot_state.location.sec = current_robot_pose.sec;
+    robot_state.location.nanosec = current_robot_pose.nanosec;
+    robot_state.location.x = current_robot_pose.x;
+    robot_state.location.y = current_robot_pose.y;
+    robot_state.location.yaw = current_robot_pose.yaw;
+    robot_state.location.level_name = client_node_config.level_name;
   }
 
-  new_robot_state.path.clear();
+  // The path is only copied again once it has changed.
+  if (snapshot->path != published_path)
   {
-    ReadLock goal_path_lock(goal_path_mutex);
-
-    for (size_t i = 0; i < goal_path.size(); ++i)
-    {
-      new_robot_state.path.push_back(
-          messages::Location{
-              (int32_t)goal_path[i].goal.target_pose.header.stamp.sec,
-              goal_path[i].goal.target_pose.header.stamp.nsec,
-              (float)goal_path[i].goal.target_pose.pose.position.x,
-              (float)goal_path[i].goal.target_pose.pose.position.y,
-              (float)(get_yaw_from_quat(
-                  goal_path[i].goal.target_pose.pose.orientation)),
-              goal_path[i].level_name
-          });
-    }
+    robot_state.path = *snapshot->path;
+    published_path = snapshot->path;
   }
 
-  if (!fields.client->send_robot_state(new_robot_state))
-    ROS_WARN("failed to send robot state: msg sec %u", new_robot_state.location.sec);
+  if (!fields.client->send_robot_state(robot_state))
+    ROS_WARN("failed to send robot state: msg sec %u", robot_state.location.sec);
 }
 
 bool ClientNode::is_valid_request(
     const std::string& _request_fleet_name,
+    uint32_t _request_fleet_id,
     const std::string& _request_robot_name,
-    const std::string& _request_task_id)
+    uint32_t _request_robot_id,
+    const std::string& _request_task_id,
+    uint32_t _request_type)
 {
   ReadLock task_id_lock(task_id_mutex);
   if (current_task_id == _request_task_id ||
-      client_node_config.robot_name != _request_robot_name ||
-      client_node_config.fleet_name != _request_fleet_name)
+      find_request_ack(_request_task_id, _request_type))
     return false;
-  return true;
+  return is_for_this_robot(
+      _request_fleet_name, _request_fleet_id,
+      _request_robot_name, _request_robot_id);
+}
+
+bool ClientNode::is_for_this_robot(
+    const std::string& _request_fleet_name,
+    uint32_t _request_fleet_id,
+    const std::string& _request_robot_name,
+    uint32_t _request_robot_id)
+{
+  // The own ids are looked up again whenever the server gives out ids of a
+  // new generation, the names are compared by id from then on.
+  if (messages::get_name_id_generation(_request_robot_id) !=
+      messages::get_name_id_generation(robot_name_id))
+  {
+    fleet_name_id = fields.client->get_name_id(client_node_config.fleet_name);
+    robot_name_id = fields.client->get_name_id(client_node_config.robot_name);
+  }
+  return messages::is_same_name(
+          robot_name_id, client_node_config.robot_name,
+          _request_robot_id, _request_robot_name) &&
+      messages::is_same_name(
+          fleet_name_id, client_node_config.fleet_name,
+          _request_fleet_id, _request_fleet_name);
+}
+
+void ClientNode::send_request_ack(
+    const std::string& _request_fleet_name,
+    const std::string& _request_robot_name,
+    const std::string& _request_task_id,
+    uint32_t _request_type,
+    bool _accepted,
+    const std::string& _reason)
+{
+  messages::RequestAck request_ack;
+  request_ack.fleet_name = _request_fleet_name;
+  request_ack.robot_name = _request_robot_name;
+  request_ack.task_id = _request_task_id;
+  request_ack.request_type = _request_type;
+  request_ack.accepted = _accepted;
+  request_ack.reason = _reason;
+  {
+    WriteLock task_id_lock(task_id_mutex);
+    request_acks.push_back(request_ack);
+    if (request_acks.size() > max_request_acks)
+      request_acks.pop_front();
+  }
+  fields.client->send_request_ack(request_ack);
+}
+
+void ClientNode::repeat_request_ack(
+    const std::string& _request_fleet_name,
+    const std::string& _request_robot_name,
+    const std::string& _request_task_id,
+    uint32_t _request_type)
+{
+  messages::RequestAck request_ack;
+  {
+    ReadLock task_id_lock(task_id_mutex);
+    const messages::RequestAck* handled_ack =
+        find_request_ack(_request_task_id, _request_type);
+    if (!handled_ack ||
+        handled_ack->robot_name != _request_robot_name ||
+        handled_ack->fleet_name != _request_fleet_name)
+      return;
+    request_ack = *handled_ack;
+  }
+  fields.client->send_request_ack(request_ack);
+}
+
+const messages::RequestAck* ClientNode::find_request_ack(
+    const std::string& _request_task_id,
+    uint32_t _request_type) const
+{
+  for (auto it = request_acks.rbegin(); it != request_acks.rend(); ++it)
+  {
+    if (it->task_id == _request_task_id &&
+        it->request_type == _request_type)
+      return &(*it);
+  }
+  return nullptr;
 }
 
 move_base_msgs::MoveBaseGoal ClientNode::location_to_move_base_goal(
@@ -272,25 +439,134 @@ move_base_msgs::MoveBaseGoal ClientNode::location_to_move_base_goal(
   return goal;
 }
 
+template <typename Request>
+const Request* ClientNode::find_newest_request(
+    const std::vector<Request>& _requests)
+{
+  for (auto it = _requests.rbegin(); it != _requests.rend(); ++it)
+  {
+    if (is_for_this_robot(
+        it->fleet_name, it->fleet_id, it->robot_name, it->robot_id))
+      return &(*it);
+  }
+  return nullptr;
+}
+
+template <typename Request>
+void ClientNode::reject_superseded_requests(
+    const std::vector<Request>& _requests,
+    const Request& _newest_request,
+    uint32_t _request_type)
+{
+  for (const Request& request : _requests)
+  {
+    if (&request == &_newest_request ||
+        request.task_id == _newest_request.task_id ||
+        !is_valid_request(
+            request.fleet_name, request.fleet_id,
+            request.robot_name, request.robot_id,
+            request.task_id, _request_type))
+      continue;
+    send_request_ack(
+        request.fleet_name, request.robot_name, request.task_id,
+        _request_type, false, "superseded by a newer request");
+  }
+}
+
 bool ClientNode::read_mode_request()
+{
+  fields.client->read_mode_requests(mode_requests);
+  return handle_mode_requests(mode_requests);
+}
+
+bool ClientNode::handle_mode_requests(
+    const std::vector<messages::ModeRequest>& _mode_requests)
+{
+  const messages::ModeRequest* mode_request =
+      find_newest_request(_mode_requests);
+  if (!mode_request)
+    return false;
+  reject_superseded_requests(
+      _mode_requests, *mode_request, messages::RequestAck::REQUEST_MODE);
+  return process_mode_request(*mode_request);
+}
+
+void ClientNode::stop_navigation()
+{
+  // The flags are set before, and handle_requests checks them again while
+  // holding goal_path_mutex, so a goal is either sent before this cancels
+  // it, or not sent at all.
+  WriteLock goal_path_lock(goal_path_mutex);
+  fields.move_base_client->cancelAllGoals();
+  if (!goal_path.empty())
+    goal_path[0].sent = false;
+}
+
+void ClientNode::cancel_docking()
 {
   messages::ModeRequest mode_request;
-  if (fields.client->read_mode_request(mode_request) && 
-      is_valid_request(
-          mode_request.fleet_name, mode_request.robot_name, 
-          mode_request.task_id))
   {
-    if (mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
-    {
-      ROS_INFO("received a PAUSE command.");
+    std::unique_lock<std::mutex> docking_lock(docking_mutex);
+    if (!docking_requested)
+      return;
+    docking_requested = false;
+    mode_request = docking_request;
+  }
 
-      fields.move_base_client->cancelAllGoals();
-      WriteLock goal_path_lock(goal_path_mutex);
-      if (!goal_path.empty())
-        goal_path[0].sent = false;
+  send_request_ack(
+      mode_request.fleet_name, mode_request.robot_name,
+      mode_request.task_id, messages::RequestAck::REQUEST_MODE,
+      false, "docking cancelled by a newer mode request");
+}
+
+void ClientNode::trigger_docking()
+{
+  messages::ModeRequest mode_request;
+  {
+    std::unique_lock<std::mutex> docking_lock(docking_mutex);
+    if (!docking_requested)
+      return;
+    docking_requested = false;
+    mode_request = docking_request;
+  }
 
+  std_srvs::Trigger trigger_srv;
+  fields.docking_trigger_client->call(trigger_srv);
+  if (!trigger_srv.response.success)
+  {
+    ROS_ERROR("Failed to trigger docking sequence, message: %s.",
+      trigger_srv.response.message.c_str());
+    request_error = true;
+    send_request_ack(
+        mode_request.fleet_name, mode_request.robot_name,
+        mode_request.task_id, messages::RequestAck::REQUEST_MODE,
+        false, "failed to trigger docking sequence");
+    return;
+  }
+
+  set_current_task_id(mode_request.task_id);
+  request_error = false;
+  send_request_ack(
+      mode_request.fleet_name, mode_request.robot_name,
+      mode_request.task_id, messages::RequestAck::REQUEST_MODE, true);
+}
+
+bool ClientNode::process_mode_request(
+    const messages::ModeRequest& mode_request)
+{
+  if (is_valid_request(
+          mode_request.fleet_name, mode_request.fleet_id,
+          mode_request.robot_name, mode_request.robot_id,
+          mode_request.task_id, messages::RequestAck::REQUEST_MODE))
+  {
+    if (mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
+    {
       paused = true;
       emergency = false;
+      cancel_docking();
+      stop_navigation();
+
+      ROS_INFO("received a PAUSE command.");
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
     {
@@ -300,9 +576,12 @@ bool ClientNode::read_mode_request()
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
     {
-      ROS_INFO("received an EMERGENCY command.");
       paused = false;
       emergency = true;
+      cancel_docking();
+      stop_navigation();
+
+      ROS_INFO("received an EMERGENCY command.");
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
     {
@@ -310,50 +589,81 @@ bool ClientNode::read_mode_request()
       if (fields.docking_trigger_client &&
         fields.docking_trigger_client->isValid())
       {
-        std_srvs::Trigger trigger_srv;
-        fields.docking_trigger_client->call(trigger_srv);
-        if (!trigger_srv.response.success)
+        // The service call blocks, so it is left to the update thread,
+        // which acknowledges the request once the call returns. Requests
+        // repeated in the meantime are not queued again.
         {
-          ROS_ERROR("Failed to trigger docking sequence, message: %s.",
-            trigger_srv.response.message.c_str());
-          request_error = true;
-          return false;
+          std::unique_lock<std::mutex> docking_lock(docking_mutex);
+          if (mode_request.task_id == docking_task_id)
+            return true;
         }
+        cancel_docking();
+
+        std::unique_lock<std::mutex> docking_lock(docking_mutex);
+        docking_request = mode_request;
+        docking_task_id = mode_request.task_id;
+        docking_requested = true;
+        return true;
       }
     }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = mode_request.task_id;
+    set_current_task_id(mode_request.task_id);
 
     request_error = false;
+    send_request_ack(
+        mode_request.fleet_name, mode_request.robot_name,
+        mode_request.task_id, messages::RequestAck::REQUEST_MODE, true);
     return true;
   }
+  repeat_request_ack(
+      mode_request.fleet_name, mode_request.robot_name,
+      mode_request.task_id, messages::RequestAck::REQUEST_MODE);
   return false;
 }
 
 bool ClientNode::read_path_request()
 {
-  messages::PathRequest path_request;
-  if (fields.client->read_path_request(path_request) &&
-      is_valid_request(
-          path_request.fleet_name, path_request.robot_name,
-          path_request.task_id))
+  fields.client->read_path_requests(path_requests);
+  return handle_path_requests(path_requests);
+}
+
+bool ClientNode::handle_path_requests(
+    const std::vector<messages::PathRequest>& _path_requests)
+{
+  const messages::PathRequest* path_request =
+      find_newest_request(_path_requests);
+  if (!path_request)
+    return false;
+  reject_superseded_requests(
+      _path_requests, *path_request, messages::RequestAck::REQUEST_PATH);
+  return process_path_request(*path_request);
+}
+
+bool ClientNode::process_path_request(
+    const messages::PathRequest& path_request)
+{
+  if (is_valid_request(
+          path_request.fleet_name, path_request.fleet_id,
+          path_request.robot_name, path_request.robot_id,
+          path_request.task_id, messages::RequestAck::REQUEST_PATH))
   {
     ROS_INFO("received a Path command of size %lu.", path_request.path.size());
 
     if (path_request.path.size() <= 0)
+    {
+      send_request_ack(
+          path_request.fleet_name, path_request.robot_name,
+          path_request.task_id, messages::RequestAck::REQUEST_PATH, false,
+          "empty path");
       return false;
+    }
 
     // Sanity check: the first waypoint of the Path must be within N meters of
     // our current position. Otherwise, ignore the request.
     {
-      ReadLock robot_transform_lock(robot_transform_mutex);
-      const double dx =
-          path_request.path[0].x - 
-          current_robot_transform.transform.translation.x;
-      const double dy =
-          path_request.path[0].y -
-          current_robot_transform.transform.translation.y;
+      const RobotPose current_robot_pose = latest_robot_pose.load();
+      const double dx = path_request.path[0].x - current_robot_pose.x;
+      const double dy = path_request.path[0].y - current_robot_pose.y;
       const double dist_to_first_waypoint = sqrt(dx*dx + dy*dy);
 
       ROS_INFO("distance to first waypoint: %.2f\n", dist_to_first_waypoint);
@@ -366,75 +676,119 @@ bool ClientNode::read_path_request()
             client_node_config.max_dist_to_first_waypoint);
         
         fields.move_base_client->cancelAllGoals();
-        WriteLock goal_path_lock(goal_path_mutex);
-        goal_path.clear();
+        {
+          WriteLock goal_path_lock(goal_path_mutex);
+          goal_path.clear();
+          update_path_snapshot();
+        }
 
         request_error = true;
         emergency = false;
         paused = false;
+        send_request_ack(
+            path_request.fleet_name, path_request.robot_name,
+            path_request.task_id, messages::RequestAck::REQUEST_PATH, false,
+            "first waypoint too far away");
         return false;
       }
     }
 
-    WriteLock goal_path_lock(goal_path_mutex);
-    goal_path.clear();
-    for (size_t i = 0; i < path_request.path.size(); ++i)
     {
-      goal_path.push_back(
-          Goal {
-              path_request.path[i].level_name,
-              location_to_move_base_goal(path_request.path[i]),
-              false,
-              0,
-              ros::Time(
-                  path_request.path[i].sec, path_request.path[i].nanosec)});
+      WriteLock goal_path_lock(goal_path_mutex);
+      goal_path.clear();
+      for (size_t i = 0; i < path_request.path.size(); ++i)
+      {
+        goal_path.push_back(
+            Goal {
+                path_request.path[i].level_name,
+                location_to_move_base_goal(path_request.path[i]),
+                false,
+                0,
+                ros::Time(
+                    path_request.path[i].sec, path_request.path[i].nanosec)});
+      }
+      update_path_snapshot();
     }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = path_request.task_id;
+    set_current_task_id(path_request.task_id);
 
     if (paused)
       paused = false;
 
     request_error = false;
+    send_request_ack(
+        path_request.fleet_name, path_request.robot_name,
+        path_request.task_id, messages::RequestAck::REQUEST_PATH, true);
     return true;
   }
+  repeat_request_ack(
+      path_request.fleet_name, path_request.robot_name,
+      path_request.task_id, messages::RequestAck::REQUEST_PATH);
   return false;
 }
 
 bool ClientNode::read_destination_request()
 {
-  messages::DestinationRequest destination_request;
-  if (fields.client->read_destination_request(destination_request) &&
-      is_valid_request(
-          destination_request.fleet_name, destination_request.robot_name,
-          destination_request.task_id))
+  fields.client->read_destination_requests(destination_requests);
+  return handle_destination_requests(destination_requests);
+}
+
+bool ClientNode::handle_destination_requests(
+    const std::vector<messages::DestinationRequest>& _destination_requests)
+{
+  const messages::DestinationRequest* destination_request =
+      find_newest_request(_destination_requests);
+  if (!destination_request)
+    return false;
+  reject_superseded_requests(
+      _destination_requests, *destination_request,
+      messages::RequestAck::REQUEST_DESTINATION);
+  return process_destination_request(*destination_request);
+}
+
+bool ClientNode::process_destination_request(
+    const messages::DestinationRequest& destination_request)
+{
+  if (is_valid_request(
+          destination_request.fleet_name, destination_request.fleet_id,
+          destination_request.robot_name, destination_request.robot_id,
+          destination_request.task_id, messages::RequestAck::REQUEST_DESTINATION))
   {
     ROS_INFO("received a Destination command, x: %.2f, y: %.2f, yaw: %.2f",
         destination_request.destination.x, destination_request.destination.y,
         destination_request.destination.yaw);
     
-    WriteLock goal_path_lock(goal_path_mutex);
-    goal_path.clear();
-    goal_path.push_back(
-        Goal {
-            destination_request.destination.level_name,
-            location_to_move_base_goal(destination_request.destination),
-            false,
-            0,
-            ros::Time(
-                destination_request.destination.sec, 
-                destination_request.destination.nanosec)});
+    {
+      WriteLock goal_path_lock(goal_path_mutex);
+      goal_path.clear();
+      goal_path.push_back(
+          Goal {
+              destination_request.destination.level_name,
+              location_to_move_base_goal(destination_request.destination),
+              false,
+              0,
+              ros::Time(
+                  destination_request.destination.sec, 
+                  destination_request.destination.nanosec)});
+      update_path_snapshot();
+    }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = destination_request.task_id;
+    set_current_task_id(destination_request.task_id);
 
     if (paused)
       paused = false;
 
     request_error = false;
+    send_request_ack(
+        destination_request.fleet_name, destination_request.robot_name,
+        destination_request.task_id,
+        messages::RequestAck::REQUEST_DESTINATION, true);
     return true;
   }
+  repeat_request_ack(
+      destination_request.fleet_name, destination_request.robot_name,
+      destination_request.task_id,
+      messages::RequestAck::REQUEST_DESTINATION);
   return false;
 }
 
@@ -452,8 +806,14 @@ void ClientNode::handle_requests()
   if (emergency || request_error || paused)
     return;
 
-  // ooooh we have goals
+  // goals are kept until the navigation stack is up
+  if (!navigation_ready)
+    return;
+
+  // ooooh we have goals, unless the robot was stopped since the check above
   WriteLock goal_path_lock(goal_path_mutex);
+  if (emergency || request_error || paused)
+    return;
   if (!goal_path.empty())
   {
     // Goals must have been updated since last handling, execute them now
@@ -477,6 +837,7 @@ void ClientNode::handle_requests()
       if (ros::Time::now() >= goal_path.front().goal_end_time)
       {
         goal_path.pop_front();
+        update_path_snapshot();
       }
       else
       {
@@ -515,6 +876,7 @@ void ClientNode::handle_requests()
             goal_path.front().aborted_count);
         fields.move_base_client->cancelGoal();
         goal_path.clear();
+        update_path_snapshot();
         return;
       }
     }
@@ -526,6 +888,7 @@ void ClientNode::handle_requests()
           "requests or manual intervention.");
       fields.move_base_client->cancelGoal();
       goal_path.clear();
+      update_path_snapshot();
       return;
     }
   }
@@ -533,6 +896,16 @@ void ClientNode::handle_requests()
   // otherwise, mode is correct, nothing in queue, nothing else to do then
 }
 
+void ClientNode::pose_thread_fn()
+{
+  ros::Rate pose_rate(client_node_config.update_frequency);
+  while (node->ok())
+  {
+    pose_rate.sleep();
+    get_robot_transform();
+  }
+}
+
 void ClientNode::update_thread_fn()
 {
   while (node->ok())
@@ -540,10 +913,10 @@ void ClientNode::update_thread_fn()
     update_rate->sleep();
     ros::spinOnce();
 
-    get_robot_transform();
-
-    read_requests();
+    if (!requests_event_driven)
+      read_requests();
 
+    trigger_docking();
     handle_requests();
   }
 }
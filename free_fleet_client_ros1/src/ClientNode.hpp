@@ -22,6 +22,7 @@
 #include <mutex>
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -37,8 +38,14 @@
 #include <actionlib/client/simple_action_client.h>
 
 #include <free_fleet/Client.hpp>
+#include <free_fleet/messages/NameId.hpp>
 #include <free_fleet/messages/Location.hpp>
+#include <free_fleet/messages/ModeRequest.hpp>
+#include <free_fleet/messages/PathRequest.hpp>
+#include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 
+#include "utilities.hpp"
 #include "ClientNodeConfig.hpp"
 
 namespace free_fleet
@@ -93,9 +100,9 @@ private:
 
   ros::Subscriber battery_percent_sub;
 
-  std::mutex battery_state_mutex;
+  std::atomic<float> battery_percent{0.0};
 
-  sensor_msgs::BatteryState current_battery_state;
+  std::atomic<bool> charging{false};
 
   void battery_state_callback_fn(const sensor_msgs::BatteryState& msg);
 
@@ -106,11 +113,9 @@ private:
 
   tf2_ros::TransformListener tf2_listener;
 
-  std::mutex robot_transform_mutex;
-
-  geometry_msgs::TransformStamped current_robot_transform;
-
-  geometry_msgs::TransformStamped previous_robot_transform;
+  /// Latest pose of the robot, looked up on the pose thread and read by the
+  /// request handling and publishing without waiting for any lookup.
+  LatestRobotPose latest_robot_pose;
 
   bool get_robot_transform();
 
@@ -124,27 +129,98 @@ private:
   std::atomic<bool> emergency;
   std::atomic<bool> paused;
 
+  // The node runs, reporting the robot as waiting, until the navigation
+  // servers are up. Requests that arrive in the meantime are kept and only
+  // sent once they are.
+  std::atomic<bool> navigation_ready{false};
+
   messages::RobotMode get_robot_mode();
 
+  /// Cancels the current goal right away, keeping the path to be resumed
+  /// later. Called with mode requests as soon as they arrive.
+  void stop_navigation();
+
+  std::vector<messages::ModeRequest> mode_requests;
+
   bool read_mode_request();
 
+  bool handle_mode_requests(
+      const std::vector<messages::ModeRequest>& mode_requests);
+
+  bool process_mode_request(const messages::ModeRequest& mode_request);
+
+  // Docking is triggered through a blocking service call, which the update
+  // thread makes, so that whoever takes mode requests stays free for a
+  // PAUSE or EMERGENCY in the meantime. Those reject a docking request that
+  // was not triggered yet. Guarded by docking_mutex.
+  std::mutex docking_mutex;
+
+  bool docking_requested = false;
+
+  messages::ModeRequest docking_request;
+
+  std::string docking_task_id;
+
+  void cancel_docking();
+
+  void trigger_docking();
+
   // --------------------------------------------------------------------------
   // Path request handling
 
+  std::vector<messages::PathRequest> path_requests;
+
   bool read_path_request();
 
+  bool handle_path_requests(
+      const std::vector<messages::PathRequest>& path_requests);
+
+  bool process_path_request(const messages::PathRequest& path_request);
+
   // --------------------------------------------------------------------------
   // Destination request handling
 
+  std::vector<messages::DestinationRequest> destination_requests;
+
   bool read_destination_request();
 
+  bool handle_destination_requests(
+      const std::vector<messages::DestinationRequest>& destination_requests);
+
+  bool process_destination_request(
+      const messages::DestinationRequest& destination_request);
+
   // --------------------------------------------------------------------------
   // Task handling
 
   bool is_valid_request(
       const std::string& request_fleet_name,
+      uint32_t request_fleet_id,
+      const std::string& request_robot_name,
+      uint32_t request_robot_id,
+      const std::string& request_task_id,
+      uint32_t request_type);
+
+  bool is_for_this_robot(
+      const std::string& request_fleet_name,
+      uint32_t request_fleet_id,
       const std::string& request_robot_name,
-      const std::string& request_task_id);
+      uint32_t request_robot_id);
+
+  /// Requests that piled up since the last update, or that a listener took
+  /// together, were superseded by the newest one targetted towards this
+  /// robot, which is the only one acted on. Null if none of them were
+  /// targetted towards this robot.
+  template <typename Request>
+  const Request* find_newest_request(const std::vector<Request>& requests);
+
+  /// Acknowledges the requests superseded by the newest one as rejected
+  /// without acting on them, so that the server does not wait on them.
+  template <typename Request>
+  void reject_superseded_requests(
+      const std::vector<Request>& requests,
+      const Request& newest_request,
+      uint32_t request_type);
 
   move_base_msgs::MoveBaseGoal location_to_move_base_goal(
       const messages::Location& location) const;
@@ -153,6 +229,38 @@ private:
 
   std::string current_task_id;
 
+  // Ids the server gave to the own fleet and robot names. Atomic, as they are
+  // refreshed both by the thread taking mode requests and by the update
+  // thread looking for the newest path or destination request.
+  std::atomic<uint32_t> fleet_name_id{0};
+
+  std::atomic<uint32_t> robot_name_id{0};
+
+  // Acknowledgements last sent to the server, oldest first, guarded by
+  // task_id_mutex. A request the server repeats because its acknowledgement
+  // got lost is only acknowledged again, never handled a second time.
+  static constexpr std::size_t max_request_acks = 16;
+
+  std::deque<messages::RequestAck> request_acks;
+
+  const messages::RequestAck* find_request_ack(
+      const std::string& request_task_id,
+      uint32_t request_type) const;
+
+  void send_request_ack(
+      const std::string& request_fleet_name,
+      const std::string& request_robot_name,
+      const std::string& request_task_id,
+      uint32_t request_type,
+      bool accepted,
+      const std::string& reason = "");
+
+  void repeat_request_ack(
+      const std::string& request_fleet_name,
+      const std::string& request_robot_name,
+      const std::string& request_task_id,
+      uint32_t request_type);
+
   struct Goal
   {
     std::string level_name;
@@ -166,6 +274,40 @@ private:
 
   std::deque<Goal> goal_path;
 
+  // Task id and path as they are published, replaced as a whole whenever
+  // either changes by writers holding state_snapshot_mutex, and read by
+  // publish_robot_state through std::atomic_load. That is not lock-free on
+  // libstdc++, which guards shared pointer atomics with a pool of global
+  // mutexes, but only ever held for copying the pointer, so the publisher
+  // no longer waits on the request handling or the goal path.
+  struct StateSnapshot
+  {
+    std::string task_id;
+    std::shared_ptr<const std::vector<messages::Location>> path =
+        std::make_shared<const std::vector<messages::Location>>();
+  };
+
+  std::mutex state_snapshot_mutex;
+
+  std::shared_ptr<const StateSnapshot> state_snapshot =
+      std::make_shared<const StateSnapshot>();
+
+  void set_current_task_id(const std::string& task_id);
+
+  // Rebuilds the published path, called by whoever changed goal_path while
+  // still holding goal_path_mutex.
+  void update_path_snapshot();
+
+  // Reused for every robot state published, with the path last copied into
+  // it.
+  messages::RobotState robot_state;
+
+  std::shared_ptr<const std::vector<messages::Location>> published_path;
+
+  /// Set when requests are pushed to us by DDS listeners, in which case the
+  /// update thread no longer needs to poll for them.
+  bool requests_event_driven = false;
+
   void read_requests();
 
   void handle_requests();
@@ -175,14 +317,22 @@ private:
   // --------------------------------------------------------------------------
   // Threads and thread functions
 
+  std::thread pose_thread;
+
   std::thread update_thread;
 
   std::thread publish_thread;
 
+  void pose_thread_fn();
+
   void update_thread_fn();
 
   void publish_thread_fn();
 
+  std::thread navigation_thread;
+
+  void wait_for_navigation();
+
   // --------------------------------------------------------------------------
 
   ClientNodeConfig client_node_config;
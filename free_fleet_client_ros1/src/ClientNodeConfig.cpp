@@ -63,6 +63,19 @@ void ClientNodeConfig::get_param_if_available(
   }
 }
 
+void ClientNodeConfig::get_param_if_available(
+    const ros::NodeHandle& _node, const std::string& _key,
+    bool& _param_out)
+{
+  bool tmp_param;
+  if (_node.getParam(_key, tmp_param))
+  {
+    ROS_INFO("Found %s on the parameter server. Setting %s to %s.",
+        _key.c_str(), _key.c_str(), tmp_param ? "true" : "false");
+    _param_out = tmp_param;
+  }
+}
+
 void ClientNodeConfig::print_config() const
 {
   printf("ROS 1 CLIENT CONFIGURATION\n");
@@ -73,6 +86,15 @@ void ClientNodeConfig::print_config() const
   printf("  wait timeout: %.1f\n", wait_timeout);
   printf("  update request frequency: %.1f\n", update_frequency);
   printf("  publish state frequency: %.1f\n", publish_frequency);
+  printf("  adaptive publishing: %s\n", adaptive_publishing ? "true" : "false");
+  if (adaptive_publishing)
+  {
+    printf("    maximum publish state frequency: %.1f\n",
+        max_publish_frequency);
+    printf("    position threshold: %.3f\n", publish_position_threshold);
+    printf("    yaw threshold: %.3f\n", publish_yaw_threshold);
+    printf("    battery threshold: %.1f\n", publish_battery_threshold);
+  }
   printf("  maximum distance to first waypoint: %.1f\n", 
       max_dist_to_first_waypoint);
   printf("  TOPICS\n");
@@ -84,22 +106,39 @@ void ClientNodeConfig::print_config() const
   printf("    robot frame: %s\n", robot_frame.c_str());
   printf("CLIENT-SERVER DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds shared memory: %s\n", dds_shared_memory ? "true" : "false");
+  printf("  dds bounded robot state: %s\n",
+      dds_bounded_robot_state ? "true" : "false");
+  printf("  dds compact path: %s\n", dds_compact_path ? "true" : "false");
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n", 
       dds_destination_request_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("    name id: %s\n", dds_name_id_topic.c_str());
 }
   
 ClientConfig ClientNodeConfig::get_client_config() const
 {
   ClientConfig client_config;
   client_config.dds_domain = dds_domain;
+  client_config.dds_shared_memory = dds_shared_memory;
+  client_config.dds_bounded_robot_state = dds_bounded_robot_state;
+  client_config.dds_compact_path = dds_compact_path;
   client_config.dds_state_topic = dds_state_topic;
   client_config.dds_mode_request_topic = dds_mode_request_topic;
   client_config.dds_path_request_topic = dds_path_request_topic;
   client_config.dds_destination_request_topic = dds_destination_request_topic;
+  client_config.dds_request_ack_topic = dds_request_ack_topic;
+  client_config.dds_name_id_topic = dds_name_id_topic;
+  client_config.adaptive_state_publishing = adaptive_publishing;
+  client_config.state_heartbeat_period = 1.0 / publish_frequency;
+  client_config.state_min_period = 1.0 / max_publish_frequency;
+  client_config.state_position_threshold = publish_position_threshold;
+  client_config.state_yaw_threshold = publish_yaw_threshold;
+  client_config.state_battery_threshold = publish_battery_threshold;
   return client_config;
 }
 
@@ -126,6 +165,13 @@ ClientNodeConfig ClientNodeConfig::make()
       node_private_ns, "docking_trigger_server_name", config.docking_trigger_server_name);
   config.get_param_if_available(
       node_private_ns, "dds_domain", config.dds_domain);
+  config.get_param_if_available(
+      node_private_ns, "dds_shared_memory", config.dds_shared_memory);
+  config.get_param_if_available(
+      node_private_ns, "dds_bounded_robot_state",
+      config.dds_bounded_robot_state);
+  config.get_param_if_available(
+      node_private_ns, "dds_compact_path", config.dds_compact_path);
   config.get_param_if_available(
       node_private_ns, "dds_mode_request_topic", config.dds_mode_request_topic);
   config.get_param_if_available(
@@ -133,12 +179,28 @@ ClientNodeConfig ClientNodeConfig::make()
   config.get_param_if_available(
       node_private_ns, "dds_destination_request_topic", 
       config.dds_destination_request_topic);
+  config.get_param_if_available(
+      node_private_ns, "dds_request_ack_topic", config.dds_request_ack_topic);
+  config.get_param_if_available(
+      node_private_ns, "dds_name_id_topic", config.dds_name_id_topic);
   config.get_param_if_available(
       node_private_ns, "wait_timeout", config.wait_timeout);
   config.get_param_if_available(
       node_private_ns, "update_frequency", config.update_frequency);
   config.get_param_if_available(
       node_private_ns, "publish_frequency", config.publish_frequency);
+  config.get_param_if_available(
+      node_private_ns, "adaptive_publishing", config.adaptive_publishing);
+  config.get_param_if_available(
+      node_private_ns, "max_publish_frequency", config.max_publish_frequency);
+  config.get_param_if_available(
+      node_private_ns, "publish_position_threshold",
+      config.publish_position_threshold);
+  config.get_param_if_available(
+      node_private_ns, "publish_yaw_threshold", config.publish_yaw_threshold);
+  config.get_param_if_available(
+      node_private_ns, "publish_battery_threshold",
+      config.publish_battery_threshold);
   config.get_param_if_available(
       node_private_ns, "max_dist_to_first_waypoint", 
       config.max_dist_to_first_waypoint);
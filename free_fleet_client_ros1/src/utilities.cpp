@@ -15,6 +15,9 @@
  *
  */
 
+#include <cmath>
+#include <thread>
+
 #include "utilities.hpp"
 
 #include <tf2/LinearMath/Matrix3x3.h>
@@ -82,5 +85,96 @@ bool is_transform_close(
   return true;
 }
 
+RobotPose to_robot_pose(
+    const geometry_msgs::TransformStamped& _transform_stamped)
+{
+  RobotPose pose;
+  pose.sec = static_cast<int32_t>(_transform_stamped.header.stamp.sec);
+  pose.nanosec = _transform_stamped.header.stamp.nsec;
+  pose.x = _transform_stamped.transform.translation.x;
+  pose.y = _transform_stamped.transform.translation.y;
+  pose.yaw = get_yaw_from_transform(_transform_stamped);
+  return pose;
+}
+
+bool is_pose_close(const RobotPose& _first, const RobotPose& _second)
+{
+  double elapsed_sec =
+      (static_cast<double>(_second.sec) - _first.sec) +
+      (static_cast<double>(_second.nanosec) - _first.nanosec) / 1e9;
+  double distance = hypot(_second.x - _first.x, _second.y - _first.y);
+  double speed = std::abs(distance / elapsed_sec);
+  if (speed > 0.01)
+    return false;
+
+  double turning_speed = std::abs((_second.yaw - _first.yaw) / elapsed_sec);
+  if (turning_speed > 0.01)
+    return false;
+
+  return true;
+}
+
+void LatestRobotPose::Fields::store(const RobotPose& _pose)
+{
+  sec.store(_pose.sec, std::memory_order_relaxed);
+  nanosec.store(_pose.nanosec, std::memory_order_relaxed);
+  x.store(_pose.x, std::memory_order_relaxed);
+  y.store(_pose.y, std::memory_order_relaxed);
+  yaw.store(_pose.yaw, std::memory_order_relaxed);
+}
+
+RobotPose LatestRobotPose::Fields::load() const
+{
+  RobotPose pose;
+  pose.sec = sec.load(std::memory_order_relaxed);
+  pose.nanosec = nanosec.load(std::memory_order_relaxed);
+  pose.x = x.load(std::memory_order_relaxed);
+  pose.y = y.load(std::memory_order_relaxed);
+  pose.yaw = yaw.load(std::memory_order_relaxed);
+  return pose;
+}
+
+void LatestRobotPose::store(const RobotPose& _pose)
+{
+  // An odd sequence marks the poses as being written, readers that saw it
+  // odd, or saw it change while reading, read them again.
+  const uint32_t begin = sequence.load(std::memory_order_relaxed);
+  sequence.store(begin + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  previous.store(current.load());
+  current.store(_pose);
+
+  sequence.store(begin + 2, std::memory_order_release);
+}
+
+void LatestRobotPose::load(RobotPose& _current, RobotPose& _previous) const
+{
+  while (true)
+  {
+    const uint32_t begin = sequence.load(std::memory_order_acquire);
+    if (begin & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    _current = current.load();
+    _previous = previous.load();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) == begin)
+      return;
+  }
+}
+
+RobotPose LatestRobotPose::load() const
+{
+  RobotPose current_pose;
+  RobotPose previous_pose;
+  load(current_pose, previous_pose);
+  return current_pose;
+}
+
 } // namespace ros1
 } // namespace free_fleet
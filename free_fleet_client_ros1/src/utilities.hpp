@@ -18,6 +18,9 @@
 #ifndef FREE_FLEET_CLIENT_ROS1__SRC__UTILITIES_HPP
 #define FREE_FLEET_CLIENT_ROS1__SRC__UTILITIES_HPP
 
+#include <atomic>
+#include <cstdint>
+
 #include <geometry_msgs/Quaternion.h>
 #include <geometry_msgs/TransformStamped.h>
 
@@ -37,6 +40,62 @@ bool is_transform_close(
     const geometry_msgs::TransformStamped& transform_1,
     const geometry_msgs::TransformStamped& transform_2);
 
+/// Pose of the robot in the map frame, stamped with the time it was at.
+struct RobotPose
+{
+  int32_t sec = 0;
+  uint32_t nanosec = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double yaw = 0.0;
+};
+
+RobotPose to_robot_pose(
+    const geometry_msgs::TransformStamped& transform_stamped);
+
+bool is_pose_close(const RobotPose& pose_1, const RobotPose& pose_2);
+
+/// Latest pose of the robot and the one looked up before it, handed over
+/// from the thread looking them up to any number of readers behind a
+/// sequence lock. Readers never wait for a lookup in progress, they get the
+/// last pose that was found.
+class LatestRobotPose
+{
+public:
+
+  /// Stores a newly looked up pose, keeping the one before it. Only ever
+  /// called from a single thread.
+  void store(const RobotPose& pose);
+
+  /// Loads the latest pose and the one before it, as stored together.
+  void load(RobotPose& current, RobotPose& previous) const;
+
+  /// Loads the latest pose.
+  RobotPose load() const;
+
+private:
+
+  struct Fields
+  {
+    std::atomic<int32_t> sec{0};
+    std::atomic<uint32_t> nanosec{0};
+    std::atomic<double> x{0.0};
+    std::atomic<double> y{0.0};
+    std::atomic<double> yaw{0.0};
+
+    void store(const RobotPose& pose);
+
+    RobotPose load() const;
+  };
+
+  std::atomic<uint32_t> sequence{0};
+
+  Fields current;
+
+  Fields previous;
+
+};
+
 } // namespace ros1
 } // namespace free_fleet
 
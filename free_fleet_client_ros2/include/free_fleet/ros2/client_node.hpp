@@ -19,6 +19,8 @@
 #define FREE_FLEET__ROS2__CLIENTNODE_HPP
 
 #include <deque>
+#include <mutex>
+#include <string>
 #include <shared_mutex>
 #include <atomic>
 #include <memory>
@@ -47,10 +49,13 @@
 #include <free_fleet/messages/ModeRequest.hpp>
 #include <free_fleet/messages/PathRequest.hpp>
 #include <free_fleet/messages/DestinationRequest.hpp>
+#include <free_fleet/messages/RequestAck.hpp>
 
 #include <free_fleet/Client.hpp>
+#include <free_fleet/messages/NameId.hpp>
 #include <free_fleet/messages/Location.hpp>
 
+#include "free_fleet/ros2/utilities.hpp"
 #include "free_fleet/ros2/client_node_config.hpp"
 
 namespace free_fleet
@@ -91,8 +96,8 @@ private:
   // Battery handling
 
   rclcpp::Subscription<sensor_msgs::msg::BatteryState>::SharedPtr  battery_percent_sub;
-  Mutex battery_state_mutex;
-  sensor_msgs::msg::BatteryState current_battery_state;
+  std::atomic<float> battery_percent{0.0};
+  std::atomic<bool> charging{false};
   void battery_state_callback_fn(const sensor_msgs::msg::BatteryState::SharedPtr msg);
 
   // --------------------------------------------------------------------------
@@ -100,9 +105,14 @@ private:
 
   std::shared_ptr<tf2_ros::Buffer> tf2_buffer;
   std::shared_ptr<tf2_ros::TransformListener> tf2_listener;
-  Mutex robot_pose_mutex;
-  geometry_msgs::msg::PoseStamped current_robot_pose;
-  geometry_msgs::msg::PoseStamped previous_robot_pose;
+
+  // Looking up the pose waits for the transform for up to wait_timeout, so
+  // it runs on a thread of its own and hands the latest pose over to the
+  // request handling and publishing, which never wait for it.
+  LatestRobotPose latest_robot_pose;
+  std::atomic<bool> looking_up_pose{false};
+  std::thread pose_thread;
+  void pose_thread_fn();
 
   bool get_robot_pose();
 
@@ -116,30 +126,109 @@ private:
   std::atomic<bool> emergency;
   std::atomic<bool> paused;
 
+  // The node runs, reporting the robot as waiting, until the navigation
+  // servers are up. Requests that arrive in the meantime are kept and only
+  // sent once they are.
+  std::atomic<bool> navigation_ready{false};
+  std::thread navigation_thread;
+  void wait_for_navigation();
+
   messages::RobotMode get_robot_mode();
+
+  // Cancels the current goal right away, keeping the path to be resumed
+  // later. Called with mode requests as soon as they arrive.
+  void stop_navigation();
+  std::vector<messages::ModeRequest> mode_requests;
   bool read_mode_request();
+  bool handle_mode_requests(
+      const std::vector<messages::ModeRequest>& mode_requests);
+  bool process_mode_request(const messages::ModeRequest& mode_request);
 
   // --------------------------------------------------------------------------
   // Path request handling
 
+  std::vector<messages::PathRequest> path_requests;
   bool read_path_request();
+  bool handle_path_requests(
+      const std::vector<messages::PathRequest>& path_requests);
+  bool process_path_request(const messages::PathRequest& path_request);
 
   // --------------------------------------------------------------------------
   // Destination request handling
 
+  std::vector<messages::DestinationRequest> destination_requests;
   bool read_destination_request();
+  bool handle_destination_requests(
+      const std::vector<messages::DestinationRequest>& destination_requests);
+  bool process_destination_request(
+      const messages::DestinationRequest& destination_request);
 
   // --------------------------------------------------------------------------
   // Task handling
 
   bool is_valid_request(
       const std::string& request_fleet_name,
+      uint32_t request_fleet_id,
       const std::string& request_robot_name,
-      const std::string& request_task_id);
+      uint32_t request_robot_id,
+      const std::string& request_task_id,
+      uint32_t request_type);
+
+  bool is_for_this_robot(
+      const std::string& request_fleet_name,
+      uint32_t request_fleet_id,
+      const std::string& request_robot_name,
+      uint32_t request_robot_id);
+
+  // Requests that piled up since the last update, or that a listener took
+  // together, were superseded by the newest one targetted towards this robot,
+  // which is the only one acted on. Null if none of them were targetted
+  // towards this robot.
+  template <typename Request>
+  const Request* find_newest_request(const std::vector<Request>& requests);
+
+  // Acknowledges the requests superseded by the newest one as rejected
+  // without acting on them, so that the server does not wait on them.
+  template <typename Request>
+  void reject_superseded_requests(
+      const std::vector<Request>& requests,
+      const Request& newest_request,
+      uint32_t request_type);
 
   Mutex task_id_mutex;
   std::string current_task_id;
 
+  // Ids the server gave to the own fleet and robot names. Atomic, as they are
+  // refreshed both by the thread taking mode requests and by the update
+  // thread looking for the newest path or destination request, without
+  // holding task_id_mutex exclusively.
+  std::atomic<uint32_t> fleet_name_id{0};
+  std::atomic<uint32_t> robot_name_id{0};
+
+  // Acknowledgements last sent to the server, oldest first, guarded by
+  // task_id_mutex. A request the server repeats because its acknowledgement
+  // got lost is only acknowledged again, never handled a second time.
+  static constexpr std::size_t max_request_acks = 16;
+  std::deque<messages::RequestAck> request_acks;
+
+  const messages::RequestAck* find_request_ack(
+      const std::string& request_task_id,
+      uint32_t request_type) const;
+
+  void send_request_ack(
+      const std::string& request_fleet_name,
+      const std::string& request_robot_name,
+      const std::string& request_task_id,
+      uint32_t request_type,
+      bool accepted,
+      const std::string& reason = "");
+
+  void repeat_request_ack(
+      const std::string& request_fleet_name,
+      const std::string& request_robot_name,
+      const std::string& request_task_id,
+      uint32_t request_type);
+
   NavigateToPose::Goal location_to_nav_goal(
     const messages::Location& _location) const;
 
@@ -155,6 +244,49 @@ private:
   Mutex goal_path_mutex;
   std::deque<Goal> goal_path;
 
+  // Bumped whenever goal_path changes, so that results of goals sent for
+  // the path before, and waypoints reached early on it, are ignored.
+  // Guarded by goal_path_mutex.
+  uint64_t goal_generation = 0;
+
+  // Waypoints reached early, released by the update timer once due. Guarded
+  // by goal_path_mutex.
+  std::unique_ptr<WaypointScheduler> waypoint_scheduler;
+  std::vector<uint64_t> released_generations;
+
+  // Called by whoever changed goal_path while still holding goal_path_mutex.
+  void goal_path_changed();
+  void release_waypoints();
+
+  // Task id and path as they are published, replaced as a whole whenever
+  // either changes by writers holding state_snapshot_mutex, and read by
+  // publish_robot_state through std::atomic_load. That is not lock-free on
+  // libstdc++, which guards shared pointer atomics with a pool of global
+  // mutexes, but only ever held for copying the pointer, so the publisher
+  // no longer waits on the request handling or the goal path.
+  struct StateSnapshot
+  {
+    std::string task_id;
+    std::shared_ptr<const std::vector<messages::Location>> path =
+      std::make_shared<const std::vector<messages::Location>>();
+  };
+  std::mutex state_snapshot_mutex;
+  std::shared_ptr<const StateSnapshot> state_snapshot =
+    std::make_shared<const StateSnapshot>();
+  void set_current_task_id(const std::string& task_id);
+
+  // Rebuilds the published path, see goal_path_changed.
+  void update_path_snapshot();
+
+  // Reused for every robot state published, with the path last copied into
+  // it.
+  messages::RobotState robot_state;
+  std::shared_ptr<const std::vector<messages::Location>> published_path;
+
+  /// Set when requests are pushed to us by DDS listeners, in which case the
+  /// update timer no longer needs to poll for them.
+  bool requests_event_driven = false;
+
   void read_requests();
   void handle_requests();
   void publish_robot_state();
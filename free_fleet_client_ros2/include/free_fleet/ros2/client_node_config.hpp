@@ -46,15 +46,33 @@ struct ClientNodeConfig
   std::string docking_trigger_server_name = "";
 
   int dds_domain = 42;
+  bool dds_shared_memory = false;
+  bool dds_bounded_robot_state = false;
+  bool dds_compact_path = false;
   std::string dds_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_request_ack_topic = "request_ack";
+
+  // names are only sent as ids when this is set, to a topic of its own for
+  // every server on the same DDS domain
+  std::string dds_name_id_topic = "";
 
   double wait_timeout = 10.0;
   double update_frequency = 10.0;
   double publish_frequency = 1.0;
 
+  // Publish robot states adaptively, checking the state of the robot at
+  // max_publish_frequency and only sending it once the robot moved, turned
+  // or its battery changed further than the thresholds, or its mode, task or
+  // path changed. Unchanged states are still sent at publish_frequency.
+  bool adaptive_publishing = false;
+  double max_publish_frequency = 10.0;
+  double publish_position_threshold = 0.1;
+  double publish_yaw_threshold = 0.1;
+  double publish_battery_threshold = 1.0;
+
   double max_dist_to_first_waypoint = 10.0;
 
   void print_config() const;
@@ -18,6 +18,12 @@
 #ifndef FREE_FLEET__ROS2__UTILITIES_HPP
 #define FREE_FLEET__ROS2__UTILITIES_HPP
 
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include <rclcpp/time.hpp>
+#include <rclcpp/duration.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 
 namespace free_fleet
@@ -34,6 +40,119 @@ bool is_pose_close(
     const geometry_msgs::msg::PoseStamped& pose_1,
     const geometry_msgs::msg::PoseStamped& pose_2);
 
+/// Pose of the robot in the map frame, stamped with the time it was at.
+struct RobotPose
+{
+  int32_t sec = 0;
+  uint32_t nanosec = 0;
+  double x = 0.0;
+  double y = 0.0;
+  double yaw = 0.0;
+};
+
+RobotPose to_robot_pose(const geometry_msgs::msg::PoseStamped& pose_stamped);
+
+bool is_pose_close(const RobotPose& pose_1, const RobotPose& pose_2);
+
+/// Latest pose of the robot and the one looked up before it, handed over
+/// from the thread looking them up to any number of readers behind a
+/// sequence lock. Readers never wait for a lookup in progress, however long
+/// the transform takes to arrive, they get the last pose that was found.
+class LatestRobotPose
+{
+public:
+
+  /// Stores a newly looked up pose, keeping the one before it. Only ever
+  /// called from a single thread.
+  void store(const RobotPose& pose);
+
+  /// Loads the latest pose and the one before it, as stored together.
+  void load(RobotPose& current, RobotPose& previous) const;
+
+  /// Loads the latest pose.
+  RobotPose load() const;
+
+private:
+
+  struct Fields
+  {
+    std::atomic<int32_t> sec{0};
+    std::atomic<uint32_t> nanosec{0};
+    std::atomic<double> x{0.0};
+    std::atomic<double> y{0.0};
+    std::atomic<double> yaw{0.0};
+
+    void store(const RobotPose& pose);
+
+    RobotPose load() const;
+  };
+
+  std::atomic<uint32_t> sequence{0};
+
+  Fields current;
+
+  Fields previous;
+
+};
+
+/// Waypoints the robot reached ahead of time, waiting to be released once
+/// they are due. They are kept in a timer wheel with a slot for every tick,
+/// which the update timer of the client advances on the executor, so that
+/// no thread is started and no lock is held while waiting for them.
+/// Waypoints due more than a revolution away stay in their slot for the
+/// revolutions in between. Not thread safe.
+class WaypointScheduler
+{
+public:
+
+  /// Constructor
+  ///
+  /// \param[in] tick
+  ///   Time covered by every slot, being the period the wheel is advanced
+  ///   at.
+  /// \param[in] num_slots
+  ///   Number of slots of the wheel.
+  WaypointScheduler(const rclcpp::Duration& tick, std::size_t num_slots = 64);
+
+  /// Schedules a waypoint to be released at its due time, identified by the
+  /// generation of the goal it was reached with.
+  void schedule(
+      uint64_t goal_generation,
+      const rclcpp::Time& due_time,
+      const rclcpp::Time& now);
+
+  /// Advances the wheel up to now, appending the goal generations of the
+  /// waypoints that became due to due.
+  void advance(const rclcpp::Time& now, std::vector<uint64_t>& due);
+
+  /// Drops every waypoint waiting.
+  void clear();
+
+  /// Number of waypoints waiting.
+  std::size_t size() const;
+
+private:
+
+  struct Entry
+  {
+    uint64_t goal_generation;
+    int64_t due_ns;
+  };
+
+  int64_t tick_ns;
+
+  std::vector<std::vector<Entry>> slots;
+
+  /// Last tick whose slot was visited.
+  int64_t last_tick = 0;
+
+  std::size_t num_waiting = 0;
+
+  /// Moves the wheel on to now while no waypoint is waiting.
+  void skip_to(int64_t now_tick);
+
+};
+
 } // namespace ros2
 } // namespace free_fleet
 
@@ -15,7 +15,9 @@
  *
  */
 
+#include <chrono>
 #include <iostream>
+#include <algorithm>
 #include <exception>
 #include <thread>
 
@@ -52,14 +54,27 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
   declare_parameter("nav2_server_name", client_node_config.move_base_server_name);
   declare_parameter("docking_trigger_server_name", client_node_config.docking_trigger_server_name);
   declare_parameter("dds_domain", client_node_config.dds_domain);
+  declare_parameter("dds_shared_memory", client_node_config.dds_shared_memory);
+  declare_parameter(
+      "dds_bounded_robot_state", client_node_config.dds_bounded_robot_state);
+  declare_parameter("dds_compact_path", client_node_config.dds_compact_path);
   declare_parameter("dds_mode_request_topic", client_node_config.dds_mode_request_topic);
   declare_parameter("dds_path_request_topic", client_node_config.dds_path_request_topic);
   declare_parameter(
     "dds_destination_request_topic",
     client_node_config.dds_destination_request_topic);
+  declare_parameter("dds_request_ack_topic", client_node_config.dds_request_ack_topic);
+  declare_parameter("dds_name_id_topic", client_node_config.dds_name_id_topic);
   declare_parameter("wait_timeout", client_node_config.wait_timeout);
   declare_parameter("update_frequency", client_node_config.update_frequency);
   declare_parameter("publish_frequency", client_node_config.publish_frequency);
+  declare_parameter("adaptive_publishing", client_node_config.adaptive_publishing);
+  declare_parameter("max_publish_frequency", client_node_config.max_publish_frequency);
+  declare_parameter(
+    "publish_position_threshold", client_node_config.publish_position_threshold);
+  declare_parameter("publish_yaw_threshold", client_node_config.publish_yaw_threshold);
+  declare_parameter(
+    "publish_battery_threshold", client_node_config.publish_battery_threshold);
   declare_parameter("max_dist_to_first_waypoint", client_node_config.max_dist_to_first_waypoint);
 
   // getting new values for parameters or keep defaults
@@ -73,84 +88,129 @@ ClientNode::ClientNode(const rclcpp::NodeOptions & options)
   get_parameter("nav2_server_name", client_node_config.move_base_server_name);
   get_parameter("docking_trigger_server_name", client_node_config.docking_trigger_server_name);
   get_parameter("dds_domain", client_node_config.dds_domain);
+  get_parameter("dds_shared_memory", client_node_config.dds_shared_memory);
+  get_parameter(
+      "dds_bounded_robot_state", client_node_config.dds_bounded_robot_state);
+  get_parameter("dds_compact_path", client_node_config.dds_compact_path);
   get_parameter("dds_mode_request_topic", client_node_config.dds_mode_request_topic);
   get_parameter("dds_path_request_topic", client_node_config.dds_path_request_topic);
   get_parameter(
     "dds_destination_request_topic",
     client_node_config.dds_destination_request_topic);
+  get_parameter("dds_request_ack_topic", client_node_config.dds_request_ack_topic);
+  get_parameter("dds_name_id_topic", client_node_config.dds_name_id_topic);
   get_parameter("wait_timeout", client_node_config.wait_timeout);
   get_parameter("update_frequency", client_node_config.update_frequency);
   get_parameter("publish_frequency", client_node_config.publish_frequency);
+  get_parameter("adaptive_publishing", client_node_config.adaptive_publishing);
+  get_parameter("max_publish_frequency", client_node_config.max_publish_frequency);
+  get_parameter(
+    "publish_position_threshold", client_node_config.publish_position_threshold);
+  get_parameter("publish_yaw_threshold", client_node_config.publish_yaw_threshold);
+  get_parameter(
+    "publish_battery_threshold", client_node_config.publish_battery_threshold);
   get_parameter("max_dist_to_first_waypoint", client_node_config.max_dist_to_first_waypoint);
   print_config();
 
+  /// Setting up the navigation2 action client and the docking server client,
+  /// if required. Their servers are discovered in the background while the
+  /// free fleet client is created, and waited for once the node is running.
+  rclcpp_action::Client<NavigateToPose>::SharedPtr move_base_client =
+    rclcpp_action::create_client<NavigateToPose>(this, client_node_config.move_base_server_name);
+
+  rclcpp::Client<std_srvs::srv::Trigger>::SharedPtr docking_trigger_client = nullptr;
+  if (client_node_config.docking_trigger_server_name != "") {
+    docking_trigger_client = create_client<std_srvs::srv::Trigger>(
+      client_node_config.docking_trigger_server_name);
+  }
+
+  /// Starting the free fleet client
   ClientConfig client_config = client_node_config.get_client_config();
   Client::SharedPtr client = Client::make(client_config);
   if (!client) {
     throw std::runtime_error("Unable to create free_fleet Client from config.");
   }
 
-  /// Setting up the navigation2 action client, wait for server
+  tf2_buffer = std::make_shared<tf2_ros::Buffer>(get_clock());
+  auto timer_interface =
+    std::make_shared<tf2_ros::CreateTimerROS>(
+    get_node_base_interface(), get_node_timers_interface());
+  tf2_buffer->setCreateTimerInterface(timer_interface);
+  tf2_buffer->setUsingDedicatedThread(true);
+  tf2_listener = std::make_shared<tf2_ros::TransformListener>(*tf2_buffer);
+
+  start(
+    Fields{
+        std::move(client),
+        std::move(move_base_client),
+        std::move(docking_trigger_client)
+      });
+
+  navigation_thread = std::thread(std::bind(&ClientNode::wait_for_navigation, this));
+}
+
+ClientNode::~ClientNode()
+{
+  looking_up_pose = false;
+  if (pose_thread.joinable()) {
+    pose_thread.join();
+  }
+
+  if (navigation_thread.joinable()) {
+    navigation_thread.join();
+  }
+}
+
+void ClientNode::wait_for_navigation()
+{
   RCLCPP_INFO(
     get_logger(), "waiting for connection with navigation action server: %s",
     client_node_config.move_base_server_name.c_str());
-  rclcpp_action::Client<NavigateToPose>::SharedPtr move_base_client =
-    rclcpp_action::create_client<NavigateToPose>(this, client_node_config.move_base_server_name);
-  while (!move_base_client->wait_for_action_server(std::chrono::duration<double>(client_node_config.wait_timeout))) {
+  while (!fields.move_base_client->wait_for_action_server(
+      std::chrono::duration<double>(client_node_config.wait_timeout)))
+  {
     RCLCPP_ERROR(
       get_logger(), "timed out waiting for action server: %s",
       client_node_config.move_base_server_name.c_str());
-    if (!rclcpp::ok())
-      throw std::runtime_error("exited rclcpp while constructing client_node");
+    if (!rclcpp::ok()) {
+      return;
+    }
   }
   RCLCPP_INFO(
     get_logger(), "connected with move base action server: %s",
     client_node_config.move_base_server_name.c_str());
 
-  /// Setting up the docking server client, if required, wait for server
-  rclcpp::Client<std_srvs::srv::Trigger>::SharedPtr docking_trigger_client = nullptr;
-  if (client_node_config.docking_trigger_server_name != "") {
-    docking_trigger_client = create_client<std_srvs::srv::Trigger>(
-      client_node_config.docking_trigger_server_name);
+  if (fields.docking_trigger_client) {
     RCLCPP_INFO(
       get_logger(), "waiting for connection with trigger server: %s",
       client_node_config.docking_trigger_server_name.c_str());
-    while (!docking_trigger_client->wait_for_service(
+    while (!fields.docking_trigger_client->wait_for_service(
         std::chrono::duration<double>(client_node_config.wait_timeout)))
     {
       RCLCPP_ERROR(
         get_logger(), "timed out waiting for docking trigger server: %s",
         client_node_config.docking_trigger_server_name.c_str());
       if (!rclcpp::ok()) {
-        throw std::runtime_error("exited rclcpp while constructing client_node");
+        return;
       }
     }
   }
 
-  tf2_buffer = std::make_shared<tf2_ros::Buffer>(get_clock());
-  auto timer_interface =
-    std::make_shared<tf2_ros::CreateTimerROS>(
-    get_node_base_interface(), get_node_timers_interface());
-  tf2_buffer->setCreateTimerInterface(timer_interface);
-  tf2_buffer->setUsingDedicatedThread(true);
-  tf2_listener = std::make_shared<tf2_ros::TransformListener>(*tf2_buffer);
-
-  start(
-    Fields{
-        std::move(client),
-        std::move(move_base_client),
-        std::move(docking_trigger_client)
-      });
-}
-
-ClientNode::~ClientNode()
-{
+  navigation_ready = true;
 }
 
 void ClientNode::start(Fields _fields)
 {
   fields = std::move(_fields);
 
+  // Advanced by the update timer, a slot for every update.
+  std::chrono::duration<double> update_period =
+    std::chrono::duration<double>(1.0 / client_node_config.update_frequency);
+  waypoint_scheduler.reset(
+    new WaypointScheduler(
+      rclcpp::Duration(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(update_period))));
+
   battery_percent_sub = create_subscription<sensor_msgs::msg::BatteryState>(
     client_node_config.battery_state_topic, rclcpp::SensorDataQoS().keep_last(1),
     std::bind(&ClientNode::battery_state_callback_fn, this, std::placeholders::_1));
@@ -159,15 +219,51 @@ void ClientNode::start(Fields _fields)
   emergency = false;
   paused = false;
 
+  // Have requests handled as soon as they arrive over DDS, instead of waiting
+  // for the next update to poll for them.
+  requests_event_driven =
+    fields.client->set_mode_request_callback(
+      [this](const std::vector<messages::ModeRequest>& _mode_requests)
+      {
+        handle_mode_requests(_mode_requests);
+      }) &&
+    fields.client->set_path_request_callback(
+      [this](const std::vector<messages::PathRequest>& _path_requests)
+      {
+        handle_path_requests(_path_requests);
+      }) &&
+    fields.client->set_destination_request_callback(
+      [this](
+        const std::vector<messages::DestinationRequest>& _destination_requests)
+      {
+        handle_destination_requests(_destination_requests);
+      });
+  if (!requests_event_driven) {
+    RCLCPP_WARN(
+      get_logger(), "unable to listen for requests, polling at %.1f Hz instead.",
+      client_node_config.update_frequency);
+  }
+
+  RCLCPP_INFO(get_logger(), "starting pose thread.");
+  looking_up_pose = true;
+  pose_thread = std::thread(std::bind(&ClientNode::pose_thread_fn, this));
+
   RCLCPP_INFO(get_logger(), "starting update timer.");
-  std::chrono::duration<double> update_period =
-    std::chrono::duration<double>(1.0 / client_node_config.update_frequency);
   update_timer = create_wall_timer(update_period, std::bind(&ClientNode::update_fn, this));
 
+  // When publishing adaptively, the state is checked at the highest rate it
+  // may be sent at, and the free fleet client skips the unchanged ones.
   RCLCPP_INFO(get_logger(), "starting publish timer.");
   std::chrono::duration<double> publish_period =
-    std::chrono::duration<double>(1.0 / client_node_config.publish_frequency);
+    std::chrono::duration<double>(
+    1.0 / (client_node_config.adaptive_publishing ?
+    client_node_config.max_publish_frequency :
+    client_node_config.publish_frequency));
   publish_timer = create_wall_timer(publish_period, std::bind(&ClientNode::publish_fn, this));
+
+  // The first state is sent right away, for the server to know of the robot
+  // while it is still starting up.
+  publish_robot_state();
 }
 
 void ClientNode::print_config()
@@ -178,8 +274,12 @@ void ClientNode::print_config()
 void ClientNode::battery_state_callback_fn(
   const sensor_msgs::msg::BatteryState::SharedPtr _msg)
 {
-  WriteLock battery_state_lock(battery_state_mutex);
-  current_battery_state = *_msg;
+  /// RMF expects battery to have a percentage in the range for 0-100.
+  /// sensor_msgs/BatteryInfo on the other hand returns a value in
+  /// the range of 0-1
+  battery_percent = 100 * _msg->percentage;
+  charging =
+    _msg->power_supply_status == _msg->POWER_SUPPLY_STATUS_CHARGING;
 }
 
 bool ClientNode::get_robot_pose()
@@ -190,9 +290,7 @@ bool ClientNode::get_robot_pose()
       client_node_config.map_frame,
       client_node_config.robot_frame,
       client_node_config.wait_timeout)) {
-    WriteLock robot_transform_lock(robot_pose_mutex);
-    previous_robot_pose = current_robot_pose;
-    current_robot_pose = tmp_pose_stamped;
+    latest_robot_pose.store(to_robot_pose(tmp_pose_stamped));
     return true;
   } else {
     RCLCPP_WARN(get_logger(), "Unable to get robot pose.");
@@ -212,20 +310,21 @@ messages::RobotMode ClientNode::get_robot_mode()
     return messages::RobotMode{messages::RobotMode::MODE_EMERGENCY};
   }
 
-  /// Checks if robot is charging
-  {
-    ReadLock battery_state_lock(battery_state_mutex);
+  /// Checks if the navigation stack is still starting up
+  if (!navigation_ready) {
+    return messages::RobotMode{messages::RobotMode::MODE_WAITING};
+  }
 
-    if (current_battery_state.power_supply_status ==
-      current_battery_state.POWER_SUPPLY_STATUS_CHARGING)
-    {
-      return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
-    }
+  /// Checks if robot is charging
+  if (charging) {
+    return messages::RobotMode{messages::RobotMode::MODE_CHARGING};
   }
 
   /// Checks if robot is moving
   {
-    ReadLock robot_transform_lock(robot_pose_mutex);
+    RobotPose current_robot_pose;
+    RobotPose previous_robot_pose;
+    latest_robot_pose.load(current_robot_pose, previous_robot_pose);
 
     if (!is_pose_close(
         current_robot_pose, previous_robot_pose))
@@ -245,77 +344,209 @@ messages::RobotMode ClientNode::get_robot_mode()
   return messages::RobotMode{messages::RobotMode::MODE_IDLE};
 }
 
-void ClientNode::publish_robot_state()
+void ClientNode::set_current_task_id(const std::string & _task_id)
 {
-  messages::RobotState new_robot_state;
-  new_robot_state.name = client_node_config.robot_name;
-  new_robot_state.model = client_node_config.robot_model;
-
   {
-    ReadLock task_id_lock(task_id_mutex);
-    new_robot_state.task_id = current_task_id;
+    WriteLock task_id_lock(task_id_mutex);
+    current_task_id = _task_id;
   }
 
-  new_robot_state.mode = get_robot_mode();
+  std::unique_lock<std::mutex> state_snapshot_lock(state_snapshot_mutex);
+  auto snapshot = std::make_shared<StateSnapshot>(*state_snapshot);
+  snapshot->task_id = _task_id;
+  std::atomic_store(
+    &state_snapshot, std::shared_ptr<const StateSnapshot>(std::move(snapshot)));
+}
 
+void ClientNode::update_path_snapshot()
+{
+  auto path = std::make_shared<std::vector<messages::Location>>();
+  path->reserve(goal_path.size());
+  for (const Goal & goal : goal_path)
   {
-    ReadLock battery_state_lock(battery_state_mutex);
-    /// RMF expects battery to have a percentage in the range for 0-100.
-    /// sensor_msgs/BatteryInfo on the other hand returns a value in
-    /// the range of 0-1
-    new_robot_state.battery_percent = 100 * current_battery_state.percentage;
+    path->push_back(
+        messages::Location{
+            (int32_t)goal.goal.pose.header.stamp.sec,
+            goal.goal.pose.header.stamp.nanosec,
+            (float)goal.goal.pose.pose.position.x,
+            (float)goal.goal.pose.pose.position.y,
+            (float)get_yaw_from_pose(goal.goal.pose),
+            goal.level_name
+        });
   }
 
-  {
-    ReadLock robot_transform_lock(robot_pose_mutex);
-    new_robot_state.location.sec = current_robot_pose.header.stamp.sec;
-    new_robot_state.location.nanosec =
-      current_robot_pose.header.stamp.nanosec;
-    new_robot_state.location.x =
-      current_robot_pose.pose.position.x;
-    new_robot_state.location.y =
-      current_robot_pose.pose.position.y;
-    new_robot_state.location.yaw = get_yaw_from_pose(current_robot_pose);
-    new_robot_state.location.level_name = client_node_config.level_name;
-  }
-
-  new_robot_state.path.clear();
-  {
-    ReadLock goal_path_lock(goal_path_mutex);
-    for (size_t i = 0; i < goal_path.size(); ++i)
-    {
-      new_robot_state.path.push_back(
-          messages::Location{
-              (int32_t)goal_path[i].goal.pose.header.stamp.sec,
-              goal_path[i].goal.pose.header.stamp.nanosec,
-              (float)goal_path[i].goal.pose.pose.position.x,
-              (float)goal_path[i].goal.pose.pose.position.y,
-              (float)get_yaw_from_pose(goal_path[i].goal.pose),
-              goal_path[i].level_name
-          });
+  std::unique_lock<std::mutex> state_snapshot_lock(state_snapshot_mutex);
+  auto snapshot = std::make_shared<StateSnapshot>(*state_snapshot);
+  snapshot->path = std::move(path);
+  std::atomic_store(
+    &state_snapshot, std::shared_ptr<const StateSnapshot>(std::move(snapshot)));
+}
+
+void ClientNode::goal_path_changed()
+{
+  ++goal_generation;
+  waypoint_scheduler->clear();
+  update_path_snapshot();
+}
+
+void ClientNode::release_waypoints()
+{
+  WriteLock goal_path_lock(goal_path_mutex);
+  if (waypoint_scheduler->size() == 0) {
+    return;
+  }
+
+  released_generations.clear();
+  waypoint_scheduler->advance(now(), released_generations);
+  for (const uint64_t generation : released_generations) {
+    // The robot is still waiting at the front waypoint, unless the path
+    // changed since it got there.
+    if (generation == goal_generation && !goal_path.empty()) {
+      goal_path.pop_front();
+      goal_path_changed();
     }
   }
+}
+
+void ClientNode::publish_robot_state()
+{
+  // The task id and path are read from the latest snapshot, which only waits
+  // for a snapshot pointer being copied, and everything else from atomics.
+  const std::shared_ptr<const StateSnapshot> snapshot =
+    std::atomic_load(&state_snapshot);
+
+  robot_state.name = client_node_config.robot_name;
+  robot_state.model = client_node_config.robot_model;
+  robot_state.task_id = snapshot->task_id;
+  robot_state.mode = get_robot_mode();
+  robot_state.battery_percent = battery_percent;
+
+  {
+    const RobotPose current_robot_pose = latest_robot_pose.load();
+    robot_state.location.sec = current_robot_pose.sec;
+    robot_state.location.nanosec = current_robot_pose.nanosec;
+    robot_state.location.x = current_robot_pose.x;
+    robot_state.location.y = current_robot_pose.y;
+    robot_state.location.yaw = current_robot_pose.yaw;
+    robot_state.location.level_name = client_node_config.level_name;
+  }
 
-  if (!fields.client->send_robot_state(new_robot_state)) {
+  // The path is only copied again once it has changed.
+  if (snapshot->path != published_path) {
+    robot_state.path = *snapshot->path;
+    published_path = snapshot->path;
+  }
+
+  if (!fields.client->send_robot_state(robot_state)) {
     RCLCPP_WARN(
       get_logger(), "failed to send robot state: msg sec %u",
-      new_robot_state.location.sec);
+      robot_state.location.sec);
   }
 }
 
 bool ClientNode::is_valid_request(
   const std::string & _request_fleet_name,
+  uint32_t _request_fleet_id,
   const std::string & _request_robot_name,
-  const std::string & _request_task_id)
+  uint32_t _request_robot_id,
+  const std::string & _request_task_id,
+  uint32_t _request_type)
 {
   ReadLock task_id_lock(task_id_mutex);
   if (current_task_id == _request_task_id ||
-    client_node_config.robot_name != _request_robot_name ||
-    client_node_config.fleet_name != _request_fleet_name)
+    find_request_ack(_request_task_id, _request_type))
+  {
+    return false;
+  }
+  return is_for_this_robot(
+    _request_fleet_name, _request_fleet_id,
+    _request_robot_name, _request_robot_id);
+}
+
+bool ClientNode::is_for_this_robot(
+  const std::string & _request_fleet_name,
+  uint32_t _request_fleet_id,
+  const std::string & _request_robot_name,
+  uint32_t _request_robot_id)
+{
+  // The own ids are looked up again whenever the server gives out ids of a
+  // new generation, the names are compared by id from then on.
+  if (messages::get_name_id_generation(_request_robot_id) !=
+    messages::get_name_id_generation(robot_name_id))
+  {
+    fleet_name_id = fields.client->get_name_id(client_node_config.fleet_name);
+    robot_name_id = fields.client->get_name_id(client_node_config.robot_name);
+  }
+  if (!messages::is_same_name(
+      robot_name_id, client_node_config.robot_name,
+      _request_robot_id, _request_robot_name))
   {
     return false;
   }
-  return true;
+  return messages::is_same_name(
+    fleet_name_id, client_node_config.fleet_name,
+    _request_fleet_id, _request_fleet_name);
+}
+
+void ClientNode::send_request_ack(
+  const std::string & _request_fleet_name,
+  const std::string & _request_robot_name,
+  const std::string & _request_task_id,
+  uint32_t _request_type,
+  bool _accepted,
+  const std::string & _reason)
+{
+  messages::RequestAck request_ack;
+  request_ack.fleet_name = _request_fleet_name;
+  request_ack.robot_name = _request_robot_name;
+  request_ack.task_id = _request_task_id;
+  request_ack.request_type = _request_type;
+  request_ack.accepted = _accepted;
+  request_ack.reason = _reason;
+  {
+    WriteLock task_id_lock(task_id_mutex);
+    request_acks.push_back(request_ack);
+    if (request_acks.size() > max_request_acks) {
+      request_acks.pop_front();
+    }
+  }
+  fields.client->send_request_ack(request_ack);
+}
+
+void ClientNode::repeat_request_ack(
+  const std::string & _request_fleet_name,
+  const std::string & _request_robot_name,
+  const std::string & _request_task_id,
+  uint32_t _request_type)
+{
+  messages::RequestAck request_ack;
+  {
+    ReadLock task_id_lock(task_id_mutex);
+    const messages::RequestAck * handled_ack =
+      find_request_ack(_request_task_id, _request_type);
+    if (!handled_ack ||
+      handled_ack->robot_name != _request_robot_name ||
+      handled_ack->fleet_name != _request_fleet_name)
+    {
+      return;
+    }
+    request_ack = *handled_ack;
+  }
+  fields.client->send_request_ack(request_ack);
+}
+
+const messages::RequestAck * ClientNode::find_request_ack(
+  const std::string & _request_task_id,
+  uint32_t _request_type) const
+{
+  for (auto it = request_acks.rbegin(); it != request_acks.rend(); ++it) {
+    if (it->task_id == _request_task_id &&
+      it->request_type == _request_type)
+    {
+      return &(*it);
+    }
+  }
+  return nullptr;
 }
 
 
@@ -333,26 +564,88 @@ nav2_msgs::action::NavigateToPose::Goal ClientNode::location_to_nav_goal(
   return goal;
 }
 
+template<typename Request>
+const Request * ClientNode::find_newest_request(
+  const std::vector<Request> & _requests)
+{
+  for (auto it = _requests.rbegin(); it != _requests.rend(); ++it) {
+    if (is_for_this_robot(
+        it->fleet_name, it->fleet_id, it->robot_name, it->robot_id))
+    {
+      return &(*it);
+    }
+  }
+  return nullptr;
+}
+
+template<typename Request>
+void ClientNode::reject_superseded_requests(
+  const std::vector<Request> & _requests,
+  const Request & _newest_request,
+  uint32_t _request_type)
+{
+  for (const Request & request : _requests) {
+    if (&request == &_newest_request ||
+      request.task_id == _newest_request.task_id ||
+      !is_valid_request(
+        request.fleet_name, request.fleet_id,
+        request.robot_name, request.robot_id,
+        request.task_id, _request_type))
+    {
+      continue;
+    }
+    send_request_ack(
+      request.fleet_name, request.robot_name, request.task_id,
+      _request_type, false, "superseded by a newer request");
+  }
+}
+
 bool ClientNode::read_mode_request()
 {
-  messages::ModeRequest mode_request;
-  if (fields.client->read_mode_request(mode_request) &&
-      is_valid_request(
-          mode_request.fleet_name, mode_request.robot_name,
-          mode_request.task_id))
+  fields.client->read_mode_requests(mode_requests);
+  return handle_mode_requests(mode_requests);
+}
+
+bool ClientNode::handle_mode_requests(
+  const std::vector<messages::ModeRequest> & _mode_requests)
+{
+  const messages::ModeRequest * mode_request =
+    find_newest_request(_mode_requests);
+  if (!mode_request)
+    return false;
+  reject_superseded_requests(
+    _mode_requests, *mode_request, messages::RequestAck::REQUEST_MODE);
+  return process_mode_request(*mode_request);
+}
+
+void ClientNode::stop_navigation()
+{
+  // The flags are set before, and handle_requests checks them again while
+  // holding goal_path_mutex, so a goal is either sent before this cancels
+  // it, or not sent at all.
+  WriteLock goal_path_lock(goal_path_mutex);
+  fields.move_base_client->async_cancel_all_goals();
+  if (!goal_path.empty())
+    goal_path[0].sent = false;
+}
+
+bool ClientNode::process_mode_request(
+  const messages::ModeRequest& mode_request)
+{
+  if (is_valid_request(
+          mode_request.fleet_name, mode_request.fleet_id,
+          mode_request.robot_name, mode_request.robot_id,
+          mode_request.task_id, messages::RequestAck::REQUEST_MODE))
   {
+    bool accepted = true;
     if (mode_request.mode.mode == messages::RobotMode::MODE_PAUSED)
     {
-      RCLCPP_INFO(get_logger(), "received a PAUSE command.");
-
-      fields.move_base_client->async_cancel_all_goals();
-      WriteLock goal_path_lock(goal_path_mutex);
-      if (!goal_path.empty())
-        goal_path[0].sent = false;
-
       paused = true;
       emergency = false;
       request_error = false;
+      stop_navigation();
+
+      RCLCPP_INFO(get_logger(), "received a PAUSE command.");
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_MOVING)
     {
@@ -363,10 +656,12 @@ bool ClientNode::read_mode_request()
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_EMERGENCY)
     {
-      RCLCPP_INFO(get_logger(), "received an EMERGENCY command.");
       paused = false;
       emergency = true;
       request_error = false;
+      stop_navigation();
+
+      RCLCPP_INFO(get_logger(), "received an EMERGENCY command.");
     }
     else if (mode_request.mode.mode == messages::RobotMode::MODE_DOCKING)
     {
@@ -396,47 +691,71 @@ bool ClientNode::read_mode_request()
       RCLCPP_ERROR(get_logger(), "received an INVALID/UNSUPPORTED command: %d.",
               mode_request.mode.mode);
       request_error = true;
+      accepted = false;
     }
 
-    WriteLock task_id_lock(task_id_mutex);
-    current_task_id = mode_request.task_id;
+    set_current_task_id(mode_request.task_id);
 
+    send_request_ack(
+        mode_request.fleet_name, mode_request.robot_name,
+        mode_request.task_id, messages::RequestAck::REQUEST_MODE, accepted,
+        accepted ? "" : "unsupported mode");
     return true;
   }
+  repeat_request_ack(
+      mode_request.fleet_name, mode_request.robot_name,
+      mode_request.task_id, messages::RequestAck::REQUEST_MODE);
   return false;
 }
 
 bool ClientNode::read_path_request()
 {
-  
-  messages::PathRequest path_request;
-  //RCLCPP_INFO(get_logger(), "HERE"); 
-  //RCLCPP_INFO(get_logger(), "read_path_request: %d",fields.client->read_path_request(path_request)); 
+  fields.client->read_path_requests(path_requests);
+  return handle_path_requests(path_requests);
+}
+
+bool ClientNode::handle_path_requests(
+  const std::vector<messages::PathRequest> & _path_requests)
+{
+  const messages::PathRequest * path_request =
+    find_newest_request(_path_requests);
+  if (!path_request)
+    return false;
+  reject_superseded_requests(
+    _path_requests, *path_request, messages::RequestAck::REQUEST_PATH);
+  return process_path_request(*path_request);
+}
+
+bool ClientNode::process_path_request(
+  const messages::PathRequest& path_request)
+{
   //RCLCPP_INFO(get_logger(), "is_valid_request: %d",is_valid_request(path_request.fleet_name, path_request.robot_name,path_request.task_id));
   //RCLCPP_INFO(get_logger(), "fleet_name: %s", path_request.fleet_name.c_str());
   //RCLCPP_INFO(get_logger(), "robot_name: %s", path_request.robot_name.c_str());
   //RCLCPP_INFO(get_logger(), "task_id: %s", path_request.task_id.c_str());
-  if (fields.client->read_path_request(path_request) &&
-      is_valid_request(
-          path_request.fleet_name, path_request.robot_name,
-          path_request.task_id))
+  if (is_valid_request(
+          path_request.fleet_name, path_request.fleet_id,
+          path_request.robot_name, path_request.robot_id,
+          path_request.task_id, messages::RequestAck::REQUEST_PATH))
   {
     //RCLCPP_INFO(get_logger(), "HERE"); 
     RCLCPP_INFO(get_logger(), "received a Path command of size %lu.", path_request.path.size());
 
     if (path_request.path.size() <= 0)
+    {
+      send_request_ack(
+          path_request.fleet_name, path_request.robot_name,
+          path_request.task_id, messages::RequestAck::REQUEST_PATH, false,
+          "empty path");
       return false;
+    }
 
     // Sanity check: the first waypoint of the Path must be within N meters of
     // our current position. Otherwise, ignore the request.
     {
-      ReadLock robot_transform_lock(robot_pose_mutex);
-      const double dx =
-          path_request.path[0].x -
-          current_robot_pose.pose.position.x;
-      const double dy =
-          path_request.path[0].y -
-          current_robot_pose.pose.position.y;
+      const RobotPose current_robot_pose = latest_robot_pose.load();
+      const double dx = path_request.path[0].x - current_robot_pose.x;
+      const double dy = path_request.path[0].y - current_robot_pose.y;
       const double dist_to_first_waypoint = sqrt(dx*dx + dy*dy);
 
       RCLCPP_INFO(get_logger(), "distance to first waypoint: %.2f\n", dist_to_first_waypoint);
@@ -452,11 +771,16 @@ bool ClientNode::read_path_request()
         {
           WriteLock goal_path_lock(goal_path_mutex);
           goal_path.clear();
+          goal_path_changed();
         }
 
         request_error = true;
         emergency = false;
         paused = false;
+        send_request_ack(
+            path_request.fleet_name, path_request.robot_name,
+            path_request.task_id, messages::RequestAck::REQUEST_PATH, false,
+            "first waypoint too far away");
         return false;
       }
     }
@@ -465,10 +789,7 @@ bool ClientNode::read_path_request()
     // TODO(AA): Use a scoped lock for these mutexes, and rework the time
     // remaining wait logic. We are currently relying on the task to be updated
     // to indicate that the client does not need to wait anymore.
-    {
-      WriteLock task_id_lock(task_id_mutex);
-      current_task_id = path_request.task_id;
-    }
+    set_current_task_id(path_request.task_id);
     {
       WriteLock goal_path_lock(goal_path_mutex);
       goal_path.clear();
@@ -486,24 +807,50 @@ bool ClientNode::read_path_request()
                     path_request.path[i].nanosec,
                     RCL_ROS_TIME)}); // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
       }
+      goal_path_changed();
     }
 
     if (paused)
       paused = false;
 
     request_error = false;
+    send_request_ack(
+        path_request.fleet_name, path_request.robot_name,
+        path_request.task_id, messages::RequestAck::REQUEST_PATH, true);
     return true;
   }
+  repeat_request_ack(
+      path_request.fleet_name, path_request.robot_name,
+      path_request.task_id, messages::RequestAck::REQUEST_PATH);
   return false;
 }
 
 bool ClientNode::read_destination_request()
 {
-  messages::DestinationRequest destination_request;
-  if (fields.client->read_destination_request(destination_request) &&
-      is_valid_request(
-          destination_request.fleet_name, destination_request.robot_name,
-          destination_request.task_id))
+  fields.client->read_destination_requests(destination_requests);
+  return handle_destination_requests(destination_requests);
+}
+
+bool ClientNode::handle_destination_requests(
+  const std::vector<messages::DestinationRequest> & _destination_requests)
+{
+  const messages::DestinationRequest * destination_request =
+    find_newest_request(_destination_requests);
+  if (!destination_request)
+    return false;
+  reject_superseded_requests(
+    _destination_requests, *destination_request,
+    messages::RequestAck::REQUEST_DESTINATION);
+  return process_destination_request(*destination_request);
+}
+
+bool ClientNode::process_destination_request(
+  const messages::DestinationRequest& destination_request)
+{
+  if (is_valid_request(
+          destination_request.fleet_name, destination_request.fleet_id,
+          destination_request.robot_name, destination_request.robot_id,
+          destination_request.task_id, messages::RequestAck::REQUEST_DESTINATION))
   {
     RCLCPP_INFO(get_logger(), "received a Destination command, x: %.2f, y: %.2f, yaw: %.2f",
         destination_request.destination.x, destination_request.destination.y,
@@ -523,19 +870,25 @@ bool ClientNode::read_destination_request()
                   destination_request.destination.sec,
                   destination_request.destination.nanosec,
                   RCL_ROS_TIME)}); // messages use RCL_ROS_TIME instead of default RCL_SYSTEM_TIME
+      goal_path_changed();
     }
 
-    {
-      WriteLock task_id_lock(task_id_mutex);
-      current_task_id = destination_request.task_id;
-    }
+    set_current_task_id(destination_request.task_id);
 
     if (paused)
       paused = false;
 
     request_error = false;
+    send_request_ack(
+        destination_request.fleet_name, destination_request.robot_name,
+        destination_request.task_id,
+        messages::RequestAck::REQUEST_DESTINATION, true);
     return true;
   }
+  repeat_request_ack(
+      destination_request.fleet_name, destination_request.robot_name,
+      destination_request.task_id,
+      messages::RequestAck::REQUEST_DESTINATION);
   return false;
 }
 
@@ -555,8 +908,14 @@ void ClientNode::handle_requests()
   if (emergency || request_error || paused)
     return;
 
-  // ooooh we have goals
+  // goals are kept until the navigation stack is up
+  if (!navigation_ready)
+    return;
+
+  // ooooh we have goals, unless the robot was stopped since the check above
   ReadLock goal_path_lock(goal_path_mutex);
+  if (emergency || request_error || paused)
+    return;
   if (!goal_path.empty())
   {
     auto send_goal_options = rclcpp_action::Client<NavigateToPose>::SendGoalOptions();
@@ -570,60 +929,36 @@ void ClientNode::handle_requests()
     send_goal_options.feedback_callback = [&](GoalHandleNavigateToPose::SharedPtr, const std::shared_ptr<const NavigateToPose::Feedback> feedback) {
       RCLCPP_INFO_THROTTLE(this->get_logger(), *get_clock(), 5000, "Distance remaining: %f", feedback->distance_remaining);
     };
-    send_goal_options.result_callback = [&](const GoalHandleNavigateToPose::WrappedResult & result) {
+    // Results of goals sent before goal_path changed are left alone, they
+    // were superseded by the goals of the new path.
+    const uint64_t generation = goal_generation;
+    send_goal_options.result_callback = [this, generation](const GoalHandleNavigateToPose::WrappedResult & result) {
       WriteLock goal_path_lock(goal_path_mutex);
+      if (generation != goal_generation || goal_path.empty()) {
+        return;
+      }
       switch (result.code) {
         case rclcpp_action::ResultCode::SUCCEEDED:
           RCLCPP_INFO(get_logger(), "current goal state: SUCCEEEDED.");
           // By some stroke of good fortune, we may have arrived at our goal
           // earlier than we were scheduled to reach it. If that is the case,
-          // we need to wait here until it's time to proceed.
-          if (now() >= goal_path.front().goal_end_time)
+          // we need to wait here until it's time to proceed, which the
+          // waypoint scheduler lets us know of.
           {
-            if (!goal_path.empty()) // TODO: fix race condition instead
+            const rclcpp::Time time_now = now();
+            if (time_now >= goal_path.front().goal_end_time)
+            {
               goal_path.pop_front();
-          }
-          else
-          {
-            std::thread{
-              [&]()
-              {
-                std::string goal_task_id;
-                {
-                  ReadLock task_id_lock(task_id_mutex);
-                  goal_task_id = current_task_id;
-                }
-
-                {
-                  ReadLock goal_path_lock(goal_path_mutex);
-                  while (now() < goal_path.front().goal_end_time)
-                  {
-                    {
-                      ReadLock task_id_lock(task_id_mutex);
-                      if (current_task_id != goal_task_id)
-                      {
-                        RCLCPP_INFO(get_logger(),
-                          "a new task has come in, moving on to new task.");
-                        return;
-                      }
-                    }
-
-                    rclcpp::Duration wait_time_remaining =
-                        goal_path.front().goal_end_time - now();
-                    RCLCPP_INFO(get_logger(),
-                        "we reached our goal early! Waiting %.2f more seconds",
-                        wait_time_remaining.seconds());
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
-                  }
-                }
-
-                std::scoped_lock goal_lock{task_id_mutex, goal_path_mutex};
-                if (!goal_path.empty() && current_task_id == goal_task_id)
-                {
-                  goal_path.pop_front();
-                }
-              }
-            }.detach();
+              goal_path_changed();
+            }
+            else
+            {
+              RCLCPP_INFO(get_logger(),
+                  "we reached our goal early! Waiting %.2f more seconds",
+                  (goal_path.front().goal_end_time - time_now).seconds());
+              waypoint_scheduler->schedule(
+                  generation, goal_path.front().goal_end_time, time_now);
+            }
           }
           return;
         case rclcpp_action::ResultCode::ABORTED:
@@ -647,6 +982,7 @@ void ClientNode::handle_requests()
                 "further requests.",
                 goal_path.front().aborted_count);
             goal_path.clear();
+            goal_path_changed();
             return;
           }
           return;
@@ -660,6 +996,7 @@ void ClientNode::handle_requests()
           RCLCPP_INFO(get_logger(), "Client will abort the current path request, and await further "
               "requests or manual intervention.");
           goal_path.clear();
+          goal_path_changed();
           return;
       }
     };
@@ -685,10 +1022,29 @@ void ClientNode::handle_requests()
   // otherwise, mode is correct, nothing in queue, nothing else to do then
 }
 
+void ClientNode::pose_thread_fn()
+{
+  std::chrono::duration<double> update_period =
+    std::chrono::duration<double>(1.0 / client_node_config.update_frequency);
+  auto next_update_time = std::chrono::steady_clock::now();
+  while (looking_up_pose && rclcpp::ok()) {
+    get_robot_pose();
+
+    // Lookups that took longer than a period are followed by the next right
+    // away, instead of trying to catch up on the ones missed.
+    next_update_time = std::max(
+      next_update_time + std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(update_period),
+      std::chrono::steady_clock::now());
+    std::this_thread::sleep_until(next_update_time);
+  }
+}
+
 void ClientNode::update_fn()
 {
-  get_robot_pose();
-  read_requests();
+  if (!requests_event_driven)
+    read_requests();
+  release_waypoints();
   handle_requests();
 }
 
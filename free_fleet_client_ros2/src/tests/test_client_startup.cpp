@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <condition_variable>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <nav2_msgs/action/navigate_to_pose.hpp>
+
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+#include <free_fleet/messages/RobotMode.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+
+#include "free_fleet/ros2/client_node.hpp"
+
+using NavigateToPose = nav2_msgs::action::NavigateToPose;
+using Clock = std::chrono::steady_clock;
+
+double get_seconds(Clock::time_point _start, Clock::time_point _end)
+{
+  return std::chrono::duration<double>(_end - _start).count();
+}
+
+/// Times of the robot states the server got from the client being started.
+struct StartupTimes
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::string robot_name;
+  bool got_first_state = false;
+  bool got_ready_state = false;
+  Clock::time_point first_state_time;
+  Clock::time_point ready_state_time;
+};
+
+int main(int argc, char** argv)
+{
+  // Starts client nodes whose navigation server only comes up after a delay,
+  // the way it does when a whole robot is restarted, and measures how long
+  // it takes the client to be constructed, to send its first robot state and
+  // to be ready once the navigation server is up. A client that waits for
+  // the navigation server before starting would send nothing for the whole
+  // delay.
+  rclcpp::init(argc, argv);
+  int num_runs = 5;
+  double navigation_delay = 2.0;
+  if (argc > 1)
+    num_runs = std::stoi(argv[1]);
+  if (argc > 2)
+    navigation_delay = std::stod(argv[2]);
+
+  free_fleet::ServerConfig server_config;
+  free_fleet::Server::SharedPtr server =
+      free_fleet::Server::make(server_config);
+  if (!server)
+  {
+    printf("=== FAILED: unable to create the server.\n");
+    return 1;
+  }
+
+  StartupTimes times;
+  server->set_robot_state_callback(
+      [&](const free_fleet::messages::RobotState& _robot_state)
+      {
+        std::unique_lock<std::mutex> lock(times.mutex);
+        if (_robot_state.name != times.robot_name)
+          return;
+
+        const Clock::time_point now = Clock::now();
+        if (!times.got_first_state)
+        {
+          times.got_first_state = true;
+          times.first_state_time = now;
+        }
+        if (!times.got_ready_state &&
+            _robot_state.mode.mode !=
+                free_fleet::messages::RobotMode::MODE_WAITING)
+        {
+          times.got_ready_state = true;
+          times.ready_state_time = now;
+        }
+        times.cv.notify_all();
+      });
+
+  bool passed = true;
+  printf("=== %d client starts, navigation server up after %.1fs\n",
+      num_runs, navigation_delay);
+  printf("  %4s %14s %14s %14s\n",
+      "run", "construct (s)", "first state (s)", "ready (s)");
+  for (int run = 0; run < num_runs && rclcpp::ok(); ++run)
+  {
+    const std::string robot_name = "startup_robot_" + std::to_string(run);
+    const std::string navigation_server_name =
+        "startup_navigate_to_pose_" + std::to_string(run);
+    {
+      std::unique_lock<std::mutex> lock(times.mutex);
+      times.robot_name = robot_name;
+      times.got_first_state = false;
+      times.got_ready_state = false;
+    }
+
+    const Clock::time_point start_time = Clock::now();
+    auto client_node = std::make_shared<free_fleet::ros2::ClientNode>(
+        rclcpp::NodeOptions().parameter_overrides({
+            {"fleet_name", "startup_fleet"},
+            {"robot_name", robot_name},
+            {"nav2_server_name", navigation_server_name},
+            {"publish_frequency", 10.0},
+            {"wait_timeout", 1.0}}));
+    const Clock::time_point constructed_time = Clock::now();
+
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(client_node);
+    std::thread spin_thread([&]() { executor.spin(); });
+
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(navigation_delay));
+    auto navigation_node = std::make_shared<rclcpp::Node>(
+        "startup_navigation_" + std::to_string(run));
+    auto navigation_server = rclcpp_action::create_server<NavigateToPose>(
+        navigation_node, navigation_server_name,
+        [](const rclcpp_action::GoalUUID&,
+            std::shared_ptr<const NavigateToPose::Goal>)
+        {
+          return rclcpp_action::GoalResponse::REJECT;
+        },
+        [](std::shared_ptr<rclcpp_action::ServerGoalHandle<NavigateToPose>>)
+        {
+          return rclcpp_action::CancelResponse::ACCEPT;
+        },
+        [](std::shared_ptr<rclcpp_action::ServerGoalHandle<NavigateToPose>>)
+        {});
+    const Clock::time_point navigation_time = Clock::now();
+    executor.add_node(navigation_node);
+
+    bool ready = false;
+    {
+      std::unique_lock<std::mutex> lock(times.mutex);
+      ready = times.cv.wait_for(lock, std::chrono::seconds(30),
+          [&]() { return times.got_ready_state; });
+    }
+
+    executor.cancel();
+    spin_thread.join();
+
+    if (!ready || !times.got_first_state)
+    {
+      // The client keeps waiting for navigation until shut down.
+      printf("=== FAILED: client %d never became ready.\n", run);
+      rclcpp::shutdown();
+      passed = false;
+      break;
+    }
+    printf("  %4d %14.3f %14.3f %14.3f\n",
+        run,
+        get_seconds(start_time, constructed_time),
+        get_seconds(start_time, times.first_state_time),
+        get_seconds(navigation_time, times.ready_state_time));
+
+    // The first state has to be sent while the navigation server is still
+    // missing.
+    if (times.first_state_time >= navigation_time)
+    {
+      printf("=== FAILED: client %d waited for navigation to send a state.\n",
+          run);
+      passed = false;
+    }
+  }
+
+  rclcpp::shutdown();
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return 1;
+  }
+  printf("=== PASSED\n");
+  return 0;
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <nav2_msgs/action/navigate_to_pose.hpp>
+
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+#include <free_fleet/messages/RobotMode.hpp>
+#include <free_fleet/messages/ModeRequest.hpp>
+#include <free_fleet/messages/PathRequest.hpp>
+
+#include "free_fleet/ros2/client_node.hpp"
+
+using NavigateToPose = nav2_msgs::action::NavigateToPose;
+using GoalHandleNavigateToPose =
+    rclcpp_action::ServerGoalHandle<NavigateToPose>;
+using Clock = std::chrono::steady_clock;
+
+const std::string fleet_name = "latency_fleet";
+const std::string robot_name = "latency_robot";
+const std::string navigation_server_name = "latency_navigate_to_pose";
+
+/// Goals and cancellations seen by the fake navigation server.
+struct NavigationEvents
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  int num_goals = 0;
+  int num_cancels = 0;
+  Clock::time_point cancel_time;
+};
+
+/// Sends a mode request to the robot and returns the time it was sent.
+Clock::time_point send_mode(
+    free_fleet::Server& _server, uint32_t _mode, const std::string& _task_id)
+{
+  free_fleet::messages::ModeRequest mode_request;
+  mode_request.fleet_name = fleet_name;
+  mode_request.robot_name = robot_name;
+  mode_request.mode.mode = _mode;
+  mode_request.task_id = _task_id;
+  const Clock::time_point send_time = Clock::now();
+  _server.send_mode_request(mode_request);
+  return send_time;
+}
+
+int main(int argc, char** argv)
+{
+  // Drives a client node with a path whose goal a fake navigation server
+  // keeps running until cancelled, then alternately pauses and stops the
+  // robot with mode requests and measures the time from sending each
+  // request to the navigation server receiving the cancellation. The robot
+  // is resumed between runs, which sends the goal again.
+  rclcpp::init(argc, argv);
+  int num_runs = 50;
+  if (argc > 1)
+    num_runs = std::stoi(argv[1]);
+
+  free_fleet::ServerConfig server_config;
+  free_fleet::Server::SharedPtr server =
+      free_fleet::Server::make(server_config);
+  if (!server)
+  {
+    printf("=== FAILED: unable to create the server.\n");
+    return 1;
+  }
+
+  // Same behavior as fake_action_server, except that goals only end when
+  // cancelled, and that every goal and cancellation is recorded.
+  NavigationEvents events;
+  auto navigation_node =
+      std::make_shared<rclcpp::Node>("latency_fake_navigation");
+  auto navigation_server = rclcpp_action::create_server<NavigateToPose>(
+      navigation_node, navigation_server_name,
+      [&](const rclcpp_action::GoalUUID&,
+          std::shared_ptr<const NavigateToPose::Goal>)
+      {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        ++events.num_goals;
+        events.cv.notify_all();
+        return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+      },
+      [&](const std::shared_ptr<GoalHandleNavigateToPose>)
+      {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        ++events.num_cancels;
+        events.cancel_time = Clock::now();
+        events.cv.notify_all();
+        return rclcpp_action::CancelResponse::ACCEPT;
+      },
+      [](const std::shared_ptr<GoalHandleNavigateToPose> _goal_handle)
+      {
+        std::thread{
+          [_goal_handle]()
+          {
+            while (rclcpp::ok() && _goal_handle->is_active())
+            {
+              if (_goal_handle->is_canceling())
+              {
+                _goal_handle->canceled(
+                    std::make_shared<NavigateToPose::Result>());
+                return;
+              }
+              std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+          }}.detach();
+      });
+
+  auto client_node = std::make_shared<free_fleet::ros2::ClientNode>(
+      rclcpp::NodeOptions().parameter_overrides({
+          {"fleet_name", fleet_name},
+          {"robot_name", robot_name},
+          {"nav2_server_name", navigation_server_name},
+          {"wait_timeout", 1.0}}));
+
+  rclcpp::executors::SingleThreadedExecutor navigation_executor;
+  navigation_executor.add_node(navigation_node);
+  std::thread navigation_spin_thread([&]() { navigation_executor.spin(); });
+  rclcpp::executors::SingleThreadedExecutor client_executor;
+  client_executor.add_node(client_node);
+  std::thread client_spin_thread([&]() { client_executor.spin(); });
+
+  // Waits for the client to send the goal with the given number.
+  auto wait_for_goal = [&](int _num_goals)
+  {
+    std::unique_lock<std::mutex> lock(events.mutex);
+    return events.cv.wait_for(lock, std::chrono::seconds(30),
+        [&]() { return events.num_goals >= _num_goals; });
+  };
+
+  // A single waypoint where the robot already is, due far in the future.
+  free_fleet::messages::PathRequest path_request;
+  path_request.fleet_name = fleet_name;
+  path_request.robot_name = robot_name;
+  path_request.task_id = "latency_path";
+  free_fleet::messages::Location waypoint;
+  waypoint.sec = static_cast<int32_t>(client_node->now().seconds()) + 3600;
+  waypoint.nanosec = 0;
+  waypoint.x = 0.0;
+  waypoint.y = 0.0;
+  waypoint.yaw = 0.0;
+  waypoint.level_name = "L1";
+  path_request.path.push_back(waypoint);
+
+  bool passed = true;
+  std::vector<double> latencies_ms;
+  for (int attempt = 0; attempt < 10 && !wait_for_goal(1); ++attempt)
+    server->send_path_request(path_request);
+  if (!wait_for_goal(1))
+  {
+    printf("=== FAILED: the client never sent the goal of the path.\n");
+    passed = false;
+  }
+
+  for (int run = 0; passed && run < num_runs && rclcpp::ok(); ++run)
+  {
+    int num_cancels;
+    {
+      std::unique_lock<std::mutex> lock(events.mutex);
+      num_cancels = events.num_cancels;
+    }
+
+    const uint32_t mode = run % 2 == 0 ?
+        free_fleet::messages::RobotMode::MODE_PAUSED :
+        free_fleet::messages::RobotMode::MODE_EMERGENCY;
+    const Clock::time_point send_time = send_mode(
+        *server, mode, "latency_stop_" + std::to_string(run));
+
+    bool cancelled = false;
+    Clock::time_point cancel_time;
+    {
+      std::unique_lock<std::mutex> lock(events.mutex);
+      cancelled = events.cv.wait_for(lock, std::chrono::seconds(5),
+          [&]() { return events.num_cancels > num_cancels; });
+      cancel_time = events.cancel_time;
+    }
+    if (!cancelled)
+    {
+      printf("=== FAILED: the goal was not cancelled in run %d.\n", run);
+      passed = false;
+      break;
+    }
+    latencies_ms.push_back(std::chrono::duration<double, std::milli>(
+        cancel_time - send_time).count());
+
+    send_mode(
+        *server, free_fleet::messages::RobotMode::MODE_MOVING,
+        "latency_resume_" + std::to_string(run));
+    if (!wait_for_goal(run + 2))
+    {
+      printf("=== FAILED: the goal was not sent again after run %d.\n", run);
+      passed = false;
+    }
+  }
+
+  // The client keeps waiting for its threads until shut down.
+  rclcpp::shutdown();
+  client_executor.cancel();
+  navigation_executor.cancel();
+  client_spin_thread.join();
+  navigation_spin_thread.join();
+
+  if (!latencies_ms.empty())
+  {
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    const std::size_t size = latencies_ms.size();
+    printf("=== %lu pause and emergency requests\n",
+        static_cast<unsigned long>(size));
+    printf("  request to cancel   p50 %8.3f ms   p99 %8.3f ms   max %8.3f ms\n",
+        latencies_ms[size / 2],
+        latencies_ms[std::min(size - 1, size * 99 / 100)],
+        latencies_ms.back());
+  }
+
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return 1;
+  }
+  printf("=== PASSED\n");
+  return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2019 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cmath>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <condition_variable>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+#include <nav2_msgs/action/navigate_to_pose.hpp>
+
+#include <free_fleet/Server.hpp>
+#include <free_fleet/ServerConfig.hpp>
+#include <free_fleet/messages/RobotMode.hpp>
+#include <free_fleet/messages/RobotState.hpp>
+#include <free_fleet/messages/PathRequest.hpp>
+
+#include "free_fleet/ros2/client_node.hpp"
+
+using NavigateToPose = nav2_msgs::action::NavigateToPose;
+using GoalHandleNavigateToPose =
+    rclcpp_action::ServerGoalHandle<NavigateToPose>;
+
+const std::string fleet_name = "replan_fleet";
+const std::string robot_name = "replan_robot";
+const std::string navigation_server_name = "replan_navigate_to_pose";
+const std::string final_task_id = "replan_final";
+
+/// Number of threads of this process.
+int get_num_threads()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, 8, "Threads:") == 0)
+      return std::stoi(line.substr(8));
+  }
+  return -1;
+}
+
+/// Goals received by the fake navigation server, and the latest robot state
+/// received by the server.
+struct Events
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::shared_ptr<GoalHandleNavigateToPose>> goals_to_finish;
+  int num_goals = 0;
+  std::vector<std::pair<double, rclcpp::Time>> final_goals;
+  bool got_ready_state = false;
+  std::string task_id;
+  std::size_t path_size = 0;
+};
+
+free_fleet::messages::PathRequest make_path_request(
+    const std::string& _task_id, const rclcpp::Time& _now, double _x)
+{
+  free_fleet::messages::PathRequest path_request;
+  path_request.fleet_name = fleet_name;
+  path_request.robot_name = robot_name;
+  path_request.task_id = _task_id;
+  for (int i = 1; i <= 3; ++i)
+  {
+    const int64_t due_ns =
+        _now.nanoseconds() + static_cast<int64_t>(i) * 1000000000;
+    free_fleet::messages::Location waypoint;
+    waypoint.sec = static_cast<int32_t>(due_ns / 1000000000);
+    waypoint.nanosec = static_cast<uint32_t>(due_ns % 1000000000);
+    waypoint.x = static_cast<float>(_x * i);
+    waypoint.y = 0.0f;
+    waypoint.yaw = 0.0f;
+    waypoint.level_name = "L1";
+    path_request.path.push_back(waypoint);
+  }
+  return path_request;
+}
+
+int main(int argc, char** argv)
+{
+  // Replans the path of a client node in rapid succession, against a fake
+  // navigation server that reaches every goal right away, so that the robot
+  // keeps arriving at waypoints ahead of time. Waiting for those waypoints
+  // must not cost a thread each, and once the replans stop, the waypoints of
+  // the last path have to be released at the time they are due.
+  rclcpp::init(argc, argv);
+  int num_replans = 1000;
+  if (argc > 1)
+    num_replans = std::stoi(argv[1]);
+
+  free_fleet::ServerConfig server_config;
+  free_fleet::Server::SharedPtr server =
+      free_fleet::Server::make(server_config);
+  if (!server)
+  {
+    printf("=== FAILED: unable to create the server.\n");
+    return 1;
+  }
+
+  Events events;
+  server->set_robot_state_callback(
+      [&](const free_fleet::messages::RobotState& _robot_state)
+      {
+        if (_robot_state.name != robot_name)
+          return;
+        std::unique_lock<std::mutex> lock(events.mutex);
+        events.got_ready_state = events.got_ready_state ||
+            _robot_state.mode.mode !=
+                free_fleet::messages::RobotMode::MODE_WAITING;
+        events.task_id = _robot_state.task_id;
+        events.path_size = _robot_state.path.size();
+        events.cv.notify_all();
+      });
+
+  // Goals are finished by a single thread shortly after they are accepted,
+  // so that the navigation server does not add threads of its own.
+  auto navigation_node =
+      std::make_shared<rclcpp::Node>("replan_fake_navigation");
+  auto navigation_server = rclcpp_action::create_server<NavigateToPose>(
+      navigation_node, navigation_server_name,
+      [&](const rclcpp_action::GoalUUID&,
+          std::shared_ptr<const NavigateToPose::Goal> _goal)
+      {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        ++events.num_goals;
+        if (_goal->pose.pose.position.x >= 1.0)
+        {
+          events.final_goals.emplace_back(
+              _goal->pose.pose.position.x, navigation_node->now());
+        }
+        events.cv.notify_all();
+        return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+      },
+      [](const std::shared_ptr<GoalHandleNavigateToPose>)
+      {
+        return rclcpp_action::CancelResponse::ACCEPT;
+      },
+      [&](const std::shared_ptr<GoalHandleNavigateToPose> _goal_handle)
+      {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        events.goals_to_finish.push_back(_goal_handle);
+      });
+
+  auto client_node = std::make_shared<free_fleet::ros2::ClientNode>(
+      rclcpp::NodeOptions().parameter_overrides({
+          {"fleet_name", fleet_name},
+          {"robot_name", robot_name},
+          {"nav2_server_name", navigation_server_name},
+          {"update_frequency", 100.0},
+          {"publish_frequency", 20.0},
+          {"wait_timeout", 1.0}}));
+
+  rclcpp::executors::SingleThreadedExecutor navigation_executor;
+  navigation_executor.add_node(navigation_node);
+  std::thread navigation_spin_thread([&]() { navigation_executor.spin(); });
+  rclcpp::executors::SingleThreadedExecutor client_executor;
+  client_executor.add_node(client_node);
+  std::thread client_spin_thread([&]() { client_executor.spin(); });
+
+  bool finishing_goals = true;
+  std::thread finish_thread([&]()
+  {
+    while (rclcpp::ok())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      std::vector<std::shared_ptr<GoalHandleNavigateToPose>> goals;
+      {
+        std::unique_lock<std::mutex> lock(events.mutex);
+        if (!finishing_goals)
+          return;
+        goals.swap(events.goals_to_finish);
+      }
+      for (const auto& goal : goals)
+      {
+        if (goal->is_active())
+          goal->succeed(std::make_shared<NavigateToPose::Result>());
+      }
+    }
+  });
+
+  bool passed = true;
+  {
+    std::unique_lock<std::mutex> lock(events.mutex);
+    if (!events.cv.wait_for(lock, std::chrono::seconds(30),
+        [&]() { return events.got_ready_state; }))
+    {
+      printf("=== FAILED: the client never became ready.\n");
+      passed = false;
+    }
+  }
+
+  // Every tenth replan waits for the goal to be reached, for the waypoint
+  // to be waiting for its time when the path is replaced.
+  const int threads_before = get_num_threads();
+  int max_threads = threads_before;
+  const auto start_time = std::chrono::steady_clock::now();
+  for (int i = 0; passed && i < num_replans && rclcpp::ok(); ++i)
+  {
+    server->send_path_request(make_path_request(
+        "replan_" + std::to_string(i), client_node->now(), 0.1));
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(i % 10 == 9 ? 30 : 2));
+    max_threads = std::max(max_threads, get_num_threads());
+  }
+  const double replan_seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start_time).count();
+
+  // The waypoints of the last path are due a second apart.
+  const rclcpp::Time final_time = client_node->now();
+  if (passed)
+  {
+    server->send_path_request(
+        make_path_request(final_task_id, final_time, 1.0));
+  }
+
+  std::vector<std::pair<double, rclcpp::Time>> final_goals;
+  bool finished = false;
+  if (passed)
+  {
+    std::unique_lock<std::mutex> lock(events.mutex);
+    finished = events.cv.wait_for(lock, std::chrono::seconds(10),
+        [&]()
+        {
+          return events.task_id == final_task_id && events.path_size == 0;
+        });
+    final_goals = events.final_goals;
+  }
+  const int threads_after = get_num_threads();
+
+  {
+    std::unique_lock<std::mutex> lock(events.mutex);
+    finishing_goals = false;
+  }
+  finish_thread.join();
+
+  // The client keeps waiting for its threads until shut down.
+  rclcpp::shutdown();
+  client_executor.cancel();
+  navigation_executor.cancel();
+  client_spin_thread.join();
+  navigation_spin_thread.join();
+
+  printf("=== %d replans in %.2f s, %d goals sent\n",
+      num_replans, replan_seconds, events.num_goals);
+  printf("  threads   before %d   max during %d   after %d\n",
+      threads_before, max_threads, threads_after);
+
+  if (passed && !finished)
+  {
+    printf("=== FAILED: the last path was never completed.\n");
+    passed = false;
+  }
+
+  // Each waypoint after the first is only sent once the one before it is
+  // due, and no later than a few updates after.
+  for (int i = 1; passed && i < 3; ++i)
+  {
+    const double x = static_cast<double>(i + 1);
+    auto goal = std::find_if(final_goals.begin(), final_goals.end(),
+        [&](const std::pair<double, rclcpp::Time>& _goal)
+        {
+          return std::abs(_goal.first - x) < 1e-3;
+        });
+    if (goal == final_goals.end())
+    {
+      printf("=== FAILED: waypoint %d of the last path was never sent.\n", i);
+      passed = false;
+      break;
+    }
+
+    const double lateness = (goal->second - final_time).seconds() - i;
+    printf("  waypoint %d released %+.3f s after it was due\n",
+        i - 1, lateness);
+    if (lateness < -0.01 || lateness > 0.5)
+    {
+      printf("=== FAILED: waypoint %d was not released when due.\n", i - 1);
+      passed = false;
+    }
+  }
+
+  // A few threads may still be started by DDS, but not one for every
+  // waypoint waited for.
+  if (max_threads > threads_before + 4)
+  {
+    printf("=== FAILED: threads were started to wait for waypoints.\n");
+    passed = false;
+  }
+
+  if (!passed)
+  {
+    printf("=== FAILED\n");
+    return 1;
+  }
+  printf("=== PASSED\n");
+  return 0;
+}
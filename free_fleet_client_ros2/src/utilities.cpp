@@ -16,6 +16,8 @@
  */
 
 #include <cmath>
+#include <thread>
+#include <algorithm>
 #include <tf2/impl/utils.h>
 
 #include "free_fleet/ros2/utilities.hpp"
@@ -71,5 +73,169 @@ bool is_pose_close(
   return true;
 }
 
+RobotPose to_robot_pose(const geometry_msgs::msg::PoseStamped& _pose_stamped)
+{
+  RobotPose pose;
+  pose.sec = _pose_stamped.header.stamp.sec;
+  pose.nanosec = _pose_stamped.header.stamp.nanosec;
+  pose.x = _pose_stamped.pose.position.x;
+  pose.y = _pose_stamped.pose.position.y;
+  pose.yaw = get_yaw_from_pose(_pose_stamped);
+  return pose;
+}
+
+bool is_pose_close(const RobotPose& _first, const RobotPose& _second)
+{
+  double elapsed_sec =
+      (static_cast<double>(_second.sec) - _first.sec) +
+      (static_cast<double>(_second.nanosec) - _first.nanosec) / 1e9;
+  double distance = hypot(_second.x - _first.x, _second.y - _first.y);
+  double speed = std::abs(distance / elapsed_sec);
+  if (speed > 0.01)
+    return false;
+
+  double turning_speed = std::abs((_second.yaw - _first.yaw) / elapsed_sec);
+  if (turning_speed > 0.01)
+    return false;
+
+  return true;
+}
+
+void LatestRobotPose::Fields::store(const RobotPose& _pose)
+{
+  sec.store(_pose.sec, std::memory_order_relaxed);
+  nanosec.store(_pose.nanosec, std::memory_order_relaxed);
+  x.store(_pose.x, std::memory_order_relaxed);
+  y.store(_pose.y, std::memory_order_relaxed);
+  yaw.store(_pose.yaw, std::memory_order_relaxed);
+}
+
+RobotPose LatestRobotPose::Fields::load() const
+{
+  RobotPose pose;
+  pose.sec = sec.load(std::memory_order_relaxed);
+  pose.nanosec = nanosec.load(std::memory_order_relaxed);
+  pose.x = x.load(std::memory_order_relaxed);
+  pose.y = y.load(std::memory_order_relaxed);
+  pose.yaw = yaw.load(std::memory_order_relaxed);
+  return pose;
+}
+
+void LatestRobotPose::store(const RobotPose& _pose)
+{
+  // An odd sequence marks the poses as being written, readers that saw it
+  // odd, or saw it change while reading, read them again.
+  const uint32_t begin = sequence.load(std::memory_order_relaxed);
+  sequence.store(begin + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  previous.store(current.load());
+  current.store(_pose);
+
+  sequence.store(begin + 2, std::memory_order_release);
+}
+
+void LatestRobotPose::load(RobotPose& _current, RobotPose& _previous) const
+{
+  while (true)
+  {
+    const uint32_t begin = sequence.load(std::memory_order_acquire);
+    if (begin & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    _current = current.load();
+    _previous = previous.load();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(std::memory_order_relaxed) == begin)
+      return;
+  }
+}
+
+RobotPose LatestRobotPose::load() const
+{
+  RobotPose current_pose;
+  RobotPose previous_pose;
+  load(current_pose, previous_pose);
+  return current_pose;
+}
+
+WaypointScheduler::WaypointScheduler(
+    const rclcpp::Duration& _tick, std::size_t _num_slots) :
+  tick_ns(std::max<int64_t>(_tick.nanoseconds(), 1)),
+  slots(std::max<std::size_t>(_num_slots, 1))
+{}
+
+void WaypointScheduler::skip_to(int64_t _now_tick)
+{
+  if (num_waiting == 0)
+    last_tick = _now_tick;
+}
+
+void WaypointScheduler::schedule(
+    uint64_t _goal_generation,
+    const rclcpp::Time& _due_time,
+    const rclcpp::Time& _now)
+{
+  skip_to(_now.nanoseconds() / tick_ns);
+
+  // Slots are only visited once their tick has fully started, so waypoints
+  // go into the first tick starting at or after their due time, and those
+  // that are already due into the next slot visited.
+  const int64_t due_ns = _due_time.nanoseconds();
+  const int64_t due_tick =
+      std::max((due_ns + tick_ns - 1) / tick_ns, last_tick + 1);
+  const std::size_t slot =
+      static_cast<std::size_t>(due_tick) % slots.size();
+  slots[slot].push_back(Entry{_goal_generation, due_ns});
+  ++num_waiting;
+}
+
+void WaypointScheduler::advance(
+    const rclcpp::Time& _now, std::vector<uint64_t>& _due)
+{
+  const int64_t now_ns = _now.nanoseconds();
+  const int64_t now_tick = now_ns / tick_ns;
+  skip_to(now_tick);
+
+  // Nothing is visited twice in a single advance, even after a long pause,
+  // while the clock jumping back only waits for the slots to come around.
+  const int64_t num_slots = static_cast<int64_t>(slots.size());
+  const int64_t end_tick = std::min(now_tick, last_tick + num_slots);
+  for (int64_t tick = last_tick + 1; tick <= end_tick && num_waiting; ++tick)
+  {
+    std::vector<Entry>& entries =
+        slots[static_cast<std::size_t>(tick) % slots.size()];
+    std::size_t kept = 0;
+    for (const Entry& entry : entries)
+    {
+      if (entry.due_ns <= now_ns)
+      {
+        _due.push_back(entry.goal_generation);
+        --num_waiting;
+      }
+      else
+        entries[kept++] = entry;
+    }
+    entries.resize(kept);
+  }
+  last_tick = now_tick;
+}
+
+void WaypointScheduler::clear()
+{
+  for (std::vector<Entry>& entries : slots)
+    entries.clear();
+  num_waiting = 0;
+}
+
+std::size_t WaypointScheduler::size() const
+{
+  return num_waiting;
+}
+
 } // namespace ros2
 } // namespace free_fleet
\ No newline at end of file
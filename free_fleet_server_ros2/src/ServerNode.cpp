@@ -15,9 +15,10 @@
  *
  */
 
+#include <cmath>
 #include <chrono>
-
-#include <Eigen/Geometry>
+#include <future>
+#include <algorithm>
 
 #include <free_fleet/Server.hpp>
 #include <free_fleet/ServerConfig.hpp>
@@ -34,28 +35,36 @@ namespace free_fleet
 namespace ros2
 {
 
-ServerNode::SharedPtr ServerNode::make(
+ServerNode::SharedPtr ServerNode::configure(
     const ServerNodeConfig& _config, const rclcpp::NodeOptions& _node_options)
 {
-  // Starting the free fleet server node
   SharedPtr server_node(new ServerNode(_config, _node_options));
 
-  auto start_time = std::chrono::steady_clock::now();
-  auto end_time = std::chrono::steady_clock::now();
-  while (
-      std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time)
-          .count() < 10)
+  // Parameters given on startup are there right away, otherwise the node
+  // waits for them to be set, woken up by its own parameter events.
+  server_node->setup_config();
+  if (!server_node->is_ready())
   {
-    rclcpp::spin_some(server_node);
-
-    server_node->setup_config();
-    if (server_node->is_ready())
-      break;
     RCLCPP_INFO(
         server_node->get_logger(), "waiting for configuration parameters.");
 
-    end_time = std::chrono::steady_clock::now();
-    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    std::promise<void> ready_promise;
+    std::shared_future<void> ready_future = ready_promise.get_future();
+    const std::string node_name = server_node->get_fully_qualified_name();
+    auto parameter_event_sub =
+        server_node->create_subscription<rcl_interfaces::msg::ParameterEvent>(
+            "/parameter_events", rclcpp::ParameterEventsQoS(),
+            [&](rcl_interfaces::msg::ParameterEvent::UniquePtr event)
+            {
+              if (event->node != node_name || server_node->is_ready())
+                return;
+              server_node->setup_config();
+              if (server_node->is_ready())
+                ready_promise.set_value();
+            });
+
+    rclcpp::spin_until_future_complete(
+        server_node, ready_future, std::chrono::seconds(10));
   }
 
   if (!server_node->is_ready())
@@ -65,6 +74,16 @@ ServerNode::SharedPtr ServerNode::make(
     return nullptr;
   }
   server_node->print_config();
+  return server_node;
+}
+
+ServerNode::SharedPtr ServerNode::make(
+    const ServerNodeConfig& _config, const rclcpp::NodeOptions& _node_options)
+{
+  // Starting the free fleet server node
+  SharedPtr server_node = configure(_config, _node_options);
+  if (!server_node)
+    return nullptr;
 
   // Starting the free fleet server
   ServerConfig server_config =
@@ -80,8 +99,80 @@ ServerNode::SharedPtr ServerNode::make(
   return server_node;
 }
 
+std::vector<ServerNode::SharedPtr> ServerNode::make(
+    const std::vector<ServerNodeConfig>& _configs,
+    const rclcpp::NodeOptions& _node_options)
+{
+  std::vector<SharedPtr> server_nodes;
+  for (const auto& config : _configs)
+  {
+    SharedPtr server_node = configure(config, _node_options);
+    if (!server_node)
+      return {};
+    server_nodes.push_back(std::move(server_node));
+  }
+  if (server_nodes.empty())
+    return {};
+
+  // Only the robot states are read separately for every fleet, everything
+  // else is shared, so it has to be configured the same way for all.
+  ServerConfig server_config =
+      server_nodes.front()->server_node_config.get_server_config();
+  server_config.fleets.clear();
+  for (const auto& server_node : server_nodes)
+  {
+    const ServerConfig fleet_server_config =
+        server_node->server_node_config.get_server_config();
+    if (fleet_server_config.dds_domain != server_config.dds_domain ||
+        fleet_server_config.dds_shared_memory !=
+            server_config.dds_shared_memory ||
+        fleet_server_config.dds_bounded_robot_state !=
+            server_config.dds_bounded_robot_state ||
+        fleet_server_config.dds_compact_path !=
+            server_config.dds_compact_path ||
+        fleet_server_config.dds_mode_request_topic !=
+            server_config.dds_mode_request_topic ||
+        fleet_server_config.dds_path_request_topic !=
+            server_config.dds_path_request_topic ||
+        fleet_server_config.dds_destination_request_topic !=
+            server_config.dds_destination_request_topic ||
+        fleet_server_config.dds_request_ack_topic !=
+            server_config.dds_request_ack_topic ||
+        fleet_server_config.dds_name_id_topic !=
+            server_config.dds_name_id_topic)
+    {
+      RCLCPP_ERROR(
+          server_node->get_logger(),
+          "fleets served together need the same DDS domain, transport, "
+          "request topics and name id topic.");
+      return {};
+    }
+    server_config.fleets.insert(
+        server_config.fleets.end(),
+        fleet_server_config.fleets.begin(),
+        fleet_server_config.fleets.end());
+  }
+
+  Server::SharedPtr server = Server::make(server_config);
+  if (!server)
+    return {};
+
+  for (const auto& server_node : server_nodes)
+    server_node->start(Fields{server});
+  return server_nodes;
+}
+
 ServerNode::~ServerNode()
-{}
+{
+  ingesting = false;
+  if (ingest_thread.joinable())
+    ingest_thread.join();
+
+  // The server may be shared with the nodes of other fleets and outlive this
+  // one, so the robot state callback capturing this node is cleared first.
+  if (fields.server)
+    fields.server->clear_robot_state_callback(server_node_config.fleet_name);
+}
 
 ServerNode::ServerNode(
     const ServerNodeConfig& _config,
@@ -95,6 +186,11 @@ void ServerNode::print_config()
   server_node_config.print_config();
 }
 
+const ServerNodeConfig& ServerNode::get_config() const
+{
+  return server_node_config;
+}
+
 void ServerNode::setup_config()
 {
   get_parameter("fleet_name", server_node_config.fleet_name);
@@ -105,6 +201,10 @@ void ServerNode::setup_config()
       "destination_request_topic",
       server_node_config.destination_request_topic);
   get_parameter("dds_domain", server_node_config.dds_domain);
+  get_parameter("dds_shared_memory", server_node_config.dds_shared_memory);
+  get_parameter("dds_bounded_robot_state",
+      server_node_config.dds_bounded_robot_state);
+  get_parameter("dds_compact_path", server_node_config.dds_compact_path);
   get_parameter("dds_robot_state_topic",
       server_node_config.dds_robot_state_topic);
   get_parameter("dds_mode_request_topic",
@@ -114,10 +214,46 @@ void ServerNode::setup_config()
   get_parameter(
       "dds_destination_request_topic",
       server_node_config.dds_destination_request_topic);
+  get_parameter("dds_request_ack_topic",
+      server_node_config.dds_request_ack_topic);
+  get_parameter("dds_name_id_topic", server_node_config.dds_name_id_topic);
+  get_parameter("dds_robot_state_queue_size",
+      server_node_config.dds_robot_state_queue_size);
+  get_parameter("request_ack_timeout",
+      server_node_config.request_ack_timeout);
+  get_parameter("request_max_attempts",
+      server_node_config.request_max_attempts);
+  get_parameter("request_coalesce_window",
+      server_node_config.request_coalesce_window);
+  get_parameter("max_robots", server_node_config.max_robots);
+  get_parameter(
+      "robot_stale_timeout", server_node_config.robot_stale_timeout);
+  get_parameter(
+      "robot_evict_timeout", server_node_config.robot_evict_timeout);
   get_parameter("update_state_frequency",
       server_node_config.update_state_frequency);
   get_parameter(
       "publish_state_frequency", server_node_config.publish_state_frequency);
+  get_parameter("ingest_thread", server_node_config.ingest_thread);
+  get_parameter("ingest_thread_cpu", server_node_config.ingest_thread_cpu);
+  get_parameter("executor_threads", server_node_config.executor_threads);
+  get_parameter("executor_cpus", server_node_config.executor_cpus);
+  get_parameter(
+      "publish_changes_only", server_node_config.publish_changes_only);
+  get_parameter("keyframe_frequency", server_node_config.keyframe_frequency);
+  if (!(server_node_config.keyframe_frequency > 0.0))
+  {
+    RCLCPP_WARN(
+        get_logger(),
+        "keyframe_frequency has to be positive, got %f, using 1.0 instead.",
+        server_node_config.keyframe_frequency);
+    server_node_config.keyframe_frequency = 1.0;
+  }
+  get_parameter(
+      "fleet_state_update_topic", server_node_config.fleet_state_update_topic);
+  get_parameter("position_epsilon", server_node_config.position_epsilon);
+  get_parameter("yaw_epsilon", server_node_config.yaw_epsilon);
+  get_parameter("battery_epsilon", server_node_config.battery_epsilon);
 
   get_parameter("translation_x", server_node_config.translation_x);
   get_parameter("translation_y", server_node_config.translation_y);
@@ -136,10 +272,23 @@ void ServerNode::start(Fields _fields)
 {
   fields = std::move(_fields);
 
-  {
-    WriteLock robot_states_lock(robot_states_mutex);
-    robot_states.clear();
-  }
+  fleet_table.reset(new FleetTable(
+      static_cast<std::size_t>(std::max(server_node_config.max_robots, 1)),
+      server_node_config.robot_stale_timeout,
+      server_node_config.robot_evict_timeout));
+
+  frame_transform = FrameTransform(
+      server_node_config.scale,
+      server_node_config.rotation,
+      server_node_config.translation_x,
+      server_node_config.translation_y);
+
+  // Updates of single robots are published from the robot state callbacks,
+  // so the publisher has to exist before they are registered.
+  if (!server_node_config.fleet_state_update_topic.empty())
+    fleet_state_update_pub =
+        create_publisher<rmf_fleet_msgs::msg::FleetState>(
+            server_node_config.fleet_state_update_topic, 10);
 
   using namespace std::chrono_literals;
 
@@ -150,13 +299,43 @@ void ServerNode::start(Fields _fields)
   update_state_callback_group = create_callback_group(
       rclcpp::CallbackGroupType::MutuallyExclusive);
 
-  update_state_timer = create_wall_timer(
-      100ms, std::bind(&ServerNode::update_state_callback, this),
-      update_state_callback_group);
+  // Robot states are taken by a thread of our own as soon as they arrive,
+  // or else pushed to us by a DDS listener, only fall back to polling if the
+  // listener could not be attached.
+  if (server_node_config.ingest_thread)
+  {
+    ingesting = true;
+    ingest_thread = std::thread(&ServerNode::ingest_robot_states, this);
+    if (server_node_config.ingest_thread_cpu >= 0 &&
+        !set_cpu_affinity(
+            ingest_thread.native_handle(),
+            {server_node_config.ingest_thread_cpu}))
+      RCLCPP_WARN(
+          get_logger(),
+          "unable to pin the ingest thread to cpu %d.",
+          server_node_config.ingest_thread_cpu);
+  }
+  else if (!fields.server->set_robot_state_callback(
+      server_node_config.fleet_name,
+      [this](const messages::RobotState& ff_rs)
+      {
+        update_robot_state(ff_rs);
+      }))
+  {
+    RCLCPP_WARN(
+        get_logger(),
+        "unable to listen for robot states, polling at %.1f Hz instead.",
+        server_node_config.update_state_frequency);
+
+    update_state_timer = create_wall_timer(
+        std::chrono::duration<double>(
+            1.0 / server_node_config.update_state_frequency),
+        std::bind(&ServerNode::update_state_callback, this),
+        update_state_callback_group);
+  }
 
   // --------------------------------------------------------------------------
-  // Second callback group that handles publishing fleet states to RMF, and
-  // handling requests from RMF to be sent down to the clients
+  // Second callback group that handles publishing fleet states to RMF
 
   fleet_state_pub_callback_group = create_callback_group(
       rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -165,17 +344,29 @@ void ServerNode::start(Fields _fields)
       create_publisher<rmf_fleet_msgs::msg::FleetState>(
           server_node_config.fleet_state_topic, 10);
 
+  // The fleet is announced right away, without any robots until their
+  // first states arrive.
+  fleet_state.name = server_node_config.fleet_name;
+  fleet_state_pub->publish(fleet_state);
+
   fleet_state_pub_timer = create_wall_timer(
       std::chrono::seconds(1) / server_node_config.publish_state_frequency,
       std::bind(&ServerNode::publish_fleet_state, this),
       fleet_state_pub_callback_group);
 
+  // --------------------------------------------------------------------------
+  // Third callback group that handles requests from RMF to be sent down to
+  // the clients, so that they are never held up by publishing fleet states
+
+  request_callback_group = create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive);
+
   // --------------------------------------------------------------------------
   // Mode request handling
 
   auto mode_request_sub_opt = rclcpp::SubscriptionOptions();
 
-  mode_request_sub_opt.callback_group = fleet_state_pub_callback_group;
+  mode_request_sub_opt.callback_group = request_callback_group;
 
   mode_request_sub = create_subscription<rmf_fleet_msgs::msg::ModeRequest>(
       server_node_config.mode_request_topic, rclcpp::QoS(10),
@@ -190,7 +381,7 @@ void ServerNode::start(Fields _fields)
 
   auto path_request_sub_opt = rclcpp::SubscriptionOptions();
 
-  path_request_sub_opt.callback_group = fleet_state_pub_callback_group;
+  path_request_sub_opt.callback_group = request_callback_group;
 
   path_request_sub = create_subscription<rmf_fleet_msgs::msg::PathRequest>(
       server_node_config.path_request_topic, rclcpp::QoS(10),
@@ -205,7 +396,7 @@ void ServerNode::start(Fields _fields)
 
   auto destination_request_sub_opt = rclcpp::SubscriptionOptions();
 
-  destination_request_sub_opt.callback_group = fleet_state_pub_callback_group;
+  destination_request_sub_opt.callback_group = request_callback_group;
 
   destination_request_sub =
       create_subscription<rmf_fleet_msgs::msg::DestinationRequest>(
@@ -223,10 +414,18 @@ bool ServerNode::is_request_valid(
   if (_fleet_name != server_node_config.fleet_name)
     return false;
 
-  ReadLock robot_states_lock(robot_states_mutex);
-  auto it = robot_states.find(_robot_name);
-  if (it == robot_states.end())
+  // Commands for robots that stopped sending updates would never be
+  // acknowledged.
+  std::size_t robot_id;
+  if (!fleet_table->find(_robot_name, robot_id) ||
+      fleet_table->is_stale(robot_id))
+  {
+    RCLCPP_WARN(
+        get_logger(),
+        "ignoring request for robot [%s], it is not sending updates.",
+        _robot_name.c_str());
     return false;
+  }
   return true;
 }
 
@@ -234,35 +433,14 @@ void ServerNode::transform_fleet_to_rmf(
     const rmf_fleet_msgs::msg::Location& _fleet_frame_location,
     rmf_fleet_msgs::msg::Location& _rmf_frame_location) const
 {
-  // It feels easier to read if each operation is a separate statement.
-  // The compiler will be super smart and elide all these operations.
-  const Eigen::Vector2d translated =
-      Eigen::Vector2d(_fleet_frame_location.x, _fleet_frame_location.y)
-      - Eigen::Vector2d(
-          server_node_config.translation_x, server_node_config.translation_y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf translated: (%.3f, %.3f)",
-  //     translated[0], translated[1]);
-
-  const Eigen::Vector2d rotated =
-      Eigen::Rotation2D<double>(-server_node_config.rotation) * translated;
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf rotated: (%.3f, %.3f)",
-  //     rotated[0], rotated[1]);
-
-  const Eigen::Vector2d scaled = 1.0 / server_node_config.scale * rotated;
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    fleet->rmf scaled: (%.3f, %.3f)",
-  //     scaled[0], scaled[1]);
-
-  _rmf_frame_location.x = scaled[0];
-  _rmf_frame_location.y = scaled[1];
-  _rmf_frame_location.yaw =
-      _fleet_frame_location.yaw - server_node_config.rotation;
-
+  float x = _fleet_frame_location.x;
+  float y = _fleet_frame_location.y;
+  float yaw = _fleet_frame_location.yaw;
+  frame_transform.fleet_to_rmf(1, &x, &y, &yaw);
+
+  _rmf_frame_location.x = x;
+  _rmf_frame_location.y = y;
+  _rmf_frame_location.yaw = yaw;
   _rmf_frame_location.t = _fleet_frame_location.t;
   _rmf_frame_location.level_name = _fleet_frame_location.level_name;
 }
@@ -271,37 +449,14 @@ void ServerNode::transform_rmf_to_fleet(
     const rmf_fleet_msgs::msg::Location& _rmf_frame_location,
     rmf_fleet_msgs::msg::Location& _fleet_frame_location) const
 {
-  // It feels easier to read if each operation is a separate statement.
-  // The compiler will be super smart and elide all these operations.
-  const Eigen::Vector2d scaled =
-      server_node_config.scale *
-      Eigen::Vector2d(_rmf_frame_location.x, _rmf_frame_location.y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet scaled: (%.3f, %.3f)",
-  //     scaled[0], scaled[1]);
-
-  const Eigen::Vector2d rotated =
-      Eigen::Rotation2D<double>(server_node_config.rotation) * scaled;
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet rotated: (%.3f, %.3f)",
-  //     rotated[0], rotated[1]);
-
-  const Eigen::Vector2d translated =
-      rotated +
-      Eigen::Vector2d(
-          server_node_config.translation_x, server_node_config.translation_y);
-
-  // RCLCPP_INFO(
-  //     get_logger(), "    rmf->fleet translated: (%.3f, %.3f)",
-  //     translated[0], translated[1]);
-
-  _fleet_frame_location.x = translated[0];
-  _fleet_frame_location.y = translated[1];
-  _fleet_frame_location.yaw =
-      _rmf_frame_location.yaw + server_node_config.rotation;
-
+  float x = _rmf_frame_location.x;
+  float y = _rmf_frame_location.y;
+  float yaw = _rmf_frame_location.yaw;
+  frame_transform.rmf_to_fleet(1, &x, &y, &yaw);
+
+  _fleet_frame_location.x = x;
+  _fleet_frame_location.y = y;
+  _fleet_frame_location.yaw = yaw;
   _fleet_frame_location.t = _rmf_frame_location.t;
   _fleet_frame_location.level_name = _rmf_frame_location.level_name;
 }
@@ -309,101 +464,442 @@ void ServerNode::transform_rmf_to_fleet(
 void ServerNode::handle_mode_request(
     rmf_fleet_msgs::msg::ModeRequest::UniquePtr _msg)
 {
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name))
+    return;
+
+  // Mode changes like emergency stops are never held back, they still
+  // supersede older mode requests to the same robot.
+  Server::RetryPolicy retry_policy = get_retry_policy();
+  retry_policy.coalesce_window = 0.0;
+
   messages::ModeRequest ff_msg;
   to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_mode_request(ff_msg);
+  fields.server->send_mode_request(
+      ff_msg, retry_policy,
+      make_request_result_callback(
+          "mode", ff_msg.robot_name, ff_msg.task_id));
 }
 
 void ServerNode::handle_path_request(
     rmf_fleet_msgs::msg::PathRequest::UniquePtr _msg)
 {
-  for (std::size_t i = 0; i < _msg->path.size(); ++i)
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name))
+    return;
+
+  // The whole path is transformed in a single pass.
+  const std::size_t num_waypoints = _msg->path.size();
+  path_request_poses.resize(num_waypoints);
+  for (std::size_t i = 0; i < num_waypoints; ++i)
+  {
+    path_request_poses.x[i] = _msg->path[i].x;
+    path_request_poses.y[i] = _msg->path[i].y;
+    path_request_poses.yaw[i] = _msg->path[i].yaw;
+  }
+  frame_transform.rmf_to_fleet(
+      num_waypoints,
+      path_request_poses.x.data(),
+      path_request_poses.y.data(),
+      path_request_poses.yaw.data());
+  for (std::size_t i = 0; i < num_waypoints; ++i)
   {
-    rmf_fleet_msgs::msg::Location fleet_frame_waypoint;
-    transform_rmf_to_fleet(_msg->path[i], fleet_frame_waypoint);
-    _msg->path[i] = fleet_frame_waypoint;
+    _msg->path[i].x = path_request_poses.x[i];
+    _msg->path[i].y = path_request_poses.y[i];
+    _msg->path[i].yaw = path_request_poses.yaw[i];
   }
 
   messages::PathRequest ff_msg;
   to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_path_request(ff_msg);
+  fields.server->send_path_request(
+      ff_msg, get_retry_policy(),
+      make_request_result_callback(
+          "path", ff_msg.robot_name, ff_msg.task_id));
 }
 
 void ServerNode::handle_destination_request(
     rmf_fleet_msgs::msg::DestinationRequest::UniquePtr _msg)
 {
+  if (!is_request_valid(_msg->fleet_name, _msg->robot_name))
+    return;
+
   rmf_fleet_msgs::msg::Location fleet_frame_destination;
   transform_rmf_to_fleet(_msg->destination, fleet_frame_destination);
   _msg->destination = fleet_frame_destination;
 
   messages::DestinationRequest ff_msg;
   to_ff_message(*(_msg.get()), ff_msg);
-  fields.server->send_destination_request(ff_msg);
+  fields.server->send_destination_request(
+      ff_msg, get_retry_policy(),
+      make_request_result_callback(
+          "destination", ff_msg.robot_name, ff_msg.task_id));
+}
+
+Server::RetryPolicy ServerNode::get_retry_policy() const
+{
+  Server::RetryPolicy retry_policy;
+  retry_policy.timeout = server_node_config.request_ack_timeout;
+  retry_policy.max_attempts = static_cast<uint32_t>(
+      std::max(server_node_config.request_max_attempts, 1));
+  retry_policy.coalesce_window =
+      std::max(server_node_config.request_coalesce_window, 0.0);
+  return retry_policy;
+}
+
+Server::RequestResultCallback ServerNode::make_request_result_callback(
+    const std::string& _request_kind,
+    const std::string& _robot_name,
+    const std::string& _task_id)
+{
+  return [this, _request_kind, _robot_name, _task_id](
+      const Server::RequestResult& _result)
+  {
+    switch (_result.status)
+    {
+      case Server::RequestResult::Status::Accepted:
+        RCLCPP_DEBUG(
+            get_logger(),
+            "%s request %s for %s accepted after %.3fs, %u attempt(s).",
+            _request_kind.c_str(), _task_id.c_str(), _robot_name.c_str(),
+            _result.latency, _result.attempts);
+        break;
+      case Server::RequestResult::Status::Rejected:
+        RCLCPP_WARN(
+            get_logger(),
+            "%s request %s for %s rejected after %.3fs: %s",
+            _request_kind.c_str(), _task_id.c_str(), _robot_name.c_str(),
+            _result.latency, _result.reason.c_str());
+        break;
+      case Server::RequestResult::Status::TimedOut:
+        RCLCPP_WARN(
+            get_logger(),
+            "%s request %s for %s not acknowledged after %u attempt(s).",
+            _request_kind.c_str(), _task_id.c_str(), _robot_name.c_str(),
+            _result.attempts);
+        break;
+      case Server::RequestResult::Status::Cancelled:
+        RCLCPP_DEBUG(
+            get_logger(),
+            "%s request %s for %s cancelled after %u attempt(s): %s",
+            _request_kind.c_str(), _task_id.c_str(), _robot_name.c_str(),
+            _result.attempts, _result.reason.c_str());
+        break;
+    }
+  };
 }
 
 void ServerNode::update_state_callback()
 {
-  std::vector<messages::RobotState> new_robot_states;
-  fields.server->read_robot_states(new_robot_states);
+  // Only robots that sent a new state since the last read are updated.
+  fields.server->read_robot_states(
+      server_node_config.fleet_name,
+      robot_state_arena,
+      updated_robot_state_indices);
+
+  for (std::size_t index : updated_robot_state_indices)
+    update_robot_state(robot_state_arena[index]);
+}
 
-  for (const messages::RobotState& ff_rs : new_robot_states)
+void ServerNode::ingest_robot_states()
+{
+  // Waits in short steps, to notice when the node is shutting down.
+  while (ingesting && rclcpp::ok())
   {
-    rmf_fleet_msgs::msg::RobotState ros_rs;
-    to_ros_message(ff_rs, ros_rs);
+    if (fields.server->wait_for_robot_states(
+        server_node_config.fleet_name, 0.1))
+      update_state_callback();
+  }
+}
 
-    WriteLock robot_states_lock(robot_states_mutex);
-    auto it = robot_states.find(ros_rs.name);
-    if (it == robot_states.end())
-      RCLCPP_INFO(
-          get_logger(),
-          "registered a new robot: [%s]",
-          ros_rs.name.c_str());
+void ServerNode::update_robot_state(const messages::RobotState& _robot_state)
+{
+  // Robots that do not fit in the table are counted by it, and reported
+  // when publishing.
+  std::size_t robot_id;
+  bool is_new_robot = false;
+  if (!fleet_table->update(_robot_state, robot_id, &is_new_robot))
+    return;
+
+  if (is_new_robot)
+    RCLCPP_INFO(
+        get_logger(),
+        "registered a new robot: [%s]",
+        _robot_state.name.c_str());
+
+  if (fleet_state_update_pub)
+    publish_robot_state_update(robot_id, _robot_state);
+}
+
+bool ServerNode::is_significant_change(
+    double _dx, double _dy, double _dyaw, double _dbattery) const
+{
+  const double position_epsilon = server_node_config.position_epsilon;
+  return _dx * _dx + _dy * _dy > position_epsilon * position_epsilon ||
+      std::abs(std::remainder(_dyaw, 2.0 * M_PI)) >
+          server_node_config.yaw_epsilon ||
+      std::abs(_dbattery) > server_node_config.battery_epsilon;
+}
 
-    robot_states[ros_rs.name] = ros_rs;
+bool ServerNode::is_significant_change(
+    const messages::RobotState& _previous,
+    const messages::RobotState& _current) const
+{
+  if (_previous.mode.mode != _current.mode.mode ||
+      _previous.task_id != _current.task_id ||
+      _previous.model != _current.model ||
+      _previous.location.level_name != _current.location.level_name ||
+      _previous.path.size() != _current.path.size())
+    return true;
+
+  for (std::size_t i = 0; i < _current.path.size(); ++i)
+  {
+    const messages::Location& previous_waypoint = _previous.path[i];
+    const messages::Location& current_waypoint = _current.path[i];
+    if (previous_waypoint.sec != current_waypoint.sec ||
+        previous_waypoint.nanosec != current_waypoint.nanosec ||
+        previous_waypoint.x != current_waypoint.x ||
+        previous_waypoint.y != current_waypoint.y ||
+        previous_waypoint.yaw != current_waypoint.yaw ||
+        previous_waypoint.level_name != current_waypoint.level_name)
+      return true;
   }
+
+  return is_significant_change(
+      _current.location.x - _previous.location.x,
+      _current.location.y - _previous.location.y,
+      _current.location.yaw - _previous.location.yaw,
+      _current.battery_percent - _previous.battery_percent);
+}
+
+void ServerNode::publish_robot_state_update(
+    std::size_t _robot_id, const messages::RobotState& _robot_state)
+{
+  // Ids of evicted robots are reused, the name tells them apart.
+  if (_robot_id >= last_updated_robot_states.size())
+    last_updated_robot_states.resize(_robot_id + 1);
+  messages::RobotState& last_updated_robot_state =
+      last_updated_robot_states[_robot_id];
+  if (last_updated_robot_state.name == _robot_state.name &&
+      !is_significant_change(last_updated_robot_state, _robot_state))
+    return;
+  last_updated_robot_state = _robot_state;
+
+  // The location and path are transformed together, with the location
+  // first.
+  const std::size_t num_poses = _robot_state.path.size() + 1;
+  robot_state_update_poses.resize(num_poses);
+  robot_state_update_poses.x[0] = _robot_state.location.x;
+  robot_state_update_poses.y[0] = _robot_state.location.y;
+  robot_state_update_poses.yaw[0] = _robot_state.location.yaw;
+  for (std::size_t i = 1; i < num_poses; ++i)
+  {
+    robot_state_update_poses.x[i] = _robot_state.path[i - 1].x;
+    robot_state_update_poses.y[i] = _robot_state.path[i - 1].y;
+    robot_state_update_poses.yaw[i] = _robot_state.path[i - 1].yaw;
+  }
+  frame_transform.fleet_to_rmf(
+      num_poses,
+      robot_state_update_poses.x.data(),
+      robot_state_update_poses.y.data(),
+      robot_state_update_poses.yaw.data());
+
+  fleet_state_update.name = server_node_config.fleet_name;
+  fleet_state_update.robots.resize(1);
+  rmf_fleet_msgs::msg::RobotState& rmf_frame_rs = fleet_state_update.robots[0];
+
+  rmf_frame_rs.name = _robot_state.name;
+  rmf_frame_rs.model = _robot_state.model;
+  rmf_frame_rs.task_id = _robot_state.task_id;
+  rmf_frame_rs.mode.mode = _robot_state.mode.mode;
+  rmf_frame_rs.battery_percent = _robot_state.battery_percent;
+
+  rmf_frame_rs.location.t.sec = _robot_state.location.sec;
+  rmf_frame_rs.location.t.nanosec = _robot_state.location.nanosec;
+  rmf_frame_rs.location.x = robot_state_update_poses.x[0];
+  rmf_frame_rs.location.y = robot_state_update_poses.y[0];
+  rmf_frame_rs.location.yaw = robot_state_update_poses.yaw[0];
+  rmf_frame_rs.location.level_name = _robot_state.location.level_name;
+
+  rmf_frame_rs.path.resize(_robot_state.path.size());
+  for (std::size_t i = 0; i < _robot_state.path.size(); ++i)
+  {
+    rmf_fleet_msgs::msg::Location& rmf_frame_location = rmf_frame_rs.path[i];
+    rmf_frame_location.t.sec = _robot_state.path[i].sec;
+    rmf_frame_location.t.nanosec = _robot_state.path[i].nanosec;
+    rmf_frame_location.x = robot_state_update_poses.x[i + 1];
+    rmf_frame_location.y = robot_state_update_poses.y[i + 1];
+    rmf_frame_location.yaw = robot_state_update_poses.yaw[i + 1];
+    rmf_frame_location.level_name = _robot_state.path[i].level_name;
+  }
+
+  fleet_state_update_pub->publish(fleet_state_update);
+}
+
+bool ServerNode::has_fleet_changed() const
+{
+  if (fleet_snapshot.size() != published_fleet_snapshot.size())
+    return true;
+
+  for (std::size_t i = 0; i < fleet_snapshot.size(); ++i)
+  {
+    if (fleet_snapshot.id[i] != published_fleet_snapshot.id[i] ||
+        fleet_snapshot.stale[i] != published_fleet_snapshot.stale[i])
+      return true;
+
+    if (fleet_snapshot.version[i] == published_fleet_snapshot.version[i])
+      continue;
+
+    // Details are only replaced by the fleet table when they changed.
+    if (fleet_snapshot.details[i] != published_fleet_snapshot.details[i] ||
+        fleet_snapshot.mode[i] != published_fleet_snapshot.mode[i])
+      return true;
+
+    if (is_significant_change(
+        fleet_snapshot.x[i] - published_fleet_snapshot.x[i],
+        fleet_snapshot.y[i] - published_fleet_snapshot.y[i],
+        fleet_snapshot.yaw[i] - published_fleet_snapshot.yaw[i],
+        fleet_snapshot.battery_percent[i] -
+            published_fleet_snapshot.battery_percent[i]))
+      return true;
+  }
+  return false;
 }
 
 void ServerNode::publish_fleet_state()
 {
-  rmf_fleet_msgs::msg::FleetState fleet_state;
-  fleet_state.name = server_node_config.fleet_name;
-  fleet_state.robots.clear();
+  const uint64_t new_dropped_robot_state_count =
+      fields.server->get_dropped_robot_state_count(
+          server_node_config.fleet_name);
+  if (new_dropped_robot_state_count > dropped_robot_state_count)
+  {
+    RCLCPP_WARN(
+        get_logger(),
+        "dropped %lu robot states since the last fleet state, consider "
+        "increasing dds_robot_state_queue_size.",
+        new_dropped_robot_state_count - dropped_robot_state_count);
+    dropped_robot_state_count = new_dropped_robot_state_count;
+  }
 
-  ReadLock robot_states_lock(robot_states_mutex);
-  for (const auto it : robot_states)
+  const uint64_t new_rejected_robot_state_count =
+      fleet_table->get_rejected_count();
+  if (new_rejected_robot_state_count > rejected_robot_state_count)
   {
-    const auto fleet_frame_rs = it.second;
-    rmf_fleet_msgs::msg::RobotState rmf_frame_rs;
-
-    transform_fleet_to_rmf(fleet_frame_rs.location, rmf_frame_rs.location);
-
-    // RCLCPP_INFO(
-    //     get_logger(),
-    //     "robot location: (%.1f, %.1f, %.1f) -> (%.1f, %.1f, %.1f)",
-    //     fleet_frame_rs.location.x,
-    //     fleet_frame_rs.location.y,
-    //     fleet_frame_rs.location.yaw,
-    //     rmf_frame_rs.location.x,
-    //     rmf_frame_rs.location.y,
-    //     rmf_frame_rs.location.yaw);
-
-    rmf_frame_rs.name = fleet_frame_rs.name;
-    rmf_frame_rs.model = fleet_frame_rs.model;
-    rmf_frame_rs.task_id = fleet_frame_rs.task_id;
-    rmf_frame_rs.mode = fleet_frame_rs.mode;
-    rmf_frame_rs.battery_percent = fleet_frame_rs.battery_percent;
-
-    rmf_frame_rs.path.clear();
-    for (const auto& fleet_frame_path_loc : fleet_frame_rs.path)
-    {
-      rmf_fleet_msgs::msg::Location rmf_frame_path_loc;
+    RCLCPP_WARN(
+        get_logger(),
+        "ignored %lu robot states of new robots since the last fleet state, "
+        "consider increasing max_robots beyond %lu.",
+        new_rejected_robot_state_count - rejected_robot_state_count,
+        static_cast<unsigned long>(fleet_table->capacity()));
+    rejected_robot_state_count = new_rejected_robot_state_count;
+  }
 
-      transform_fleet_to_rmf(fleet_frame_path_loc, rmf_frame_path_loc);
+  // Only the robots that are due are looked at, so expiring costs nothing
+  // while every robot keeps sending updates.
+  stale_robot_names.clear();
+  evicted_robot_names.clear();
+  fleet_table->expire(
+      std::chrono::steady_clock::now(),
+      stale_robot_names,
+      evicted_robot_names);
+  for (const auto& robot_name : stale_robot_names)
+    RCLCPP_WARN(
+        get_logger(),
+        "robot [%s] has not sent an update in %.1fs, marking it as stale.",
+        robot_name.c_str(), server_node_config.robot_stale_timeout);
+  for (const auto& robot_name : evicted_robot_names)
+    RCLCPP_WARN(
+        get_logger(),
+        "robot [%s] has not sent an update in %.1fs, evicting it.",
+        robot_name.c_str(), server_node_config.robot_evict_timeout);
+
+  // Reading the table only waits on the robot state updates while they swap
+  // the details of a robot, and the fleet state message is reused, so only
+  // the robots that joined since the last publish need new storage.
+  fleet_table->read_all(fleet_snapshot);
+
+  // Unless a keyframe is due, fleets that did not change significantly
+  // since the last fleet state are not published again.
+  if (server_node_config.publish_changes_only)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const bool is_keyframe = now >= next_keyframe_time;
+    if (!is_keyframe && !has_fleet_changed())
+      return;
+
+    if (is_keyframe)
+      next_keyframe_time = now +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(
+                  1.0 / server_node_config.keyframe_frequency));
+    published_fleet_snapshot = fleet_snapshot;
+  }
 
-      rmf_frame_rs.path.push_back(rmf_frame_path_loc);
+  // The locations of every robot, and then every waypoint of every path,
+  // are each transformed in a single pass.
+  const std::size_t num_robots = fleet_snapshot.size();
+  frame_transform.fleet_to_rmf(
+      num_robots,
+      fleet_snapshot.x.data(),
+      fleet_snapshot.y.data(),
+      fleet_snapshot.yaw.data());
+
+  std::size_t num_waypoints = 0;
+  for (std::size_t i = 0; i < num_robots; ++i)
+    num_waypoints += fleet_snapshot.details[i]->path.size();
+
+  fleet_state_path_poses.resize(num_waypoints);
+  std::size_t waypoint = 0;
+  for (std::size_t i = 0; i < num_robots; ++i)
+  {
+    for (const auto& fleet_frame_location : fleet_snapshot.details[i]->path)
+    {
+      fleet_state_path_poses.x[waypoint] = fleet_frame_location.x;
+      fleet_state_path_poses.y[waypoint] = fleet_frame_location.y;
+      fleet_state_path_poses.yaw[waypoint] = fleet_frame_location.yaw;
+      ++waypoint;
     }
+  }
+  frame_transform.fleet_to_rmf(
+      num_waypoints,
+      fleet_state_path_poses.x.data(),
+      fleet_state_path_poses.y.data(),
+      fleet_state_path_poses.yaw.data());
+
+  fleet_state.name = server_node_config.fleet_name;
+  fleet_state.robots.resize(num_robots);
 
-    fleet_state.robots.push_back(rmf_frame_rs);
+  waypoint = 0;
+  for (std::size_t i = 0; i < num_robots; ++i)
+  {
+    const FleetTable::Details& details = *fleet_snapshot.details[i];
+    rmf_fleet_msgs::msg::RobotState& rmf_frame_rs = fleet_state.robots[i];
+
+    rmf_frame_rs.name = details.name;
+    rmf_frame_rs.model = details.model;
+    rmf_frame_rs.task_id = details.task_id;
+    rmf_frame_rs.mode.mode = fleet_snapshot.stale[i] ?
+        rmf_fleet_msgs::msg::RobotMode::MODE_REQUEST_ERROR :
+        fleet_snapshot.mode[i];
+    rmf_frame_rs.battery_percent = fleet_snapshot.battery_percent[i];
+
+    rmf_frame_rs.location.t.sec = fleet_snapshot.sec[i];
+    rmf_frame_rs.location.t.nanosec = fleet_snapshot.nanosec[i];
+    rmf_frame_rs.location.x = fleet_snapshot.x[i];
+    rmf_frame_rs.location.y = fleet_snapshot.y[i];
+    rmf_frame_rs.location.yaw = fleet_snapshot.yaw[i];
+    rmf_frame_rs.location.level_name = details.level_name;
+
+    rmf_frame_rs.path.resize(details.path.size());
+    for (std::size_t j = 0; j < details.path.size(); ++j)
+    {
+      rmf_fleet_msgs::msg::Location& rmf_frame_location =
+          rmf_frame_rs.path[j];
+      rmf_frame_location.t.sec = details.path[j].sec;
+      rmf_frame_location.t.nanosec = details.path[j].nanosec;
+      rmf_frame_location.x = fleet_state_path_poses.x[waypoint];
+      rmf_frame_location.y = fleet_state_path_poses.y[waypoint];
+      rmf_frame_location.yaw = fleet_state_path_poses.yaw[waypoint];
+      rmf_frame_location.level_name = details.path[j].level_name;
+      ++waypoint;
+    }
   }
   fleet_state_pub->publish(fleet_state);
 }
@@ -19,8 +19,11 @@
 #define FREE_FLEET_SERVER_ROS2__SRC__SERVERNODE_HPP
 
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <memory>
-#include <unordered_map>
+#include <thread>
+#include <vector>
 
 #include <rclcpp/rclcpp.hpp>
 #include <rclcpp/node_options.hpp>
@@ -28,6 +31,7 @@
 #include <rcl_interfaces/msg/parameter_event.hpp>
 
 #include <rmf_fleet_msgs/msg/location.hpp>
+#include <rmf_fleet_msgs/msg/robot_mode.hpp>
 #include <rmf_fleet_msgs/msg/robot_state.hpp>
 #include <rmf_fleet_msgs/msg/fleet_state.hpp>
 #include <rmf_fleet_msgs/msg/mode_request.hpp>
@@ -35,6 +39,8 @@
 #include <rmf_fleet_msgs/msg/destination_request.hpp>
 
 #include <free_fleet/Server.hpp>
+#include <free_fleet/FleetTable.hpp>
+#include <free_fleet/FrameTransform.hpp>
 #include <free_fleet/messages/Location.hpp>
 #include <free_fleet/messages/RobotState.hpp>
 
@@ -60,6 +66,17 @@ public:
               .allow_undeclared_parameters(true)
               .automatically_declare_parameters_from_overrides(true));
 
+  /// Creates a server node for every fleet, each reading its parameters
+  /// under its own node name, all sharing a single free fleet server and
+  /// with it a single DDS participant. The fleets need to share the DDS
+  /// domain and request topics, while each needs its own robot state topic.
+  static std::vector<SharedPtr> make(
+      const std::vector<ServerNodeConfig>& configs,
+      const rclcpp::NodeOptions& options =
+          rclcpp::NodeOptions()
+              .allow_undeclared_parameters(true)
+              .automatically_declare_parameters_from_overrides(true));
+
   ~ServerNode();
 
   struct Fields
@@ -70,11 +87,30 @@ public:
 
   void print_config();
 
+  const ServerNodeConfig& get_config() const;
+
 private:
 
   bool is_request_valid(
       const std::string& fleet_name, const std::string& robot_name);
 
+  /// Poses gathered into contiguous arrays, to be transformed together.
+  struct Poses
+  {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> yaw;
+
+    void resize(std::size_t size)
+    {
+      x.resize(size);
+      y.resize(size);
+      yaw.resize(size);
+    }
+  };
+
+  FrameTransform frame_transform;
+
   void transform_fleet_to_rmf(
       const rmf_fleet_msgs::msg::Location& fleet_frame_location,
       rmf_fleet_msgs::msg::Location& rmf_frame_location) const;
@@ -88,6 +124,8 @@ private:
   rclcpp::Subscription<rmf_fleet_msgs::msg::ModeRequest>::SharedPtr
       mode_request_sub;
 
+  rclcpp::CallbackGroup::SharedPtr request_callback_group;
+
   void handle_mode_request(rmf_fleet_msgs::msg::ModeRequest::UniquePtr msg);
 
   // --------------------------------------------------------------------------
@@ -95,6 +133,8 @@ private:
   rclcpp::Subscription<rmf_fleet_msgs::msg::PathRequest>::SharedPtr
       path_request_sub;
 
+  Poses path_request_poses;
+
   void handle_path_request(rmf_fleet_msgs::msg::PathRequest::UniquePtr msg);
 
   // --------------------------------------------------------------------------
@@ -105,19 +145,64 @@ private:
   void handle_destination_request(
       rmf_fleet_msgs::msg::DestinationRequest::UniquePtr msg);
 
+  Server::RetryPolicy get_retry_policy() const;
+
+  /// Logs the outcome of a request once it has been acknowledged by the
+  /// client, or given up on.
+  Server::RequestResultCallback make_request_result_callback(
+      const std::string& request_kind,
+      const std::string& robot_name,
+      const std::string& task_id);
+
   // --------------------------------------------------------------------------
 
   rclcpp::CallbackGroup::SharedPtr update_state_callback_group;
 
   rclcpp::TimerBase::SharedPtr update_state_timer;
 
-  std::mutex robot_states_mutex;
+  std::unique_ptr<FleetTable> fleet_table;
 
-  std::unordered_map<std::string, rmf_fleet_msgs::msg::RobotState>
-      robot_states;
+  Server::RobotStateArena robot_state_arena;
+
+  std::vector<std::size_t> updated_robot_state_indices;
 
   void update_state_callback();
 
+  /// Reads robot states on a thread of its own as soon as they arrive,
+  /// until the node is destroyed.
+  std::thread ingest_thread;
+
+  std::atomic<bool> ingesting{false};
+
+  void ingest_robot_states();
+
+  void update_robot_state(const messages::RobotState& robot_state);
+
+  /// Whether a change of a robot is beyond the configured thresholds.
+  bool is_significant_change(
+      double dx, double dy, double dyaw, double dbattery) const;
+
+  bool is_significant_change(
+      const messages::RobotState& previous,
+      const messages::RobotState& current) const;
+
+  // --------------------------------------------------------------------------
+
+  rclcpp::Publisher<rmf_fleet_msgs::msg::FleetState>::SharedPtr
+      fleet_state_update_pub;
+
+  /// Last state of every robot published on the update topic, by robot id.
+  std::vector<messages::RobotState> last_updated_robot_states;
+
+  Poses robot_state_update_poses;
+
+  rmf_fleet_msgs::msg::FleetState fleet_state_update;
+
+  /// Publishes a robot on its own if it changed significantly since it was
+  /// last published on the update topic.
+  void publish_robot_state_update(
+      std::size_t robot_id, const messages::RobotState& robot_state);
+
   // --------------------------------------------------------------------------
 
   rclcpp::CallbackGroup::SharedPtr
@@ -128,8 +213,30 @@ private:
   rclcpp::Publisher<rmf_fleet_msgs::msg::FleetState>::SharedPtr
       fleet_state_pub;
 
+  FleetTable::Snapshot fleet_snapshot;
+
+  Poses fleet_state_path_poses;
+
+  rmf_fleet_msgs::msg::FleetState fleet_state;
+
+  /// Fleet as it was when the last fleet state was published, only kept
+  /// when publishing changes only.
+  FleetTable::Snapshot published_fleet_snapshot;
+
+  std::chrono::steady_clock::time_point next_keyframe_time;
+
+  std::vector<std::string> stale_robot_names;
+
+  std::vector<std::string> evicted_robot_names;
+
+  bool has_fleet_changed() const;
+
   void publish_fleet_state();
 
+  uint64_t dropped_robot_state_count = 0;
+
+  uint64_t rejected_robot_state_count = 0;
+
   // --------------------------------------------------------------------------
 
   ServerNodeConfig server_node_config;
@@ -143,6 +250,10 @@ private:
   ServerNode(
       const ServerNodeConfig& config, const rclcpp::NodeOptions& options);
 
+  /// Creates a node and waits for its configuration parameters.
+  static SharedPtr configure(
+      const ServerNodeConfig& config, const rclcpp::NodeOptions& options);
+
   void start(Fields fields);
 
 };
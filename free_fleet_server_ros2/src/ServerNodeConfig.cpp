@@ -31,21 +31,48 @@ void ServerNodeConfig::print_config() const
   setbuf(stdout, NULL);
   printf("ROS 2 SERVER CONFIGURATION\n");
   printf("  fleet name: %s\n", fleet_name.c_str());
+  printf("  max robots: %d\n", max_robots);
+  printf("  robot stale timeout: %.1f\n", robot_stale_timeout);
+  printf("  robot evict timeout: %.1f\n", robot_evict_timeout);
   printf("  update state frequency: %.1f\n", update_state_frequency);
   printf("  publish state frequency: %.1f\n", publish_state_frequency);
+  printf("  ingest thread: %s\n", ingest_thread ? "true" : "false");
+  printf("  ingest thread cpu: %d\n", ingest_thread_cpu);
+  printf("  executor threads: %d\n", executor_threads);
+  printf("  executor cpus:");
+  for (const int64_t cpu : executor_cpus)
+    printf(" %ld", static_cast<long>(cpu));
+  printf("\n");
+  printf("  publish changes only: %s\n",
+      publish_changes_only ? "true" : "false");
+  printf("  keyframe frequency: %.1f\n", keyframe_frequency);
+  printf("  position epsilon: %.3f\n", position_epsilon);
+  printf("  yaw epsilon: %.3f\n", yaw_epsilon);
+  printf("  battery epsilon: %.3f\n", battery_epsilon);
   printf("  TOPICS\n");
   printf("    fleet state: %s\n", fleet_state_topic.c_str());
+  printf("    fleet state update: %s\n", fleet_state_update_topic.c_str());
   printf("    mode request: %s\n", mode_request_topic.c_str());
   printf("    path request: %s\n", path_request_topic.c_str());
   printf("    destination request: %s\n", destination_request_topic.c_str());
   printf("SERVER-CLIENT DDS CONFIGURATION\n");
   printf("  dds domain: %d\n", dds_domain);
+  printf("  dds shared memory: %s\n", dds_shared_memory ? "true" : "false");
+  printf("  dds bounded robot state: %s\n",
+      dds_bounded_robot_state ? "true" : "false");
+  printf("  dds compact path: %s\n", dds_compact_path ? "true" : "false");
+  printf("  robot state queue size: %d\n", dds_robot_state_queue_size);
+  printf("  request ack timeout: %.3f\n", request_ack_timeout);
+  printf("  request max attempts: %d\n", request_max_attempts);
+  printf("  request coalesce window: %.3f\n", request_coalesce_window);
   printf("  TOPICS\n");
   printf("    robot state: %s\n", dds_robot_state_topic.c_str());
   printf("    mode request: %s\n", dds_mode_request_topic.c_str());
   printf("    path request: %s\n", dds_path_request_topic.c_str());
   printf("    destination request: %s\n",
       dds_destination_request_topic.c_str());
+  printf("    request ack: %s\n", dds_request_ack_topic.c_str());
+  printf("    name id: %s\n", dds_name_id_topic.c_str());
   printf("COORDINATE TRANSFORMATION\n");
   printf("  translation x (meters): %.3f\n", translation_x);
   printf("  translation y (meters): %.3f\n", translation_y);
@@ -57,10 +84,18 @@ ServerConfig ServerNodeConfig::get_server_config() const
 {
   ServerConfig server_config;
   server_config.dds_domain = dds_domain;
+  server_config.dds_shared_memory = dds_shared_memory;
+  server_config.dds_bounded_robot_state = dds_bounded_robot_state;
+  server_config.dds_compact_path = dds_compact_path;
   server_config.dds_robot_state_topic = dds_robot_state_topic;
   server_config.dds_mode_request_topic = dds_mode_request_topic;
   server_config.dds_path_request_topic = dds_path_request_topic;
   server_config.dds_destination_request_topic = dds_destination_request_topic;
+  server_config.dds_request_ack_topic = dds_request_ack_topic;
+  server_config.dds_name_id_topic = dds_name_id_topic;
+  server_config.dds_robot_state_qos.max_samples = dds_robot_state_queue_size;
+  server_config.fleets.push_back(
+      ServerConfig::FleetConfig{fleet_name, dds_robot_state_topic});
   return server_config;
 }
 
@@ -19,6 +19,8 @@
 #define FREE_FLEET_SERVER_ROS2__SRC__SERVERNODECONFIG_HPP
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace free_fleet
 {
@@ -35,15 +37,87 @@ struct ServerNodeConfig
   std::string path_request_topic = "path_request";
   std::string destination_request_topic = "destination_request";
 
+  // fleets served from the same process share everything but the robot
+  // state topic, which has to be different for every fleet
   int dds_domain = 42;
+  bool dds_shared_memory = false;
+  bool dds_bounded_robot_state = false;
+  bool dds_compact_path = false;
   std::string dds_robot_state_topic = "robot_state";
   std::string dds_mode_request_topic = "mode_request";
   std::string dds_path_request_topic = "path_request";
   std::string dds_destination_request_topic = "destination_request";
+  std::string dds_request_ack_topic = "request_ack";
+
+  // names are only sent as ids when this is set, to a topic of its own for
+  // every server on the same DDS domain
+  std::string dds_name_id_topic = "";
+
+  int dds_robot_state_queue_size = 1000;
+
+  // requests are sent again if not acknowledged by the client within the
+  // timeout, until the maximum number of attempts
+  double request_ack_timeout = 1.0;
+  int request_max_attempts = 3;
+
+  // path and destination requests to a robot arriving within this many
+  // seconds of the last one sent to it are coalesced, only the newest of
+  // them is sent once the window has passed, 0 sends every request
+  double request_coalesce_window = 0.05;
+
+  // robots beyond this number are ignored, storage for all of them is
+  // allocated upfront
+  int max_robots = 1000;
+
+  // robots that did not send an update for this many seconds are published
+  // with MODE_REQUEST_ERROR, as the RMF robot state has no field to flag
+  // them as stale, and requests for them are ignored, 0 or less to never
+  // mark robots as stale
+  double robot_stale_timeout = 5.0;
+
+  // robots that did not send an update for this many seconds are removed,
+  // making room for new robots, 0 or less to never remove robots
+  double robot_evict_timeout = 60.0;
 
   double update_state_frequency = 10.0;
   double publish_state_frequency = 10.0;
 
+  // robot states are taken from DDS by a thread of every fleet as soon as
+  // they arrive, which also publishes the updates of single robots, leaving
+  // the executor to publish fleet states and forward requests, when disabled
+  // they are handled on the DDS listener thread instead
+  bool ingest_thread = true;
+
+  // CPU to pin the ingest thread to, -1 to leave it unpinned
+  int ingest_thread_cpu = -1;
+
+  // threads of the executor shared by every fleet of the process, 0 for one
+  // for every callback group, which publish fleet states, forward requests
+  // and poll for robot states without an ingest thread, only taken from the
+  // first fleet like the CPUs below
+  int executor_threads = 0;
+
+  // CPUs to pin the executor threads to, empty to leave them unpinned
+  std::vector<int64_t> executor_cpus;
+
+  // when enabled, fleet states are only published if a robot changed by
+  // more than the thresholds below since the last fleet state, or when a
+  // full keyframe is due, keyframes have to be due at a positive frequency,
+  // any other value is replaced with the default of 1 Hz
+  bool publish_changes_only = false;
+  double keyframe_frequency = 1.0;
+
+  // robots that changed by more than the thresholds below are also
+  // published as soon as their state arrives, each in a fleet state of its
+  // own on this topic, disabled if empty
+  std::string fleet_state_update_topic = "";
+
+  // thresholds in the frame of the fleet, in meters, radians and percent,
+  // any change of mode, task, level or path is always significant
+  double position_epsilon = 0.01;
+  double yaw_epsilon = 0.01;
+  double battery_epsilon = 1.0;
+
   // the transformation order of operations from the server to the client is:
   // 1) scale
   // 2) rotate
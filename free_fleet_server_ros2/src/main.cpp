@@ -15,10 +15,16 @@
  *
  */
 
+#include <string>
+#include <vector>
 #include <iostream>
+#include <algorithm>
+
+#include <pthread.h>
 
 #include <rclcpp/rclcpp.hpp>
 
+#include "utilities.hpp"
 #include "ServerNode.hpp"
 
 
@@ -27,17 +33,71 @@ int main(int argc, char** argv)
   rclcpp::init(argc, argv);
   std::cout << "Greetings from free_fleet_server_ros2" << std::endl;
 
-  free_fleet::ros2::ServerNodeConfig server_node_config =
-      free_fleet::ros2::ServerNodeConfig::make();
-  server_node_config.fleet_name = "free_fleet_server_ros2";
+  // Several fleets can be served from this process, sharing a single DDS
+  // participant, by listing them in the fleet_names parameter. Each fleet
+  // then reads its own parameters under the node <fleet_name>_node.
+  std::vector<std::string> fleet_names;
+  {
+    auto fleets_node = rclcpp::Node::make_shared(
+        "free_fleet_server_ros2_fleets",
+        rclcpp::NodeOptions()
+            .allow_undeclared_parameters(true)
+            .automatically_declare_parameters_from_overrides(true));
+    fleets_node->get_parameter("fleet_names", fleet_names);
+  }
+
+  std::vector<free_fleet::ros2::ServerNode::SharedPtr> server_nodes;
+  if (fleet_names.empty())
+  {
+    free_fleet::ros2::ServerNodeConfig server_node_config =
+        free_fleet::ros2::ServerNodeConfig::make();
+    server_node_config.fleet_name = "free_fleet_server_ros2";
+
+    auto server_node = free_fleet::ros2::ServerNode::make(server_node_config);
+    if (!server_node)
+      return 1;
+    server_nodes.push_back(std::move(server_node));
+  }
+  else
+  {
+    std::vector<free_fleet::ros2::ServerNodeConfig> server_node_configs;
+    for (const auto& fleet_name : fleet_names)
+    {
+      free_fleet::ros2::ServerNodeConfig server_node_config =
+          free_fleet::ros2::ServerNodeConfig::make();
+      server_node_config.fleet_name = fleet_name;
+      server_node_config.dds_robot_state_topic = fleet_name + "_robot_state";
+      server_node_configs.push_back(server_node_config);
+    }
+
+    server_nodes = free_fleet::ros2::ServerNode::make(server_node_configs);
+    if (server_nodes.empty())
+      return 1;
+  }
 
-  auto server_node = free_fleet::ros2::ServerNode::make(server_node_config);
-  if (!server_node)
-    return 1;
+  // Every fleet has a callback group for publishing and another for
+  // requests, and one more for polling robot states without an ingest
+  // thread. The executor threads are started by spin, inheriting the CPUs
+  // of this thread.
+  const free_fleet::ros2::ServerNodeConfig& config =
+      server_nodes.front()->get_config();
+  std::size_t num_threads =
+      static_cast<std::size_t>(std::max(config.executor_threads, 0));
+  if (num_threads == 0)
+  {
+    for (const auto& server_node : server_nodes)
+      num_threads += server_node->get_config().ingest_thread ? 2 : 3;
+  }
+  if (!config.executor_cpus.empty() &&
+      !free_fleet::ros2::set_cpu_affinity(
+          pthread_self(), config.executor_cpus))
+    std::cout << "unable to pin the executor threads to the executor cpus."
+        << std::endl;
 
   rclcpp::executors::MultiThreadedExecutor executor {
-      rclcpp::ExecutorOptions(), 2};
-  executor.add_node(server_node);
+      rclcpp::ExecutorOptions(), num_threads};
+  for (const auto& server_node : server_nodes)
+    executor.add_node(server_node);
   executor.spin();
 
   rclcpp::shutdown();
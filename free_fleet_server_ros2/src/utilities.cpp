@@ -15,6 +15,8 @@
  *
  */
 
+#include <pthread.h>
+
 #include "utilities.hpp"
 
 namespace free_fleet
@@ -104,5 +106,21 @@ void to_ros_message(
   }
 }
 
+// ----------------------------------------------------------------------------
+
+bool set_cpu_affinity(
+    std::thread::native_handle_type _thread, const std::vector<int64_t>& _cpus)
+{
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int64_t cpu : _cpus)
+  {
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+      return false;
+    CPU_SET(static_cast<int>(cpu), &cpu_set);
+  }
+  return pthread_setaffinity_np(_thread, sizeof(cpu_set), &cpu_set) == 0;
+}
+
 } // namespace ros2
 } // namespace free_fleet
@@ -18,6 +18,10 @@
 #ifndef FREE_FLEET_SERVER_ROS2__SRC__UTILITIES_HPP
 #define FREE_FLEET_SERVER_ROS2__SRC__UTILITIES_HPP
 
+#include <thread>
+#include <vector>
+#include <cstdint>
+
 #include <rmf_fleet_msgs/msg/location.hpp>
 #include <rmf_fleet_msgs/msg/robot_state.hpp>
 #include <rmf_fleet_msgs/msg/mode_request.hpp>
@@ -60,6 +64,13 @@ void to_ros_message(
     const messages::RobotState& in_msg,
     rmf_fleet_msgs::msg::RobotState& out_msg);
 
+// ----------------------------------------------------------------------------
+
+/// Pins a thread to the given CPUs, threads it starts later inherit them.
+/// Returns false if a CPU does not exist or the thread could not be pinned.
+bool set_cpu_affinity(
+    std::thread::native_handle_type thread, const std::vector<int64_t>& cpus);
+
 } // namespace ros2
 } // namespace free_fleet
 